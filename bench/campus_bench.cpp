@@ -0,0 +1,283 @@
+// campus_bench: how fast is each part of the app on campuses from 100 to 1,000,000 rooms?
+//
+//   campus_bench [--sizes 100,1000,10000,100000,1000000] [--queries 1000] [--seed 1]
+//                [--threads N] [--no-scene] [--out results.json]
+//
+// For every size a synthetic campus is generated (see SyntheticCampus.h), written to a CSV in
+// the temp directory and then measured:
+//   load            CampusGis::loadMapData on that CSV (parse + graph + location tree + snapshot)
+//   graph build     Graph::addEdge for every path, and GraphSnapshot::build on the result
+//   location tree   LocationTree::addLocation for every room name, then finish()
+//   single queries  the same random room pairs on every engine (map Dijkstra, CSR Dijkstra,
+//                   full shortest-path tree); distances are cross-checked
+//   batch queries   CampusGis::findRoutesAsync over all workers
+//   scene           recording one building's floors into FloorTileLayers and rendering them once
+// Results are written as JSON so runs can be compared over time.
+#include "../include/core/CampusGis.h"
+#include "../include/core/SyntheticCampus.h"
+#include "../include/gui/FloorTileLayer.h"
+#include <QApplication>
+#include <QDir>
+#include <QGraphicsScene>
+#include <QImage>
+#include <QPainter>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+double msSince(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+// Mean and percentiles of a list of per-query times (in microseconds)
+string latencyJson(vector<double> micros) {
+    if (micros.empty()) return "null";
+    sort(micros.begin(), micros.end());
+    double total = 0;
+    for (double m : micros) total += m;
+    auto at = [&](double p) { return micros[min(micros.size() - 1, static_cast<size_t>(p * (micros.size() - 1) + 0.5))]; };
+    char text[256];
+    snprintf(text, sizeof(text), "{\"count\":%zu,\"mean_us\":%.2f,\"p50_us\":%.2f,\"p90_us\":%.2f,\"p99_us\":%.2f,\"max_us\":%.2f}",
+             micros.size(), total / micros.size(), at(0.50), at(0.90), at(0.99), micros.back());
+    return text;
+}
+
+// Times 'search' once per query pair and returns the distances it found
+template <typename Search>
+vector<int> timeQueries(const vector<pair<string, string>>& queries, vector<double>& micros, Search search) {
+    vector<int> distances;
+    for (const auto& q : queries) {
+        auto start = Clock::now();
+        distances.push_back(search(q.first, q.second));
+        micros.push_back(chrono::duration<double, micro>(Clock::now() - start).count());
+    }
+    return distances;
+}
+
+// Draws one building's floors the way MainWindow::drawFloorSchematic does (hallways, room boxes,
+// labels into a FloorTileLayer), then renders every layer once at 100% zoom
+string benchScene(const SyntheticCampus& campus) {
+    map<string, vector<const pair<string, MapPosition>*>> floors;  // "B1-G" -> rooms on that floor
+    map<string, MapPosition> positions;
+    for (const auto& node : campus.nodes) {
+        positions[node.first] = node.second;
+        if (node.first.compare(0, 3, "B1-") != 0) continue;
+        floors[node.first.substr(0, node.first.find('-', 3))].push_back(&node);
+    }
+
+    auto start = Clock::now();
+    vector<QGraphicsScene*> scenes;
+    size_t primitives = 0;
+    for (const auto& floor : floors) {
+        string prefix = floor.first + "-";
+        QRectF bounds;
+        for (const auto* node : floor.second) bounds |= QRectF(node->second.x - 40, node->second.y - 40, 80, 80);
+
+        auto* scene = new QGraphicsScene(bounds);
+        auto* layer = new FloorTileLayer(bounds, QColor(245, 245, 250));
+        for (const MapEdgeRecord& edge : campus.edges) {
+            if (edge.from.compare(0, prefix.size(), prefix) != 0 || edge.to.compare(0, prefix.size(), prefix) != 0) continue;
+            const MapPosition& a = positions[edge.from];
+            const MapPosition& b = positions[edge.to];
+            layer->addLine(QLineF(a.x, a.y, b.x, b.y), QPen(QColor(200, 200, 200), 6));
+            ++primitives;
+        }
+        QFont font("Arial", 7);
+        for (const auto* node : floor.second) {
+            QPointF center(node->second.x, node->second.y);
+            if (node->first.find("Hall") != string::npos) {
+                layer->addEllipse(QRectF(center.x() - 4, center.y() - 4, 8, 8), Qt::NoPen, QBrush(Qt::gray), FloorTileLayer::Detail::Fine);
+                ++primitives;
+                continue;
+            }
+            layer->addRect(QRectF(center.x() - 20, center.y() - 15, 40, 30), QPen(Qt::black, 1), QBrush(QColor(52, 152, 219)),
+                           FloorTileLayer::Detail::Rooms);
+            layer->addLabel(QString::fromStdString(node->first.substr(prefix.size())), center, font);
+            primitives += 2;
+        }
+        layer->aggregateRoomBlocks(QBrush(QColor(200, 200, 200)));
+        scene->addItem(layer);
+        scenes.push_back(scene);
+    }
+    double buildMs = msSince(start);
+
+    // Paint every scene once, which renders (and caches) all of its tiles
+    start = Clock::now();
+    for (QGraphicsScene* scene : scenes) {
+        QRectF area = scene->sceneRect();
+        QImage image(area.size().toSize().boundedTo(QSize(8192, 8192)), QImage::Format_ARGB32_Premultiplied);
+        QPainter painter(&image);
+        scene->render(&painter, QRectF(image.rect()), area);
+    }
+    double renderMs = msSince(start);
+
+    for (QGraphicsScene* scene : scenes) delete scene;
+
+    char text[256];
+    snprintf(text, sizeof(text), "{\"floors\":%zu,\"primitives\":%zu,\"build_ms\":%.2f,\"render_ms\":%.2f}",
+             floors.size(), primitives, buildMs, renderMs);
+    return text;
+}
+
+string benchSize(size_t size, size_t queryCount, unsigned seed, unsigned threads, bool withScene) {
+    ostringstream json;
+    json.setf(ios::fixed);
+    json.precision(2);
+
+    auto start = Clock::now();
+    SyntheticCampus campus = generateSyntheticCampus(size, seed);
+    double generateMs = msSince(start);
+
+    string csvPath = QDir::temp().filePath(QString("campus_bench_%1.csv").arg(size)).toStdString();
+    {
+        ofstream csv(csvPath);
+        campus.writeCsv(csv);
+    }
+
+    // Full load through the app's own loader
+    CampusGis gis(threads);
+    start = Clock::now();
+    bool loaded = gis.loadMapData(csvPath);
+    double loadMs = msSince(start);
+    remove(csvPath.c_str());
+    if (!loaded) return "";
+
+    // The individual building steps
+    start = Clock::now();
+    Graph graph;
+    for (const MapEdgeRecord& edge : campus.edges) graph.addEdge(edge.from, edge.to, edge.weight);
+    double graphMs = msSince(start);
+
+    start = Clock::now();
+    auto snapshot = GraphSnapshot::build(graph, {}, 1);
+    double snapshotMs = msSince(start);
+
+    start = Clock::now();
+    LocationTree tree;
+    for (const auto& node : campus.nodes) tree.addLocation(node.first);
+    tree.finish();
+    double treeMs = msSince(start);
+
+    // Same random pairs for every engine. The map-based Dijkstra gets slow on huge campuses,
+    // so fewer queries are timed there (but always at least 10).
+    vector<string> names = graph.getNodes();
+    mt19937 random(seed);
+    uniform_int_distribution<size_t> pick(0, names.size() - 1);
+    size_t singleCount = max<size_t>(10, min<size_t>(queryCount, queryCount * 10000 / max<size_t>(size, 1)));
+    vector<pair<string, string>> queries;
+    for (size_t i = 0; i < max(singleCount, queryCount); ++i) queries.push_back({names[pick(random)], names[pick(random)]});
+    vector<pair<string, string>> singleQueries(queries.begin(), queries.begin() + singleCount);
+
+    vector<double> mapMicros, csrMicros, treeMicros;
+    vector<int> mapDistances = timeQueries(singleQueries, mapMicros, [&](const string& a, const string& b) {
+        return graph.dijkstra(a, b).second;
+    });
+    vector<int> csrDistances = timeQueries(singleQueries, csrMicros, [&](const string& a, const string& b) {
+        return snapshot->dijkstra(a, b).second;
+    });
+    vector<pair<string, string>> treeQueries(singleQueries.begin(), singleQueries.begin() + min<size_t>(singleCount, 20));
+    vector<int> treeDistances = timeQueries(treeQueries, treeMicros, [&](const string& a, const string& b) {
+        return snapshot->shortestPathTree(a).pathTo(b).second;
+    });
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < singleCount; ++i) {
+        if (mapDistances[i] != csrDistances[i]) ++mismatches;
+        if (i < treeDistances.size() && treeDistances[i] != mapDistances[i]) ++mismatches;
+    }
+
+    // Batch: everything at once over the worker pool
+    vector<RouteRequest> requests;
+    for (size_t i = 0; i < queryCount; ++i) requests.push_back({queries[i].first, "", queries[i].second});
+    start = Clock::now();
+    vector<RouteResult> results = gis.findRoutesAsync(requests, CampusGis::makeCancelToken()).get();
+    double batchMs = msSince(start);
+
+    json << "{\"target_nodes\":" << size << ",\"nodes\":" << campus.nodes.size() << ",\"edges\":" << campus.edges.size()
+         << ",\"generate_ms\":" << generateMs << ",\"load_ms\":" << loadMs
+         << ",\"graph_build_ms\":" << graphMs << ",\"snapshot_build_ms\":" << snapshotMs
+         << ",\"location_tree\":{\"total_ms\":" << treeMs
+         << ",\"ns_per_add\":" << treeMs * 1e6 / max<size_t>(campus.nodes.size(), 1) << "}"
+         << ",\"dijkstra_map\":" << latencyJson(mapMicros)
+         << ",\"dijkstra_csr\":" << latencyJson(csrMicros)
+         << ",\"shortest_path_tree\":" << latencyJson(treeMicros)
+         << ",\"distance_mismatches\":" << mismatches
+         << ",\"batch\":{\"queries\":" << results.size() << ",\"wall_ms\":" << batchMs
+         << ",\"qps\":" << (batchMs > 0 ? results.size() * 1000.0 / batchMs : 0.0) << "}";
+    if (withScene) json << ",\"scene\":" << benchScene(campus);
+    json << "}";
+    return json.str();
+}
+
+vector<size_t> parseSizes(const string& text) {
+    vector<size_t> sizes;
+    stringstream list(text);
+    string item;
+    while (getline(list, item, ',')) {
+        if (!item.empty()) sizes.push_back(static_cast<size_t>(stoull(item)));
+    }
+    return sizes;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    // Scene benchmarks need a QApplication but never show a window
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    vector<size_t> sizes = {100, 1000, 10000, 100000, 1000000};
+    size_t queries = 1000;
+    unsigned seed = 1;
+    unsigned threads = 0;
+    bool withScene = true;
+    string outFile;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--sizes" && hasValue) sizes = parseSizes(argv[++i]);
+        else if (arg == "--queries" && hasValue) queries = max<size_t>(1, stoull(argv[++i]));
+        else if (arg == "--seed" && hasValue) seed = static_cast<unsigned>(stoul(argv[++i]));
+        else if (arg == "--threads" && hasValue) threads = static_cast<unsigned>(stoul(argv[++i]));
+        else if (arg == "--no-scene") withScene = false;
+        else if (arg == "--out" && hasValue) outFile = argv[++i];
+        else {
+            fprintf(stderr, "usage: campus_bench [--sizes 100,1000,...] [--queries N] [--seed N] [--threads N] [--no-scene] [--out FILE]\n");
+            return 2;
+        }
+    }
+
+    ostringstream json;
+    json << "{\"benchmark\":\"campus_bench\",\"seed\":" << seed << ",\"queries\":" << queries
+         << ",\"threads\":" << (threads ? threads : max(1u, thread::hardware_concurrency())) << ",\"results\":[";
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        fprintf(stderr, "campus_bench: %zu rooms...\n", sizes[i]);
+        string result = benchSize(sizes[i], queries, seed, threads, withScene);
+        if (result.empty()) {
+            fprintf(stderr, "campus_bench: could not load the generated campus\n");
+            return 1;
+        }
+        json << (i ? "," : "") << result;
+    }
+    json << "]}\n";
+
+    if (outFile.empty()) {
+        cout << json.str();
+    } else {
+        ofstream(outFile) << json.str();
+    }
+    return 0;
+}
@@ -0,0 +1,536 @@
+// campus_verify: do all of our shortest-path engines give the same answers?
+//
+//   campus_verify [--cases 500] [--max-nodes 40] [--queries 30] [--seed 1]
+//
+// Every case is a small random map that uses the real naming style ("EE-1-Room-7", "CS-G-Hall-3"),
+// built with Graph::addEdge. Some cases have parallel hallways, zero-length hallways, loops,
+// several disconnected parts and a few closed hallways. Random room pairs (sometimes with a via
+// room, sometimes with a name that isn't on the map) are then sent to every engine:
+//   graph dijkstra         Graph::dijkstra on the map as loaded
+//   graph tree             Graph::shortestPathTree + pathTo
+//   snapshot dijkstra      GraphSnapshot::dijkstra (without and with the closed hallways)
+//   snapshot tree          GraphSnapshot::shortestPathTree + pathTo (same two maps)
+//   campus route           CampusGis::findRoute after loading the map from a CSV file and
+//                          closing the hallways through setHallwayClosed (plus via routes)
+//   campus prefetched      the same after prefetchFrom, so the answer comes from a cached tree
+//   campus batch           CampusGis::findRoutesAsync with all the queries at once
+//   campus packed          CampusGis::loadPackedMap on the map packed by PackedMapStorage (what
+//                          campus_embed compiles in), then with the hallways closed
+//   campus image           CampusGis::attachGraphImage on the same map written by GraphImage::write,
+//                          then with the hallways closed (which repacks the mapped arrays)
+//   campus warm            CampusGis::findRoute with a map cache: the map is loaded twice, so the
+//                          second run answers from the remembered routes (then with the hallways
+//                          closed, and again after they are opened)
+// Every answer is compared with a brute-force answer (Floyd-Warshall over the whole map), and
+// every path must start and end at the right rooms, only use open hallways and add up to the
+// reported distance.
+//
+// When a case fails it is shrunk: queries, hallways and closures are removed, rooms joined by a
+// hallway are merged and lengths set to 1 for as long as it keeps failing, and the smallest
+// failing map is printed.
+// New engines only need one more check() line in checkCase().
+//
+// Before the cases, the snapshot store (GraphSnapshotStore) is hammered by more reader threads than
+// it has reader slots while two threads keep publishing new snapshots. Every reader checks that the
+// snapshot it pinned is still intact; build with -fsanitize=address or thread to catch the rest.
+#include "../include/core/CampusGis.h"
+#include "../include/core/GraphImage.h"
+#include <QDir>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+using namespace std;
+
+namespace {
+
+struct Query {
+    string source;
+    string via;   // Empty = direct route
+    string dest;
+};
+
+// One random map plus the questions we ask about it
+struct TestCase {
+    vector<MapEdgeRecord> edges;
+    vector<pair<string, string>> closed;
+    vector<Query> queries;
+};
+
+// What went wrong, for the report
+struct Failure {
+    string engine;
+    Query query;
+    string problem;
+};
+
+// ====================================================================
+// == RANDOM CASES
+// ====================================================================
+
+TestCase randomCase(mt19937& random, int maxNodes, int queryCount) {
+    static const char* const kBuildings[] = { "EE", "CS", "BB" };
+    static const char* const kFloors[] = { "G", "1", "2" };
+    static const char* const kKinds[] = { "Room", "Lab", "Hall" };
+    auto pick = [&](int n) { return uniform_int_distribution<int>(0, n - 1)(random); };
+
+    TestCase test;
+    int nodeCount = 2 + pick(max(1, maxNodes - 1));
+    vector<string> names;
+    for (int i = 0; i < nodeCount; ++i) {
+        names.push_back(string(kBuildings[pick(3)]) + "-" + kFloors[pick(3)] + "-" + kKinds[pick(3)] + "-" + to_string(i + 1));
+    }
+
+    // Short hallways are common, zero-length ones (doorways) happen now and then
+    auto weight = [&]() { return pick(10) == 0 ? 0 : 1 + pick(20); };
+
+    // A random tree keeps most rooms connected; skipping some links leaves separate parts
+    bool splitMap = pick(4) == 0;
+    for (int i = 1; i < nodeCount; ++i) {
+        if (splitMap && pick(5) == 0) continue;
+        test.edges.push_back({names[i], names[pick(i)], weight()});
+    }
+    int extraEdges = pick(2 * nodeCount + 1);
+    for (int i = 0; i < extraEdges; ++i) {
+        const string& from = names[pick(nodeCount)];
+        const string& to = pick(20) == 0 ? from : names[pick(nodeCount)];  // The odd loop back to the same room
+        test.edges.push_back({from, to, weight()});
+    }
+    if (test.edges.empty()) test.edges.push_back({names[0], names[1], weight()});
+
+    // Close a few hallways (this closes every parallel hallway between the same two rooms)
+    int closures = pick(3) == 0 ? pick(4) : 0;
+    for (int i = 0; i < closures; ++i) {
+        const MapEdgeRecord& edge = test.edges[pick(static_cast<int>(test.edges.size()))];
+        test.closed.push_back({edge.from, edge.to});
+    }
+
+    // Only rooms that have a hallway exist on the map; now and then ask for one that doesn't
+    set<string> onMap;
+    for (const MapEdgeRecord& edge : test.edges) {
+        onMap.insert(edge.from);
+        onMap.insert(edge.to);
+    }
+    vector<string> rooms(onMap.begin(), onMap.end());
+    auto anyRoom = [&]() { return pick(25) == 0 ? string("EE-9-Room-999") : rooms[pick(static_cast<int>(rooms.size()))]; };
+    for (int i = 0; i < queryCount; ++i) {
+        Query query{anyRoom(), "", anyRoom()};
+        if (pick(4) == 0) query.via = anyRoom();
+        test.queries.push_back(query);
+    }
+    return test;
+}
+
+// ====================================================================
+// == BRUTE-FORCE ANSWERS
+// ====================================================================
+
+// All-pairs distances by Floyd-Warshall. Slow, but simple enough to trust.
+class Oracle {
+public:
+    Oracle(const vector<MapEdgeRecord>& edges, const set<pair<string, string>>& closed) {
+        for (const MapEdgeRecord& edge : edges) {
+            ids.insert({edge.from, static_cast<int>(ids.size())});
+            ids.insert({edge.to, static_cast<int>(ids.size())});
+        }
+        int n = static_cast<int>(ids.size());
+        dist.assign(n, vector<long long>(n, kUnreachable));
+        for (int i = 0; i < n; ++i) dist[i][i] = 0;
+        for (const MapEdgeRecord& edge : edges) {
+            auto key = edge.from < edge.to ? make_pair(edge.from, edge.to) : make_pair(edge.to, edge.from);
+            if (closed.count(key)) continue;
+
+            // Parallel hallways: only the shortest one matters
+            auto found = hallways.find(key);
+            if (found == hallways.end() || edge.weight < found->second) hallways[key] = edge.weight;
+            int a = ids[edge.from], b = ids[edge.to];
+            dist[a][b] = min<long long>(dist[a][b], edge.weight);
+            dist[b][a] = dist[a][b];
+        }
+        for (int k = 0; k < n; ++k)
+            for (int i = 0; i < n; ++i)
+                for (int j = 0; j < n; ++j)
+                    if (dist[i][k] + dist[k][j] < dist[i][j]) dist[i][j] = dist[i][k] + dist[k][j];
+    }
+
+    // -1 if either room is unknown or there is no path (same rule as the engines)
+    int distance(const string& from, const string& to) const {
+        auto a = ids.find(from), b = ids.find(to);
+        if (a == ids.end() || b == ids.end() || dist[a->second][b->second] >= kUnreachable) return -1;
+        return static_cast<int>(dist[a->second][b->second]);
+    }
+
+    // A route with a via room, as CampusGis::findRoute defines it
+    int distance(const Query& query) const {
+        if (query.via.empty() || query.via == query.source || query.via == query.dest) return distance(query.source, query.dest);
+        int first = distance(query.source, query.via), second = distance(query.via, query.dest);
+        return first == -1 || second == -1 ? -1 : first + second;
+    }
+
+    // Length of the shortest open hallway between two rooms (-1 if there is none)
+    int hallway(const string& a, const string& b) const {
+        auto found = hallways.find(a < b ? make_pair(a, b) : make_pair(b, a));
+        return found == hallways.end() ? -1 : found->second;
+    }
+
+private:
+    static constexpr long long kUnreachable = 1LL << 40;
+    map<string, int> ids;
+    vector<vector<long long>> dist;
+    map<pair<string, string>, int> hallways;
+};
+
+// Empty if 'path' is a correct answer for 'query', otherwise what is wrong with it
+string checkAnswer(const Oracle& oracle, const Query& query, const vector<string>& path, int distance) {
+    int expected = oracle.distance(query);
+    if (distance != expected) return "distance " + to_string(distance) + ", expected " + to_string(expected);
+    if (expected == -1) return path.empty() ? "" : "no route exists, but a path was returned";
+
+    if (path.empty() || path.front() != query.source || path.back() != query.dest) return "path has the wrong ends";
+    long long walked = 0;
+    for (size_t i = 0; i + 1 < path.size(); ++i) {
+        int length = oracle.hallway(path[i], path[i + 1]);
+        if (length == -1) return "path uses a missing or closed hallway " + path[i] + " -> " + path[i + 1];
+        walked += length;
+    }
+    if (walked != distance) return "path is " + to_string(walked) + " long, but the reported distance is " + to_string(distance);
+    if (!query.via.empty() && find(path.begin(), path.end(), query.via) == path.end()) return "path skips the via room";
+    return "";
+}
+
+// ====================================================================
+// == RUNNING EVERY ENGINE
+// ====================================================================
+
+// The map cache used by "campus warm" (emptied before and after a run)
+string cacheDirectory() {
+    return QDir::temp().filePath("campus_verify_cache").toStdString();
+}
+
+// Removes the generated map file however checkCase() returns
+struct TempFile {
+    string path;
+    ~TempFile() { remove(path.c_str()); }
+};
+
+// Runs one case through every engine; returns the first wrong answer (if any)
+bool checkCase(const TestCase& test, CampusGis& gis, Failure& failure) {
+    set<pair<string, string>> closed;
+    for (const auto& hallway : test.closed) {
+        closed.insert(hallway.first < hallway.second ? hallway : make_pair(hallway.second, hallway.first));
+    }
+    Oracle openOracle(test.edges, {});
+    Oracle closedOracle(test.edges, closed);
+
+    Graph graph;
+    for (const MapEdgeRecord& edge : test.edges) graph.addEdge(edge.from, edge.to, edge.weight);
+    auto openSnapshot = GraphSnapshot::build(graph, {}, 1);
+    auto closedSnapshot = GraphSnapshot::build(graph, closed, 2);
+
+    // Load the same map through the app's own loader, then close the hallways one by one
+    TempFile csvFile{QDir::temp().filePath("campus_verify.csv").toStdString()};
+    const string& csvPath = csvFile.path;
+    {
+        ofstream csv(csvPath);
+        csv << "SECTION 2: EDGES\n";
+        for (const MapEdgeRecord& edge : test.edges) csv << edge.from << ", " << edge.to << ", " << edge.weight << '\n';
+    }
+    if (!gis.loadMapData(csvPath)) {
+        failure = {"campus route", {}, "could not load the generated map"};
+        return false;
+    }
+    for (const auto& hallway : test.closed) gis.setHallwayClosed(hallway.first, hallway.second, true).get();
+
+    auto check = [&](const char* engine, const Oracle& oracle, const Query& query, const pair<vector<string>, int>& answer) {
+        string problem = checkAnswer(oracle, query, answer.first, answer.second);
+        if (!problem.empty()) failure = {engine, query, problem};
+        return problem.empty();
+    };
+
+    // Engines that only know direct routes
+    for (const Query& q : test.queries) {
+        Query direct{q.source, "", q.dest};
+        if (!check("graph dijkstra", openOracle, direct, graph.dijkstra(q.source, q.dest))) return false;
+        if (!check("graph tree", openOracle, direct, graph.shortestPathTree(q.source).pathTo(q.dest))) return false;
+        if (!check("snapshot dijkstra", openOracle, direct, openSnapshot->dijkstra(q.source, q.dest))) return false;
+        if (!check("snapshot tree", openOracle, direct, openSnapshot->shortestPathTree(q.source).pathTo(q.dest))) return false;
+        if (!check("snapshot dijkstra (closures)", closedOracle, direct, closedSnapshot->dijkstra(q.source, q.dest))) return false;
+        if (!check("snapshot tree (closures)", closedOracle, direct,
+                   closedSnapshot->shortestPathTree(q.source).pathTo(q.dest))) return false;
+    }
+
+    // The app's own route search, with via rooms and closed hallways
+    auto routeAnswer = [](const RouteResult& r) { return make_pair(r.path, r.distance); };
+    auto checkRoutes = [&](const char* engine, const Oracle& oracle, CampusGis& engineGis) {
+        for (const Query& q : test.queries) {
+            if (!check(engine, oracle, q, routeAnswer(engineGis.findRoute({q.source, q.via, q.dest})))) return false;
+        }
+        return true;
+    };
+    auto closeAll = [&](CampusGis& engineGis, bool closedNow) {
+        for (const auto& hallway : test.closed) engineGis.setHallwayClosed(hallway.first, hallway.second, closedNow).get();
+    };
+    for (const Query& q : test.queries) {
+        if (!check("campus route", closedOracle, q, routeAnswer(gis.findRoute({q.source, q.via, q.dest})))) return false;
+    }
+
+    // Prefetch every source, then wait for the trees that are still cached
+    for (const Query& q : test.queries) gis.prefetchFrom(q.source);
+    gis.waitForPrefetches();
+    for (const Query& q : test.queries) {
+        if (!check("campus prefetched", closedOracle, q, routeAnswer(gis.findRoute({q.source, q.via, q.dest})))) return false;
+    }
+
+    vector<RouteRequest> requests;
+    for (const Query& q : test.queries) requests.push_back({q.source, q.via, q.dest});
+    vector<RouteResult> results = gis.findRoutesAsync(requests, CampusGis::makeCancelToken()).get();
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (!check("campus batch", closedOracle, test.queries[i], routeAnswer(results[i]))) return false;
+    }
+
+    // The map packed into flat arrays, cleaned up the way the loader does it. Searches run right
+    // on the arrays until a hallway is closed; then they are packed again without it.
+    Graph cleaned = graph;
+    cleaned.removeDuplicateEdges();
+    PackedMapStorage storage;
+    storage.packGraph(cleaned, {});
+    const PackedMap& packed = storage.finish();
+
+    CampusGis packedGis(1);
+    if (!packedGis.loadPackedMap(packed)) {
+        failure = {"campus packed", {}, "could not load the packed map"};
+        return false;
+    }
+    if (!checkRoutes("campus packed", openOracle, packedGis)) return false;
+    closeAll(packedGis, true);
+    if (!checkRoutes("campus packed (closures)", closedOracle, packedGis)) return false;
+
+    // ...and the same arrays as a graph image, mapped from a file
+    TempFile imageFile{QDir::temp().filePath("campus_verify.img").toStdString()};
+    string error;
+    CampusGis imageGis(1);
+    if (!GraphImage::write(imageFile.path, packed, 0, &error) || !imageGis.attachGraphImage(imageFile.path, &error)) {
+        failure = {"campus image", {}, "could not write or attach the graph image: " + error};
+        return false;
+    }
+    if (!checkRoutes("campus image", openOracle, imageGis)) return false;
+    closeAll(imageGis, true);
+    if (!checkRoutes("campus image (closures)", closedOracle, imageGis)) return false;
+
+    // The same map loaded twice through a map cache: the legs asked for on the first load are
+    // saved, and the second load (a cache hit) answers them from memory
+    CampusGis warm(1);
+    warm.setCacheDirectory(cacheDirectory());
+    for (int run = 0; run < 2; ++run) {
+        if (!warm.loadMapData(csvPath)) {
+            failure = {"campus warm", {}, "could not load the generated map"};
+            return false;
+        }
+        if (!checkRoutes("campus warm", openOracle, warm)) return false;
+    }
+    if (!warm.loadedFromCache()) {
+        failure = {"campus warm", {}, "the second load didn't come from the map cache"};
+        return false;
+    }
+    // Remembered routes must not answer while a hallway is closed, and work again once it opens
+    closeAll(warm, true);
+    if (!checkRoutes("campus warm (closures)", closedOracle, warm)) return false;
+    closeAll(warm, false);
+    return checkRoutes("campus warm (reopened)", openOracle, warm);
+}
+
+// ====================================================================
+// == SNAPSHOT STORE
+// ====================================================================
+
+// Snapshot N has one hallway, N long, so a reader can tell whether the snapshot it pinned is still
+// the one that was published (and not freed or half replaced under it)
+bool checkSnapshotStore(int readers, int publishes, string& problem) {
+    static const char* const kFrom = "EE-G-Room-1";
+    static const char* const kTo = "EE-G-Room-2";
+    auto snapshotFor = [](uint64_t version) {
+        Graph graph;
+        graph.addEdge(kFrom, kTo, static_cast<int>(version));
+        return GraphSnapshot::build(graph, {}, version);
+    };
+
+    GraphSnapshotStore store;
+    store.publish(snapshotFor(1));
+    atomic<uint64_t> nextVersion{2};
+    atomic<bool> done{false};
+    mutex problemMutex;
+    auto fail = [&](const string& why) {
+        lock_guard<mutex> lock(problemMutex);
+        if (problem.empty()) problem = why;
+        done = true;
+    };
+
+    vector<thread> threads;
+    for (int r = 0; r < readers; ++r) {
+        threads.emplace_back([&]() {
+            while (!done.load()) {
+                GraphSnapshotStore::Reader snapshot = store.read();
+                int version = static_cast<int>(snapshot->version());
+                int distance = snapshot->dijkstra(kFrom, kTo).second;
+                if (distance != version) {
+                    fail("snapshot " + to_string(version) + " has a hallway " + to_string(distance) + " long");
+                }
+            }
+        });
+    }
+    atomic<int> publishersLeft{2};
+    for (int p = 0; p < 2; ++p) {
+        threads.emplace_back([&]() {
+            uint64_t version;
+            while (!done.load() && (version = nextVersion++) <= static_cast<uint64_t>(publishes)) {
+                store.publish(snapshotFor(version));
+            }
+            if (--publishersLeft == 0) done = true;
+        });
+    }
+    for (thread& t : threads) t.join();
+    return problem.empty();
+}
+
+// ====================================================================
+// == SHRINKING
+// ====================================================================
+
+// Makes a failing case as small as possible while it still fails in the same engine
+TestCase shrink(TestCase test, CampusGis& gis, Failure& failure) {
+    string engine = failure.engine;
+    auto stillFails = [&](const TestCase& candidate) {
+        Failure found;
+        if (checkCase(candidate, gis, found) || found.engine != engine) return false;
+        failure = found;
+        return true;
+    };
+
+    // Only the query that failed (some failures need the queries before it, e.g. to fill a cache;
+    // those are shrunk with the other lists below)
+    TestCase single = test;
+    single.queries = {{failure.query.source, failure.query.via, failure.query.dest}};
+    if (stillFails(single)) test = single;
+
+    // Remove ever smaller chunks of a list for as long as the case keeps failing
+    auto shrinkList = [&](auto member) {
+        auto& list = test.*member;
+        for (size_t chunk = max<size_t>(1, list.size() / 2); chunk > 0; chunk /= 2) {
+            for (size_t start = 0; start < list.size();) {
+                TestCase candidate = test;
+                auto& items = candidate.*member;
+                items.erase(items.begin() + start, items.begin() + min(items.size(), start + chunk));
+                if (stillFails(candidate)) test = candidate;
+                else start += chunk;
+            }
+        }
+    };
+
+    // Merge the two rooms of a hallway into one (shortens long chains that removing can't)
+    auto mergeRooms = [&]() {
+        for (size_t i = 0; i < test.edges.size(); ++i) {
+            string keep = test.edges[i].from, gone = test.edges[i].to;
+            if (keep == gone) continue;
+            TestCase candidate = test;
+            candidate.edges.erase(candidate.edges.begin() + i);
+            auto rename = [&](string& room) { if (room == gone) room = keep; };
+            for (MapEdgeRecord& edge : candidate.edges) { rename(edge.from); rename(edge.to); }
+            for (auto& hallway : candidate.closed) { rename(hallway.first); rename(hallway.second); }
+            for (Query& q : candidate.queries) { rename(q.source); rename(q.via); rename(q.dest); }
+            if (stillFails(candidate)) test = candidate;
+        }
+    };
+
+    bool changed = true;
+    while (changed) {
+        size_t before = test.edges.size() + test.closed.size() + test.queries.size();
+        shrinkList(&TestCase::queries);
+        shrinkList(&TestCase::edges);
+        shrinkList(&TestCase::closed);
+        mergeRooms();
+        changed = test.edges.size() + test.closed.size() + test.queries.size() < before;
+    }
+
+    // Simpler numbers: every hallway 1 long where that still fails
+    for (size_t i = 0; i < test.edges.size(); ++i) {
+        if (test.edges[i].weight == 1) continue;
+        TestCase candidate = test;
+        candidate.edges[i].weight = 1;
+        if (stillFails(candidate)) test = candidate;
+    }
+    return test;
+}
+
+void printCase(const TestCase& test, const Failure& failure) {
+    printf("engine:  %s\n", failure.engine.c_str());
+    printf("query:   %s -> %s%s%s\n", failure.query.source.c_str(), failure.query.dest.c_str(),
+           failure.query.via.empty() ? "" : " via ", failure.query.via.c_str());
+    printf("problem: %s\n", failure.problem.c_str());
+    printf("\nSECTION 2: EDGES\n");
+    for (const MapEdgeRecord& edge : test.edges) printf("%s, %s, %d\n", edge.from.c_str(), edge.to.c_str(), edge.weight);
+    for (const auto& hallway : test.closed) printf("# closed: %s, %s\n", hallway.first.c_str(), hallway.second.c_str());
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t cases = 500;
+    int maxNodes = 40;
+    int queries = 30;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--cases" && hasValue) cases = stoull(argv[++i]);
+        else if (arg == "--max-nodes" && hasValue) maxNodes = max(2, stoi(argv[++i]));
+        else if (arg == "--queries" && hasValue) queries = max(1, stoi(argv[++i]));
+        else if (arg == "--seed" && hasValue) seed = static_cast<unsigned>(stoul(argv[++i]));
+        else {
+            fprintf(stderr, "usage: campus_verify [--cases N] [--max-nodes N] [--queries N] [--seed N]\n");
+            return 2;
+        }
+    }
+
+    // The loader says "Successfully loaded ..." for every case; keep the output readable
+    if (qgetenv("QT_LOGGING_RULES").isEmpty()) qputenv("QT_LOGGING_RULES", "default.info=false");
+
+    // More readers than the store has slots (64), while new snapshots keep coming
+    string problem;
+    if (!checkSnapshotStore(96, 2000, problem)) {
+        printf("campus_verify: snapshot store: %s\n", problem.c_str());
+        return 1;
+    }
+
+    QDir(QString::fromStdString(cacheDirectory())).removeRecursively();
+
+    // Two workers: enough to run the async paths on other threads
+    CampusGis gis(2);
+    mt19937 random(seed);
+    for (size_t i = 0; i < cases; ++i) {
+        TestCase test = randomCase(random, maxNodes, queries);
+        Failure failure;
+        if (checkCase(test, gis, failure)) {
+            if ((i + 1) % 500 == 0) fprintf(stderr, "campus_verify: %zu cases ok\n", i + 1);
+            continue;
+        }
+
+        printf("campus_verify: case %zu (seed %u) failed; shrinking...\n\n", i + 1, seed);
+        TestCase smallest = shrink(test, gis, failure);
+        printCase(smallest, failure);
+        QDir(QString::fromStdString(cacheDirectory())).removeRecursively();
+        return 1;
+    }
+
+    QDir(QString::fromStdString(cacheDirectory())).removeRecursively();
+    printf("campus_verify: %zu cases, %zu queries each, every engine agrees\n", cases, static_cast<size_t>(queries));
+    return 0;
+}
@@ -2,30 +2,269 @@
 #define CAMPUSGIS_H
 
 #include "../graph/Graph.h"
+#include "../graph/GraphSnapshot.h"
+#include "../graph/PackedMap.h"
 #include "../trees/LocationTree.h"
+#include "LocationIndex.h"
+#include "ThreadPool.h"
+#include "TaskGraph.h"
 #include <string>
+#include <map>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <future>
+#include <functional>
+#include <list>
+#include <mutex>
+
+class MapCache;
+
+// Where a room is drawn on its map (the X, Y columns of the CSV)
+struct MapPosition {
+    double x;
+    double y;
+};
+
+// One "From, To, Weight" line of the map file
+struct MapEdgeRecord {
+    std::string from;
+    std::string to;
+    int weight;
+};
+
+// What the load-time check of the map file found (see CampusGis::kValidationStage)
+struct MapValidationReport {
+    size_t duplicateEdges = 0;         // Hallways listed more than once (only the shortest copy is kept)
+    size_t conflictingWeights = 0;     // ...of which listed with different weights
+    size_t selfLoops = 0;              // Hallways from a room back to itself (dropped)
+    int components = 0;                // Separate parts of the map (1 = every room can reach every other)
+    int largestComponent = 0;          // Rooms in the biggest part
+    std::vector<std::string> orphans;  // Rooms with a position but no hallways (can't be routed to)
+    std::vector<std::string> dangling; // Rooms with hallways but no position (would be drawn at 0,0)
+};
+
+// "Take me from A to B (optionally stopping at Via on the way)"
+struct RouteRequest {
+    std::string source;
+    std::string via;   // Empty = no intermediate stop
+    std::string dest;
+};
+
+// The answer to a RouteRequest. distance is -1 if there is no path (or it was cancelled).
+struct RouteResult {
+    std::vector<std::string> path;
+    int distance = -1;
+    bool cancelled = false;
+};
+
+// Shared flag used to ask a running search to stop
+using CancelToken = std::shared_ptr<std::atomic<bool>>;
 
 // This class is the "Boss" of the non-visual part of the app.
 class CampusGis {
 public:
-    CampusGis();
+    // 0 worker threads means "one per CPU core"
+    explicit CampusGis(unsigned workerThreads = 0);
+    ~CampusGis();
 
-    // Loads the connections (edges) from the text file into our brain.
+    // Loads the rooms (nodes) and connections (edges) from the text file into our brain.
+    // A graph image (see GraphImage.h) works too; its hallways are then searched in place.
     bool loadMapData(const std::string& filePath);
 
+    // For processes that only answer routes: maps a graph image read-only and searches it where
+    // it is, without unpacking anything. getGraph(), getNodePositions() and the location lists
+    // stay empty. Every process attached to the same image shares its memory.
+    bool attachGraphImage(const std::string& imagePath, std::string* error = nullptr);
+
+    // Keeps work between runs in 'directory' (see MapCache.h): the packed map, so a later load of
+    // the same map file maps it instead of parsing it, and the most asked-for routes, which are
+    // answered without a search until a hallway is closed. Set it before loading; empty = off.
+    void setCacheDirectory(const std::string& directory);
+    bool loadedFromCache() const { return cacheState == CacheState::Hit; }
+
+    // Writes the most asked-for routes of this map to the cache (also done on reload and exit)
+    bool saveCache();
+
+    // Same loading work, but as stages of a bigger startup pipeline:
+    //   kParseStage -> { kGraphStage -> { kValidationStage, kCacheStage }, kLocationTreeStage, kLocationIndexStage }
+    // After kParseStage, getNodePositions() is ready; check lastLoadSucceeded() after the run.
+    void addLoadStages(TaskGraph& pipeline, const std::string& filePath);
+    bool lastLoadSucceeded() const { return lastLoadOk; }
+
+    // Same stages for a map that is already packed (see PackedMap): nothing is parsed, and until a
+    // hallway is closed the searches run right on 'map'. 'owner' is kept alive while they do.
+    void addLoadStages(TaskGraph& pipeline, const PackedMap& map, std::shared_ptr<const void> owner = nullptr);
+    bool loadPackedMap(const PackedMap& map, std::shared_ptr<const void> owner = nullptr);
+
+    // The map compiled into the program by campus_embed (builds with CAMPUS_EMBEDDED_MAP),
+    // or nullptr when there is none
+    static const PackedMap* embeddedMap();
+    // True when 'filePath' holds exactly the map that was compiled in (same bytes), so it
+    // doesn't need to be parsed again
+    static bool isEmbeddedMap(const std::string& filePath);
+
+    static const char* const kParseStage;
+    static const char* const kGraphStage;
+    static const char* const kLocationTreeStage;
+    static const char* const kLocationIndexStage;
+    static const char* const kValidationStage;
+    static const char* const kCacheStage;
+
+    // The worker threads (route searches, prefetching and startup stages all share them)
+    ThreadPool& getWorkers();
+
     // Getters: Let other parts of the app (like the Window) look at the data.
+    // getGraph() is the editable map as loaded (for drawing); searches use the snapshots below.
     const Graph& getGraph() const;
     const LocationTree& getLocationTree() const;
+    const LocationIndex& getLocationIndex() const;
+    const std::map<std::string, MapPosition>& getNodePositions() const;
+    const MapValidationReport& getValidationReport() const;  // Ready after kValidationStage
+
+    // Finds a route right here on the calling thread (source -> via -> dest).
+    RouteResult findRoute(const RouteRequest& request, const std::atomic<bool>* cancel = nullptr) const;
+
+    // Same, but on a worker thread. 'progress' gets (steps done, total steps) and 'done' gets the
+    // result; both are called on the worker thread, so GUI code must forward them to its own thread.
+    std::future<RouteResult> findRouteAsync(const RouteRequest& request, CancelToken cancel,
+                                            std::function<void(size_t, size_t)> progress = {},
+                                            std::function<void(const RouteResult&)> done = {});
+
+    // Runs many requests spread over all workers. 'progress' gets (finished, total).
+    std::future<std::vector<RouteResult>> findRoutesAsync(const std::vector<RouteRequest>& requests, CancelToken cancel,
+                                                          std::function<void(size_t, size_t)> progress = {});
+
+    // Starts computing the full shortest-path tree from 'source' in the background, so that any
+    // later route from (or to) it is just a walk along the tree. Recent trees are kept in a small cache.
+    void prefetchFrom(const std::string& source);
+
+    // Waits until the prefetched trees still in that cache are computed. Don't call it from a
+    // worker job (the trees are computed by the same workers).
+    void waitForPrefetches() const;
+
+    // Pins the snapshot that searches currently run on (never blocks, even during an edit)
+    GraphSnapshotStore::Reader readGraph() const;
+
+    // Closes (or reopens) the hallway between two rooms. A new snapshot without it is built on a
+    // worker and swapped in; searches already running finish on the old one. The future gives
+    // the new snapshot version.
+    std::future<uint64_t> setHallwayClosed(const std::string& a, const std::string& b, bool closed);
+
+    // What the route searches have been doing: nodes settled, edges relaxed, heap work and
+    // latency percentiles per phase (see SearchStats.h; empty when compiled out)
+    std::string searchStatsReport() const;
+    void resetSearchStats();
+
+    // Waits for the queued searches to finish, then stops the worker threads.
+    void shutdownWorkers();
+
+    // Makes a fresh "not cancelled" token
+    static CancelToken makeCancelToken();
 
 private:
+    // Loading steps (see addLoadStages)
+    void addLoadStages(TaskGraph& pipeline, std::function<bool()> readMap);
+    void resetForLoad();
+    bool readMapFile(const std::string& filePath);  // CSV file or graph image
+    bool parseMapFile(const std::string& filePath);
+    bool unpackMap(const PackedMap& map);
+    void freezeGraph();
+    void publishSnapshot();  // Called with closureMutex held
+    void validateMap();
+    void updateCache();
+
     // Helper to organize room names after loading them.
     void buildLocationTree();
+    void buildLocationIndex();
+
+    // One leg of a route: uses a remembered leg (warmHit) or a cached tree (treeHit) when one is
+    // ready, otherwise a normal search
+    std::pair<std::vector<std::string>, int> findLeg(const GraphSnapshot& graph, const std::string& from,
+                                                     const std::string& to, const std::atomic<bool>* cancel,
+                                                     ActiveSearchProbe& probe, bool& treeHit, bool& warmHit) const;
+    std::pair<std::vector<std::string>, int> searchLeg(const GraphSnapshot& graph, const std::string& from,
+                                                       const std::string& to, const std::atomic<bool>* cancel,
+                                                       ActiveSearchProbe& probe, bool& treeHit) const;
+    std::shared_ptr<const ShortestPathTree> readyTreeFor(const std::string& source, uint64_t version) const;
 
     // The actual "Brain" holding nodes and edges.
     Graph campusGraph;
 
+    // Read-only copies of campusGraph (minus closed hallways) that the searches use
+    GraphSnapshotStore snapshots;
+    std::mutex closureMutex;  // Held while a new snapshot is built, so versions go up in order
+    GraphSnapshot::ClosedSet closedHallways;
+    uint64_t snapshotVersion = 0;
+
+    // The packed map we were loaded from (nullptr after loading a CSV file). While no hallway is
+    // closed, the snapshots search it directly instead of a copy; closures copy it, not campusGraph.
+    const PackedMap* packedBase = nullptr;
+    std::shared_ptr<const void> packedOwner;
+
     // The "Filing Cabinet" holding room names in categories.
     LocationTree locationTree;
+
+    // The rooms users can pick, already sorted into their areas
+    LocationIndex locationIndex;
+
+    // Where every room is drawn
+    std::map<std::string, MapPosition> nodePositions;
+
+    // Paths read by the parser, waiting to be turned into the graph
+    std::vector<MapEdgeRecord> pendingEdges;
+    bool lastLoadOk = false;
+    MapValidationReport validation;
+
+    // Counters for every route search (shared by all workers, lock-free)
+    mutable SearchStatsRegistry searchStats;
+
+    // Worker threads for route searches (started the first time they are needed)
+    std::unique_ptr<ThreadPool> workerPool;
+    unsigned workerCount;
+
+    // Recently prefetched trees, newest first (some may still be computing).
+    // A tree only answers searches on the snapshot version it was built from.
+    using TreeFuture = std::shared_future<std::shared_ptr<const ShortestPathTree>>;
+    struct CachedTree {
+        std::string source;
+        uint64_t version;
+        TreeFuture tree;
+    };
+    mutable std::mutex treeCacheMutex;
+    mutable std::list<CachedTree> treeCache;
+
+    // The cache folder (nullptr = none). Off: the map didn't come from a file we can fingerprint.
+    // Miss: it was parsed, and the packed copy gets written. Hit: it was mapped from the cache.
+    enum class CacheState { Off, Miss, Hit };
+    std::unique_ptr<MapCache> cache;
+    CacheState cacheState = CacheState::Off;
+    Graph::EdgeCleanup cachedCleanup;  // What the map check cleaned up when the cached map was parsed
+
+    // Route legs asked for (in this run or earlier ones), with how often. They only answer searches
+    // on a snapshot without closed hallways (warmVersion; 0 = there is none right now).
+    // Split into shards by room names, each with its own lock, so the workers rarely wait for
+    // each other; a path is shared, not copied, while the lock is held.
+    // A full shard keeps counting the legs it had no room for ('misses', cut in half whenever it
+    // fills up so old counts fade); one that gets asked for more often than the least asked-for
+    // leg takes its place.
+    struct WarmLeg {
+        uint64_t count;
+        int distance;
+        std::shared_ptr<const std::vector<std::string>> path;
+    };
+    struct WarmShard {
+        std::mutex mutex;
+        std::map<std::pair<std::string, std::string>, WarmLeg> legs;
+        std::map<std::pair<std::string, std::string>, uint64_t> misses;
+    };
+    static const size_t kWarmShards = 16;
+    WarmShard& warmShardFor(const std::string& from, const std::string& to) const;
+    void rememberLeg(WarmShard& shard, const std::string& from, const std::string& to,
+                     const std::pair<std::vector<std::string>, int>& leg) const;
+    void clearWarmLegs();
+    mutable WarmShard warmShards[kWarmShards];
+    std::atomic<uint64_t> warmVersion{0};
 };
 
 #endif // CAMPUSGIS_H
@@ -0,0 +1,84 @@
+#ifndef FLOORTILELAYER_H
+#define FLOORTILELAYER_H
+
+#include <QGraphicsItem>
+#include <QCache>
+#include <QPixmap>
+#include <QPen>
+#include <QBrush>
+#include <QFont>
+#include <vector>
+#include "../core/SpatialGrid.h"
+
+// The "printed paper map" under each floor.
+// Everything that never changes (background, hallways, room boxes, labels) is recorded here once
+// and painted into small pixmap tiles. A repaint then just copies a few tiles instead of walking
+// hundreds of separate scene items. Live items (route, person icon, room hit-boxes) sit on top.
+//
+// Level of detail: each primitive says how far the view must be zoomed in before it is drawn,
+// so a zoomed-out floor shows building blocks and hallways instead of hundreds of tiny labels.
+class FloorTileLayer : public QGraphicsItem {
+public:
+    enum class Detail {
+        Always,    // Background, hallways, images
+        Overview,  // Only when zoomed far out (rooms merged into blocks)
+        Rooms,     // Room boxes, stairs and room labels (50% zoom and closer)
+        Fine       // Hall dots and minor labels (100% zoom and closer)
+    };
+
+    FloorTileLayer(const QRectF& bounds, const QColor& background);
+
+    // Record the static drawing (call these before the layer is shown)
+    void addLine(const QLineF& line, const QPen& pen, Detail detail = Detail::Always);
+    void addRect(const QRectF& rect, const QPen& pen, const QBrush& brush, Detail detail = Detail::Always);
+    void addEllipse(const QRectF& rect, const QPen& pen, const QBrush& brush, Detail detail = Detail::Always);
+    void addLabel(const QString& text, const QPointF& center, const QFont& font, Detail detail = Detail::Rooms);
+    void addPixmap(const QRectF& rect, const QPixmap& pixmap, Detail detail = Detail::Always);
+
+    // Merge all Detail::Rooms boxes that are close together into bigger blocks,
+    // which are drawn instead of the rooms when zoomed far out
+    void aggregateRoomBlocks(const QBrush& blockBrush);
+
+    // Throw away every cached tile (needed if the recorded drawing changes)
+    void invalidateTiles();
+
+    QRectF boundingRect() const override;
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override;
+
+private:
+    enum class Shape { Line, Rect, Ellipse, Label, Pixmap };
+
+    // One recorded drawing command
+    struct Primitive {
+        Shape shape;
+        Detail detail;
+        QRectF bounds;   // Area this primitive touches (used to skip it for far-away tiles)
+        QRectF rect;
+        QLineF line;
+        QPen pen;
+        QBrush brush;
+        QString text;
+        QFont font;
+        QPixmap pixmap;
+    };
+
+    int zoomLevelFor(qreal levelOfDetail) const;
+    bool isVisibleAt(Detail detail, qreal scale) const;
+    void buildSpatialIndex() const;
+    QPixmap renderTile(const QRectF& tileRect, qreal scale) const;
+    void drawPrimitive(QPainter* painter, const Primitive& prim) const;
+
+    QRectF m_bounds;
+    QColor m_background;
+    std::vector<Primitive> m_primitives;
+
+    // Grid over the floor listing the primitives touching each cell,
+    // so a tile only looks at the primitives that can actually appear in it.
+    mutable SpatialGrid m_grid;
+    mutable bool m_indexDirty = true;
+
+    // Rendered tiles, keyed by (zoom level, row, column). Cost is counted in KB.
+    mutable QCache<quint64, QPixmap> m_tiles;
+};
+
+#endif // FLOORTILELAYER_H
@@ -0,0 +1,50 @@
+#ifndef GEOMETRYKERNELS_H
+#define GEOMETRYKERNELS_H
+
+#include <cstddef>
+#include <vector>
+
+// Many points kept as two plain arrays (all x's, then all y's) instead of one array of (x, y)
+// pairs. Loops over them read memory straight through, and the processor can work on
+// several points per instruction (see GeometryKernels).
+struct PointArrays {
+    std::vector<double> x;
+    std::vector<double> y;
+
+    size_t size() const { return x.size(); }
+    void clear() { x.clear(); y.clear(); }
+    void reserve(size_t n) { x.reserve(n); y.reserve(n); }
+    void push(double px, double py) { x.push_back(px); y.push_back(py); }
+};
+
+struct GeometryBounds {
+    double minX, minY, maxX, maxY;
+};
+
+// Batch geometry for whole maps at once: hallway lengths, map sizes, weight checks.
+// The loops use SSE2 (two doubles per instruction) where the compiler offers it,
+// and plain C++ everywhere else.
+class GeometryKernels {
+public:
+    // out[i] = straight-line distance from (ax[i], ay[i]) to (bx[i], by[i])
+    static void distances(const double* ax, const double* ay, const double* bx, const double* by,
+                          size_t count, double* out);
+
+    // Smallest box around all points; false (and 'out' untouched) when there are none
+    static bool bounds(const double* x, const double* y, size_t count, GeometryBounds& out);
+    static bool bounds(const PointArrays& points, GeometryBounds& out) {
+        return bounds(points.x.data(), points.y.data(), points.size(), out);
+    }
+
+    // Do the hallway weights of the map file match how long the hallways are drawn?
+    // The typical "drawn length per weight unit" is worked out from all hallways; hallways that
+    // are more than 'tolerance' times longer or shorter than that are reported.
+    struct WeightCheck {
+        size_t checked = 0;              // Hallways with a weight and a drawn length above 0
+        double lengthPerWeight = 0;      // The typical ratio (median)
+        std::vector<size_t> mismatches;  // Indexes of the hallways that don't fit
+    };
+    static WeightCheck checkWeights(const double* lengths, const int* weights, size_t count, double tolerance);
+};
+
+#endif // GEOMETRYKERNELS_H
@@ -5,6 +5,19 @@
 #include <vector>
 #include <map>
 #include <utility>
+#include <atomic>
+#include "SearchStats.h"
+
+// The result of one "search everything from here" run: the distance to every room we can reach
+// and who we came from. Any route that starts at 'source' is then just a walk back along the parents.
+struct ShortestPathTree {
+    std::string source;
+    std::map<std::string, int> distances;
+    std::map<std::string, std::string> parents;
+
+    // Path and distance from source to 'dest' ({{}, -1} if unreachable)
+    std::pair<std::vector<std::string>, int> pathTo(const std::string& dest) const;
+};
 
 // This class handles the math of the map.
 class Graph {
@@ -12,8 +25,30 @@ public:
     // Connects two rooms (nodes) with a specific distance (weight).
     void addEdge(const std::string& from, const std::string& to, int weight);
 
+    // What removeDuplicateEdges() cleaned up (each hallway counted once, not once per direction)
+    struct EdgeCleanup {
+        size_t duplicates = 0;          // Extra copies of a hallway that was listed more than once
+        size_t conflictingWeights = 0;  // ...of which had a different weight than the one kept
+        size_t selfLoops = 0;           // Hallways from a room back to itself
+    };
+
+    // addEdge() simply appends, so a hallway listed twice in the map file ends up twice in the
+    // adjacency list (and every search looks at it twice). This keeps only the shortest copy of
+    // each hallway and drops hallways that lead back to the same room. Rooms are never removed.
+    EdgeCleanup removeDuplicateEdges();
+
     // The "GPS" function. Finds the fastest path from Start to End.
-    std::pair<std::vector<std::string>, int> dijkstra(const std::string& start, const std::string& end) const;
+    // Returns {{}, -1} if there is no path, or if 'cancel' gets set while searching.
+    std::pair<std::vector<std::string>, int> dijkstra(const std::string& start, const std::string& end,
+                                                      const std::atomic<bool>* cancel = nullptr) const;
+
+    // Same search, reporting what it does to 'probe' (see SearchStats.h)
+    template <typename Probe>
+    std::pair<std::vector<std::string>, int> dijkstra(const std::string& start, const std::string& end,
+                                                      const std::atomic<bool>* cancel, Probe& probe) const;
+
+    // Dijkstra without a destination: finds the best path from 'start' to every room at once.
+    ShortestPathTree shortestPathTree(const std::string& start) const;
 
     // A simpler search (Breadth-First Search).
     std::vector<std::string> bfs(const std::string& start, const std::string& end) const;
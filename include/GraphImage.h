@@ -0,0 +1,56 @@
+#ifndef GRAPHIMAGE_H
+#define GRAPHIMAGE_H
+
+#include "../graph/PackedMap.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class QFile;
+
+// A PackedMap saved as one file that programs map into memory instead of reading.
+//
+// The file is a small header followed by the arrays of the PackedMap, exactly as they are in
+// memory. The header records where each array starts as an offset from the beginning of the
+// file, never as a pointer. That is why the same bytes work at any address in any process.
+// Every process that opens the image shares the same pages with the others (through the
+// operating system's file cache). An extra routing process therefore costs almost no memory,
+// and it can answer routes as soon as the file is mapped. Put the file on a RAM disk (for
+// example /dev/shm on Linux) to keep it in shared memory.
+//
+//   campus_embed --map campus_map_detailed.csv --image /dev/shm/campus.img    (once)
+//   campus_route --image /dev/shm/campus.img ...                              (any number of times)
+class GraphImage {
+public:
+    ~GraphImage();
+    GraphImage(const GraphImage&) = delete;
+    GraphImage& operator=(const GraphImage&) = delete;
+
+    // Writes 'map' to 'path'. Readers never see half a file: the image is written next to it
+    // and renamed into place at the end. 'sourceHash' says which map file it was made from.
+    static bool write(const std::string& path, const PackedMap& map, uint64_t sourceHash, std::string* error = nullptr);
+
+    // Maps the file read-only. nullptr (with the reason in 'error') if it is missing, cut short,
+    // from another format version or otherwise doesn't add up; a bad image is never searched.
+    static std::shared_ptr<const GraphImage> open(const std::string& path, std::string* error = nullptr);
+
+    // Cheap check of the first bytes, to tell an image from a CSV file
+    static bool looksLikeImage(const std::string& path);
+
+    // Points into the mapped file; valid for as long as this GraphImage lives
+    const PackedMap& map() const { return packed; }
+    uint64_t sourceHash() const { return hash; }
+    size_t sizeBytes() const { return size; }
+
+private:
+    GraphImage() = default;
+
+    std::unique_ptr<QFile> file;
+    const unsigned char* bytes = nullptr;
+    size_t size = 0;
+    uint64_t hash = 0;
+    PackedMap packed;
+};
+
+#endif // GRAPHIMAGE_H
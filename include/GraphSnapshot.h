@@ -0,0 +1,138 @@
+#ifndef GRAPHSNAPSHOT_H
+#define GRAPHSNAPSHOT_H
+
+#include "Graph.h"
+#include "PackedMap.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A frozen, read-only copy of the map that route searches run on.
+// Rooms are numbered 0..N-1 and the hallways are packed into three flat arrays (CSR):
+// the neighbors of room i are targets[offsets[i]] .. targets[offsets[i+1]-1] (see PackedMap).
+// Once built it is never changed, so any number of threads can search it at the same time.
+class GraphSnapshot {
+public:
+    // Closed hallways are stored as (smaller name, bigger name)
+    using ClosedSet = std::set<std::pair<std::string, std::string>>;
+
+    // Copies 'graph' into a new snapshot, leaving out the closed hallways
+    static std::unique_ptr<const GraphSnapshot> build(const Graph& graph, const ClosedSet& closed, uint64_t version);
+    static std::unique_ptr<const GraphSnapshot> build(const PackedMap& map, const ClosedSet& closed, uint64_t version);
+
+    // Searches 'map' right where it is (compiled into the program or mapped from a file) instead
+    // of copying it. 'owner' is kept alive for as long as the snapshot, for whoever owns the arrays.
+    static std::unique_ptr<const GraphSnapshot> attach(const PackedMap& map, uint64_t version,
+                                                       std::shared_ptr<const void> owner = nullptr);
+
+    // Counts up by one every time a new snapshot is published (1 = first load)
+    uint64_t version() const { return snapshotVersion; }
+
+    int nodeCount() const { return static_cast<int>(packed.nodeCount); }
+    int edgeCount() const { return static_cast<int>(packed.edgeCount); }  // Each hallway counts twice
+    int nodeId(const std::string& name) const { return packed.find(name); }  // -1 if unknown
+    std::string nodeName(int id) const { return packed.roomName(id); }
+
+    // The arrays themselves (to write them out, for example)
+    const PackedMap& packedMap() const { return packed; }
+
+    // Rooms joined by open hallways (directly or through other rooms) share a component number,
+    // 0..componentCount()-1. There is no route between rooms of different components, so a
+    // search between them can give up without looking at a single hallway.
+    int componentCount() const { return static_cast<int>(packed.componentCount); }
+    int componentOf(int id) const { return packed.component[id]; }
+    int componentSize(int c) const { return packed.componentSizes[c]; }
+
+    // Same results as Graph::dijkstra / Graph::shortestPathTree, but on the packed arrays
+    std::pair<std::vector<std::string>, int> dijkstra(const std::string& start, const std::string& end,
+                                                      const std::atomic<bool>* cancel = nullptr) const;
+    ShortestPathTree shortestPathTree(const std::string& start) const;
+
+    // Same searches, reporting what they do to 'probe' (see SearchStats.h)
+    template <typename Probe>
+    std::pair<std::vector<std::string>, int> dijkstra(const std::string& start, const std::string& end,
+                                                      const std::atomic<bool>* cancel, Probe& probe) const;
+    template <typename Probe>
+    ShortestPathTree shortestPathTree(const std::string& start, Probe& probe) const;
+
+private:
+    GraphSnapshot() = default;
+
+    uint64_t snapshotVersion = 0;
+    PackedMap packed;                   // What the searches read
+    PackedMapStorage storage;           // The arrays of a built snapshot (attached ones don't use it)
+    std::shared_ptr<const void> owner;  // Keeps the arrays of an attached snapshot alive
+};
+
+// Holds the current snapshot and swaps in new ones (read-copy-update).
+//
+// Readers never take a lock: they note the current "epoch" in a reader slot, read the pointer,
+// and clear the slot when done. A writer swaps the pointer, then bumps the epoch; the old snapshot
+// is only deleted once no reader slot still shows an epoch from before the swap.
+class GraphSnapshotStore {
+public:
+    // Keeps 'current' alive for as long as the Reader exists
+    class Reader {
+    public:
+        Reader(Reader&& other) noexcept;
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+        ~Reader();
+
+        // nullptr until the first snapshot is published
+        const GraphSnapshot* get() const { return snapshot; }
+        const GraphSnapshot* operator->() const { return snapshot; }
+        explicit operator bool() const { return snapshot != nullptr; }
+
+    private:
+        friend class GraphSnapshotStore;
+        Reader(std::atomic<uint64_t>* slot, const GraphSnapshot* snapshot) : slot(slot), snapshot(snapshot) {}
+
+        std::atomic<uint64_t>* slot;
+        const GraphSnapshot* snapshot;
+    };
+
+    GraphSnapshotStore() = default;
+    ~GraphSnapshotStore();
+
+    GraphSnapshotStore(const GraphSnapshotStore&) = delete;
+    GraphSnapshotStore& operator=(const GraphSnapshotStore&) = delete;
+
+    // Pin the current snapshot. Never takes a lock; only waits while more threads than there are
+    // reader slots are reading at the same time.
+    Reader read() const;
+
+    // Version of the current snapshot (0 = nothing published yet)
+    uint64_t currentVersion() const;
+
+    // Makes 'snapshot' the current one; the old one is freed once its last reader is done
+    void publish(std::unique_ptr<const GraphSnapshot> snapshot);
+
+private:
+    // Enough for every worker thread, the GUI thread and a few callers of the batch API
+    static const int kReaderSlots = 64;
+    // Full passes over the slots (yielding in between) before read() starts sleeping
+    static const int kSpinPasses = 16;
+
+    // One cache line each, so readers on different cores don't slow each other down
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{0};  // 0 = free, otherwise the epoch its reader started in
+    };
+
+    void reclaim();  // Called with writerMutex held
+
+    std::atomic<const GraphSnapshot*> current{nullptr};
+    std::atomic<uint64_t> epoch{1};
+    mutable ReaderSlot slots[kReaderSlots];
+
+    // Only writers touch these
+    std::mutex writerMutex;
+    std::vector<std::pair<uint64_t, const GraphSnapshot*>> retired;  // (epoch it was replaced in, snapshot)
+};
+
+#endif // GRAPHSNAPSHOT_H
@@ -0,0 +1,51 @@
+#ifndef LOCATIONINDEX_H
+#define LOCATIONINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The rooms a user can pick in the From / Via / To lists, worked out once when the map loads.
+//
+// Every room is checked against the "is this selectable?" rules (no stairs, hallways, ...) a
+// single time and is put into the list of every area it shows up in. Each area's list is
+// already sorted by display name ("EE-A-Lab-1" -> "EE A Lab 1"), so switching the area dropdown
+// just shows a ready-made list. Display names themselves are not stored: they are made when a
+// row is actually shown (see LocationListModel).
+class LocationIndex {
+public:
+    // The areas of the top-level dropdown (the building entrances show up in Outdoor too)
+    enum Area { Outdoor, EE, CS, Multi, kAreaCount };
+
+    static const uint32_t kNone = UINT32_MAX;
+
+    static const char* areaName(Area area);              // "Outdoor", "EE", "CS", "Multi"
+    static int areaFromName(std::string_view areaName);  // -1 for anything else ("Select Area...")
+
+    // Hallways, stairs, internal connection points, ... are only there for the routing
+    static bool isSelectable(const std::string& nodeName);
+    // Bit (1 << area) is set for every area whose list shows this room
+    static unsigned areasOf(const std::string& nodeName);
+
+    // 'nodeNames' is every room of the map; the ones that aren't selectable are skipped
+    void build(const std::vector<std::string>& nodeNames);
+
+    // Selectable rooms are numbered 0 .. size()-1 in A-Z order of their names
+    size_t size() const { return names.size(); }
+    const std::string& name(uint32_t location) const { return names[location]; }
+    std::string displayName(uint32_t location) const;
+    const std::vector<std::string>& allNames() const { return names; }
+    uint32_t find(const std::string& nodeName) const;  // kNone if the room isn't selectable
+
+    // The rooms of one area, sorted by display name
+    const std::vector<uint32_t>& inArea(Area area) const { return areaLists[area]; }
+    // Where a room is in inArea(area) (binary search); kNone if it isn't in that area
+    uint32_t positionInArea(Area area, uint32_t location) const;
+
+private:
+    std::vector<std::string> names;
+    std::vector<uint32_t> areaLists[kAreaCount];
+};
+
+#endif // LOCATIONINDEX_H
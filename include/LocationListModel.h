@@ -0,0 +1,68 @@
+#ifndef LOCATIONLISTMODEL_H
+#define LOCATIONLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QAbstractProxyModel>
+#include <QHash>
+#include <vector>
+#include "../core/LocationIndex.h"
+
+// A room list for the dropdowns that looks straight into the LocationIndex.
+// Nothing is copied: a row is just a location number, and its text is only made when Qt
+// actually draws that row. Switching areas points the model at another ready-made list,
+// so it costs the same for 50 rooms as for 500,000.
+class LocationListModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    // The real node name ("EE-A-Lab-1") of a row; the display text is "EE A Lab 1"
+    static const int kNodeNameRole = Qt::UserRole;
+
+    explicit LocationListModel(const LocationIndex& index, QObject* parent = nullptr);
+
+    void showArea(int area);  // A LocationIndex::Area, or -1 for an empty list
+    void showAll();           // Every location, row == location number
+    void reload();            // Call after the index was rebuilt (a new map was loaded)
+
+    uint32_t locationAt(int row) const;
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+private:
+    const LocationIndex& m_index;
+    const std::vector<uint32_t>* m_rows = nullptr;  // Points into the index; null = none
+    bool m_all = false;
+};
+
+// Shows a chosen handful of rows of another model (for example the search results), in the
+// order given. Setting new rows only touches those rows: the source model is never walked
+// or rebuilt, unlike QSortFilterProxyModel which looks at every source row.
+class LocationFilterModel : public QAbstractProxyModel {
+    Q_OBJECT
+
+public:
+    struct Row {
+        int sourceRow;
+        bool approximate;  // Shown with a "~" (e.g. found by spelling correction)
+    };
+
+    explicit LocationFilterModel(QObject* parent = nullptr);
+
+    void setSourceModel(QAbstractItemModel* sourceModel) override;
+    void setRows(std::vector<Row> rows);
+
+    QModelIndex mapToSource(const QModelIndex& proxyIndex) const override;
+    QModelIndex mapFromSource(const QModelIndex& sourceIndex) const override;
+    QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& child) const override;
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+private:
+    std::vector<Row> m_rows;
+    QHash<int, int> m_proxyRowOf;  // Source row -> our row
+};
+
+#endif // LOCATIONLISTMODEL_H
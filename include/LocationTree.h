@@ -1,29 +1,94 @@
 #ifndef LOCATIONTREE_H
 #define LOCATIONTREE_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <map>
-#include <memory>
-
-
-struct TreeNode {
-    std::string name;
-    std::string fullPath;
-    std::map<std::string, std::unique_ptr<TreeNode>> children;
-
-    TreeNode(const std::string& n) : name(n) {}
-};
 
+// Files every room name into folders by its dash-separated parts:
+// "EE-A-Lab-1" becomes Campus/EE/A/Lab/1.
+//
+// The whole tree lives in a few flat arrays instead of one heap object per folder:
+//   - every folder is one small TreeNode in 'nodes', referred to by its index (NodeId)
+//   - every different part ("EE", "Lab", "1", ...) is stored once in 'segmentText'
+//   - after finish(), the children of a folder sit next to each other, sorted by name,
+//     so walking the tree reads memory in order
+//
+// Usage: addLocation() for every room, then finish() once, then read.
+// More rooms can be added later, but call finish() again before reading.
 class LocationTree {
 public:
+    using NodeId = uint32_t;
+    static const NodeId kNone = UINT32_MAX;
+
+    // Children of one folder: for (NodeId child : tree.children(folder)) ...
+    struct ChildRange {
+        struct Iterator {
+            NodeId id;
+            NodeId operator*() const { return id; }
+            Iterator& operator++() { ++id; return *this; }
+            bool operator!=(const Iterator& other) const { return id != other.id; }
+        };
+        NodeId first;
+        NodeId last;  // One past the end
+        Iterator begin() const { return {first}; }
+        Iterator end() const { return {last}; }
+        size_t size() const { return last - first; }
+    };
+
     LocationTree();
-    void addLocation(const std::string& fullNodeName);
-    const TreeNode* getRoot() const;
 
+    // Room names are split at '-' without copying; each new part is stored once
+    void addLocation(std::string_view fullNodeName);
+    void reserve(size_t roomCount);
+
+    // Puts every folder's children next to each other in sorted order (needed before reading)
+    void finish();
+
+    // ---- Reading (after finish) ----
+    NodeId root() const { return 0; }
+    size_t size() const { return nodes.size(); }
+    size_t locationCount() const { return locations; }
+
+    std::string_view name(NodeId id) const;                     // "Lab" ("Campus" for the root)
+    bool isLocation(NodeId id) const { return nodes[id].isLocation; }  // A room was added with this exact path
+    std::string fullPath(NodeId id) const;                      // "EE-A-Lab-1" (empty for the root)
+    NodeId parent(NodeId id) const { return nodes[id].parent; } // kNone for the root
+    ChildRange children(NodeId id) const { return {nodes[id].firstChild, nodes[id].firstChild + nodes[id].childCount}; }
+
+    NodeId findChild(NodeId folder, std::string_view part) const;  // kNone if it has no such child
+    NodeId find(std::string_view fullNodeName) const;              // kNone if the room isn't in the tree
 
 private:
-    std::unique_ptr<TreeNode> root;
+    struct TreeNode {
+        uint32_t segment;          // Index into 'segments'
+        NodeId parent;
+        NodeId firstChild = 0;     // Children are [firstChild, firstChild + childCount) after finish()
+        uint32_t childCount = 0;
+        bool isLocation = false;
+    };
+    struct Segment {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    uint32_t internSegment(std::string_view text);
+    NodeId childFor(NodeId parent, std::string_view part);  // Finds or creates
+    std::string_view segmentView(uint32_t segment) const {
+        return std::string_view(segmentText).substr(segments[segment].offset, segments[segment].length);
+    }
+    void growTable(std::vector<uint32_t>& table, size_t used, bool childTable);
+
+    std::vector<TreeNode> nodes;
+    std::string segmentText;          // Every different part, back to back
+    std::vector<Segment> segments;
+    size_t locations = 0;
+
+    // Open-addressing hash tables used while adding: part text -> segment, (folder, segment) -> child.
+    // Both hold indices only, so they stay valid while the arrays above grow.
+    std::vector<uint32_t> segmentTable;
+    std::vector<uint32_t> childTable;
 };
 
 #endif // LOCATIONTREE_H
@@ -5,23 +5,52 @@
 #include <QGraphicsScene>
 #include <map>
 #include <string>
+#include <vector>
+#include <unordered_map>
 #include "../core/CampusGis.h"
+#include "../core/SpatialGrid.h"
+#include "../core/GeometryKernels.h"
 #include "../trees/LocationTree.h"
+#include "../trees/RoomSearchIndex.h"
 
 QT_BEGIN_NAMESPACE
 class QComboBox;
+class QLineEdit;
+class QListView;
 class QPushButton;
 class QTextBrowser;
 class QGraphicsView;
 class QGraphicsScene;
 class QTabWidget;
 class QGraphicsEllipseItem;
-class QGraphicsLineItem;
-class QVariantAnimation;
-class QPauseAnimation;
-class QSequentialAnimationGroup;
+class QGraphicsPathItem;
+class QSlider;
+class QProgressBar;
 QT_END_NAMESPACE
 
+class RouteAnimator;
+class LocationListModel;
+class LocationFilterModel;
+
+// Every map (outdoor + each floor) gets a number so we can keep per-floor lists in plain arrays.
+enum FloorId {
+    FLOOR_CAMPUS = 0,
+    FLOOR_EE_A, FLOOR_EE_B, FLOOR_EE_C, FLOOR_EE_D, FLOOR_EE_E,
+    FLOOR_CS_G, FLOOR_CS_1,
+    FLOOR_MULTI_B, FLOOR_MULTI_G, FLOOR_MULTI_1,
+    FLOOR_COUNT
+};
+
+// One hallway between two rooms. Stored only once (u < v), so it is also drawn only once.
+struct FloorEdge {
+    std::string u;
+    std::string v;
+    int weight;
+};
+
+// What a room is, worked out once from its name so drawing doesn't keep searching strings
+enum class NodeKind { Stairs, Hall, Lab, Entrance, Room };
+
 class MainWindow : public QMainWindow {
     Q_OBJECT
 
@@ -29,37 +58,44 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+signals:
+    // Emitted from worker threads, delivered to the GUI thread (queued connections)
+    void routeComputed(quint64 requestId, const RouteResult& result);
+    void routeProgress(quint64 requestId, int done, int total);
+
 private slots:
     void onFindPathClicked();
+    void onRouteComputed(quint64 requestId, const RouteResult& result);
+    void onRouteProgress(quint64 requestId, int done, int total);
     void updateSourceSubComboBox(const QString& text);
     void updateDestSubComboBox(const QString& text);
     void updateMidSubComboBox(const QString& text);
+    void onSearchTextChanged(const QString& text);
+    void onMapClicked(int floor, const QPointF& scenePos, qreal tolerance, Qt::KeyboardModifiers modifiers);
 
 private:
     void setupUi();
     void setupControlPanel();
     void setupMapTabs();
 
-    void drawFloorSchematic(QGraphicsScene* scene, const std::map<std::string, QPointF>& nodePositions, QString floorName);
+    void drawFloorSchematic(QGraphicsScene* scene, int floor, QString floorName);
     void drawCampusSchematic();
     void drawAllSchematics();
 
     void populateTopLevelComboBoxes();
     std::string getSelectedNode(QComboBox* top, QComboBox* sub) const;
-    void collectLeafNodes(const QString& topName, const std::map<std::string, std::vector<std::pair<std::string, int>>>& graph, QComboBox* comboBox);
+    void showAreaLocations(const QString& areaName, QComboBox* comboBox);
+    void buildSearchIndex();
+    void selectLocation(QComboBox* top, QComboBox* sub, const std::string& nodeName);
+    void applySearchResult(QComboBox* top, QComboBox* sub);
 
     void resetMapStyles();
     void fitViewToScene(QGraphicsView* view, QGraphicsScene* scene);
     void switchToSceneTab(QGraphicsScene* scene);
-    int calculateDistance(const QPointF& p1, const QPointF& p2) const;
     QGraphicsScene* getSceneForNode(const std::string& nodeName);
     QPointF getPosForNode(const std::string& nodeName);
     int getTabIndexForScene(QGraphicsScene* scene);
 
-    void buildGraph();
-    void addEdge(const std::string& node1, const std::string& node2, int weight);
-    std::pair<std::vector<std::string>, int> findShortestPath(const std::string& start, const std::string& end);
-
     std::map<std::string, QPointF> m_campusNodePositions;
 
     // EE Maps
@@ -79,19 +115,58 @@ private:
     std::map<std::string, QPointF> m_multiFloorGNodes;
     std::map<std::string, QPointF> m_multiFloor1Nodes;
 
-    std::map<std::string, std::vector<std::pair<std::string, int>>> m_graph;
+    // Built once after loading: which floor each room is on, the hallways that stay on
+    // each floor, and the "portal" hallways (stairs/entrances) that connect two floors.
+    std::map<std::string, int> m_nodeFloor;
+    std::vector<FloorEdge> m_floorEdges[FLOOR_COUNT];
+    std::vector<FloorEdge> m_portalEdges;
+
+    // The room positions of every floor again, as plain x and y arrays for the batch geometry
+    PointArrays m_floorPoints[FLOOR_COUNT];
+
+    // Selectable rooms of each floor by position (for clicking on the map):
+    // item i of m_floorRoomGrid[f] is the room m_floorRoomNames[f][i]
+    SpatialGrid m_floorRoomGrid[FLOOR_COUNT];
+    std::vector<std::string> m_floorRoomNames[FLOOR_COUNT];
+
+    // Kind of every room (filled by the "category index" startup stage)
+    std::unordered_map<std::string, NodeKind> m_nodeKinds;
 
     void loadDataFromCSV(const QString& filename);
     void assignNodeToFloor(const std::string& id, const QPointF& pos);
+    void buildFloorEdgeBuckets();
+    void buildFloorRoomGrids();
+    void checkHallwayWeights();
+    void classifyNodes();
+    NodeKind getNodeKind(const std::string& name) const;
+    const std::map<std::string, QPointF>& getFloorPositions(int floor) const;
 
     CampusGis m_gis;
 
+    // Find-a-room box: every selectable room, searchable by prefix and with typos
+    RoomSearchIndex m_searchIndex;
+    RoomSearchIndex::Session m_searchSession{m_searchIndex};
+
+    // The newest route search: its ID (older results are ignored) and its cancel flag
+    quint64 m_routeRequestId = 0;
+    CancelToken m_routeCancel;
+
     QWidget* m_controlWidget;
+    QLineEdit* m_searchEdit;
+    QListView* m_searchResults;
+    QPushButton *m_searchFromButton, *m_searchViaButton, *m_searchToButton;
     QComboBox *m_sourceTopComboBox, *m_sourceSubComboBox;
     QComboBox *m_midTopComboBox, *m_midSubComboBox;
     QComboBox *m_destTopComboBox, *m_destSubComboBox;
+
+    // The room lists look straight into the location index (nothing is copied):
+    // one per sub-location dropdown, plus all rooms filtered down to the search results
+    LocationListModel *m_sourceLocations, *m_midLocations, *m_destLocations;
+    LocationListModel* m_allLocations;
+    LocationFilterModel* m_searchResultModel;
     QPushButton* m_findPathButton;
     QTextBrowser* m_pathResultText;
+    QProgressBar* m_routeProgress;
 
     QTabWidget* m_mainTabs;
     QGraphicsView* m_campusView; QGraphicsScene* m_campusScene;
@@ -115,10 +190,16 @@ private:
 
     std::map<std::string, QGraphicsItem*> m_nodeItems;
     std::map<std::string, QGraphicsRectItem*> m_roomItems;
-    std::map<std::pair<std::string, std::string>, QGraphicsLineItem*> m_edgeItems;
+    // The route shown right now: one path item on every map it crosses
+    std::vector<QGraphicsPathItem*> m_routeItems;
 
-    QSequentialAnimationGroup* m_animationGroup;
+    RouteAnimator* m_routeAnimator;
+    QPushButton* m_playPauseButton;
+    QComboBox* m_speedComboBox;
+    QSlider* m_routeSlider;
     QGraphicsEllipseItem* m_personIcon;
 };
 
+Q_DECLARE_METATYPE(RouteResult)
+
 #endif // MAINWINDOW_H
@@ -0,0 +1,52 @@
+#ifndef MAPCACHE_H
+#define MAPCACHE_H
+
+#include "GraphImage.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A route leg that was asked for often, remembered from earlier runs
+struct WarmRoute {
+    uint64_t count = 0;              // How often it was asked for (all runs together)
+    int distance = -1;
+    std::vector<std::string> path;   // From the first room to the last
+};
+
+// A folder that keeps work from one run to the next, so later runs can skip it.
+//
+//   <directory>/<fingerprint of the map file>/graph.img    the packed map (a GraphImage)
+//   <directory>/<fingerprint of the map file>/cleanup.csv  what the map check cleaned up before packing
+//   <directory>/<fingerprint of the map file>/routes.csv   the most asked-for routes
+//
+// The fingerprint is taken from the bytes of the map file. Editing the map gives a new
+// fingerprint, so the old entry is simply never found again (and is removed once a few newer
+// ones exist). Nothing has to be cleared by hand.
+class MapCache {
+public:
+    explicit MapCache(const std::string& directory);
+
+    // Fingerprints 'mapFile' and picks its entry. False if the file can't be read.
+    bool open(const std::string& mapFile);
+    uint64_t mapHash() const { return hash; }
+
+    // The cached packed map, mapped read-only; nullptr if there is none (or it doesn't match).
+    // The packed map is already cleaned up, so what the cleanup found is kept next to it.
+    std::shared_ptr<const GraphImage> loadImage(Graph::EdgeCleanup& cleanup) const;
+    bool storeImage(const PackedMap& map, const Graph::EdgeCleanup& cleanup) const;
+
+    std::vector<WarmRoute> loadRoutes() const;
+    bool storeRoutes(const std::vector<WarmRoute>& routes) const;
+
+private:
+    std::string entryPath(const char* file) const;
+    static bool writeText(const std::string& path, const std::string& text);
+    void removeOldEntries() const;
+
+    std::string directory;
+    std::string entry;   // Empty until open() succeeds
+    uint64_t hash = 0;
+};
+
+#endif // MAPCACHE_H
@@ -0,0 +1,30 @@
+#ifndef MAPVIEW_H
+#define MAPVIEW_H
+
+#include <QGraphicsView>
+
+// A QGraphicsView set up for big floor maps:
+// scroll wheel zooms around the mouse, dragging pans, and Qt only repaints what changed.
+// The zoom level it sets is what FloorTileLayer reads to decide how much detail to draw.
+// A click that doesn't drag is reported as mapClicked (used to pick rooms on the map).
+class MapView : public QGraphicsView {
+    Q_OBJECT
+
+public:
+    explicit MapView(QGraphicsScene* scene, QWidget* parent = nullptr);
+
+signals:
+    // 'tolerance' is how far (in scene units) a room may be from the click and still count,
+    // so it stays the same size on screen at every zoom level
+    void mapClicked(const QPointF& scenePos, qreal tolerance, Qt::KeyboardModifiers modifiers);
+
+protected:
+    void wheelEvent(QWheelEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+
+private:
+    QPoint m_pressPos;
+};
+
+#endif // MAPVIEW_H
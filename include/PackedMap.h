@@ -0,0 +1,104 @@
+#ifndef PACKEDMAP_H
+#define PACKEDMAP_H
+
+#include "Graph.h"
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A whole campus map packed into flat arrays of plain numbers and characters.
+//
+//   Room i is called nameChars[nameStart[i]] .. nameChars[nameStart[i+1]-1] and drawn at (x[i], y[i]).
+//   Its hallways lead to targets[offsets[i]] .. targets[offsets[i+1]-1] (CSR, like GraphSnapshot).
+//
+// Rooms 0..nodeCount-1 have hallways and are sorted by name, so they get the same numbers as in a
+// GraphSnapshot. Rooms nodeCount..roomCount-1 only have a position (the "orphans" of the map check).
+//
+// Nothing in the arrays points anywhere (rooms are numbers, names are offsets), so the same arrays
+// work compiled into the program (campus_embed), in a file or in shared memory, and can be searched
+// right where they are without being copied or unpacked first.
+struct PackedMap {
+    uint32_t nodeCount = 0;
+    uint32_t roomCount = 0;
+    uint32_t edgeCount = 0;              // Each hallway counts twice (once from each end)
+
+    const int32_t* offsets = nullptr;    // nodeCount + 1 entries
+    const int32_t* targets = nullptr;    // edgeCount entries
+    const int32_t* weights = nullptr;    // edgeCount entries
+    const uint32_t* nameStart = nullptr; // roomCount + 1 entries
+    const char* nameChars = nullptr;     // All names back to back (no terminators)
+    const double* x = nullptr;           // roomCount entries; NaN = no position in the map file
+    const double* y = nullptr;
+
+    // Name -> room without collisions (a "perfect hash"): the name picks a bucket, the bucket's
+    // seed picks a slot, and the slot holds the only room that can have that name. Only rooms
+    // with hallways are in it. hashBuckets == 0 means there is no table (find() then falls back
+    // to a binary search, the names being sorted).
+    uint64_t hashSalt = 0;
+    uint32_t hashBuckets = 0;
+    uint32_t hashSlotCount = 0;
+    const uint32_t* hashSeeds = nullptr; // hashBuckets entries
+    const int32_t* hashSlots = nullptr;  // hashSlotCount entries; -1 = empty
+
+    // Rooms joined by hallways share a component number (see GraphSnapshot::componentOf)
+    uint32_t componentCount = 0;
+    const int32_t* component = nullptr;      // nodeCount entries
+    const int32_t* componentSizes = nullptr; // componentCount entries
+
+    std::string roomName(uint32_t room) const;
+    bool hasPosition(uint32_t room) const;
+
+    // Number of the room with hallways called 'name', or -1 if there is none
+    int find(const std::string& name) const;
+    int find(const char* name, size_t length) const;
+
+    // The hash the table is built with (also used by campus_embed to fingerprint the map file)
+    static uint64_t hashBytes(const char* data, size_t length, uint64_t salt = 0);
+};
+
+// Owns the arrays of a PackedMap that is packed while the program runs.
+//
+//   PackedMapStorage storage;
+//   storage.packGraph(graph, closed);
+//   storage.addPosition("EE-1-Room-7", 120, 100);  // Optional
+//   const PackedMap& map = storage.finish();       // Valid for as long as 'storage' lives
+class PackedMapStorage {
+public:
+    PackedMapStorage() = default;
+    PackedMapStorage(const PackedMapStorage&) = delete;
+    PackedMapStorage& operator=(const PackedMapStorage&) = delete;
+
+    // Rooms and hallways of 'graph', leaving out the closed hallways (stored as (smaller, bigger) name).
+    // Call this first.
+    void packGraph(const Graph& graph, const std::set<std::pair<std::string, std::string>>& closed);
+
+    // Same, but copied from another packed map (positions included). Use instead of packGraph.
+    void packMap(const PackedMap& base, const std::set<std::pair<std::string, std::string>>& closed);
+
+    // Where a room is drawn. Rooms the graph doesn't have are added as position-only rooms,
+    // so call this in name order for those to stay sorted (a std::map does that by itself).
+    void addPosition(const std::string& room, double x, double y);
+
+    // Works out the components and points the map at our arrays
+    const PackedMap& finish();
+    const PackedMap& map() const { return packed; }
+
+private:
+    void buildNameTable();
+    void findComponents();
+    void pointAtArrays();  // Our vectors may have moved: point 'packed' at them again
+
+    PackedMap packed;
+    std::vector<int32_t> offsets, targets, weights;
+    std::vector<uint32_t> nameStart;
+    std::vector<char> nameChars;
+    std::vector<double> x, y;
+    std::vector<uint32_t> hashSeeds;
+    std::vector<int32_t> hashSlots;
+    std::vector<int32_t> component, componentSizes;
+};
+
+#endif // PACKEDMAP_H
@@ -0,0 +1,110 @@
+#ifndef ROOMSEARCHINDEX_H
+#define ROOMSEARCHINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Finds rooms by name while the user is typing: "lab 5", "cafe", "ee a" ...
+//
+// Two indexes are built once from the room names:
+//   - a compressed trie (radix tree) of every word-start of every name ("ee a lab 5", "a lab 5",
+//     "lab 5", "5"), so "lab" finds all labs in one walk down the tree. Big folders keep a short
+//     list of their best rooms, so even "r" on a 100k-room campus doesn't look at every room.
+//   - a trigram index ("^la", "lab", ...) for spelling mistakes: "labb 5" or "cafetria" still
+//     find the room when the trie finds too little.
+// Matching ignores case, dashes and spaces. Results are ranked: names that start with the text
+// first, then matches later in the name, shorter names before longer ones, then A-Z.
+class RoomSearchIndex {
+public:
+    struct Match {
+        uint32_t room;  // For name() / displayName()
+        int typos;      // 0 = exact (prefix of a word); otherwise how many letters differ
+    };
+
+    // The text shown in the room lists: dashes become spaces ("EE-A-Lab-1" -> "EE A Lab 1")
+    // and a trailing " O" marker is dropped
+    static std::string displayNameFor(const std::string& name);
+
+    // Most results a search returns
+    static constexpr size_t kMaxResults = 32;
+
+    void build(const std::vector<std::string>& roomNames);
+
+    size_t size() const { return names.size(); }
+    const std::string& name(uint32_t room) const { return names[room]; }
+    const std::string& displayName(uint32_t room) const { return displayNames[room]; }
+
+    // One-off search (for typing, use a Session so each key press reuses the last one)
+    std::vector<Match> search(std::string_view text, size_t limit = 20) const;
+
+    // Search-as-you-type for one text box. When the new text just adds letters to the old one,
+    // the trie walk continues from where the last key press stopped.
+    class Session {
+    public:
+        explicit Session(const RoomSearchIndex& index) : index(index) {}
+        const std::vector<Match>& update(std::string_view text, size_t limit = 20);
+        const std::vector<Match>& results() const { return matches; }
+        void reset();
+
+    private:
+        void addFuzzyMatches(const std::string& query, size_t limit);
+
+        const RoomSearchIndex& index;
+        std::string lastQuery;         // Normalized text of the last update
+        uint32_t node = 0;             // Trie node reached by lastQuery
+        bool noPrefixMatch = false;    // lastQuery (so also any longer text) isn't in the trie
+        std::vector<Match> matches;
+
+        // Scratch space for the trigram counts (kept so typing doesn't allocate)
+        std::vector<uint16_t> counts;
+        std::vector<uint32_t> touched;
+    };
+
+private:
+    // One word-start of one room's normalized name
+    struct Key {
+        uint32_t room;
+        uint32_t offset;  // Into the room's normalized text
+        uint32_t word;    // 0 = start of the name
+    };
+    // Trie node: every key in keys[begin, end) starts with the node's text (its first 'depth' chars)
+    struct TrieNode {
+        uint32_t begin;
+        uint32_t end;
+        uint32_t depth;
+        uint32_t firstChild = 0;   // Children are [firstChild, firstChild + childCount), sorted by letter
+        uint32_t childCount = 0;
+        uint32_t topBegin = 0;     // Best rooms of big nodes: topKeys[topBegin, topBegin + topCount)
+        uint32_t topCount = 0;
+    };
+
+    static std::string normalize(std::string_view text);
+    std::string_view keyText(uint32_t key) const;
+    uint64_t keyScore(uint32_t key) const;
+    void buildTrieChildren(uint32_t node);
+    void buildTopLists();
+    void buildTrigrams();
+
+    // Walks down from 'node', which already matches query[0, matched). False if nothing matches.
+    bool descend(uint32_t& node, const std::string& query, size_t matched) const;
+    void collectPrefixMatches(uint32_t node, size_t limit, std::vector<Match>& out) const;
+    int prefixTypos(const std::string& query, uint32_t room, int maxTypos) const;
+
+    std::vector<std::string> names;
+    std::vector<std::string> displayNames;
+    std::string normalizedText;            // Every room's normalized name, back to back
+    std::vector<uint32_t> normalizedStart; // size() + 1 entries
+
+    std::vector<Key> keys;                 // Sorted by text
+    std::vector<TrieNode> trie;            // trie[0] is the root
+    std::vector<uint32_t> topKeys;         // Best key per room for big nodes, best first
+
+    // Trigram -> rooms that contain it (sorted list of trigrams, offsets into trigramRooms)
+    std::vector<uint32_t> trigrams;
+    std::vector<uint32_t> trigramOffsets;
+    std::vector<uint32_t> trigramRooms;
+};
+
+#endif // ROOMSEARCHINDEX_H
@@ -0,0 +1,74 @@
+#ifndef ROUTEANIMATOR_H
+#define ROUTEANIMATOR_H
+
+#include <QObject>
+#include <QPointF>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <vector>
+
+QT_BEGIN_NAMESPACE
+class QGraphicsItem;
+class QGraphicsScene;
+QT_END_NAMESPACE
+
+// Walks the person icon along a route.
+// The whole route is turned into one timeline up front (walking segments + floor-change pauses),
+// and a single timer moves the icon along it. Each frame only looks at the current segment,
+// so the cost per frame does not depend on how long the route is.
+class RouteAnimator : public QObject {
+    Q_OBJECT
+
+public:
+    // One point of the route: which map it is on and where the icon should be
+    struct Stop {
+        QGraphicsScene* scene;
+        QPointF pos;
+    };
+
+    RouteAnimator(QGraphicsItem* icon, QObject* parent = nullptr);
+
+    // Build the timeline for a new route (does not start playing)
+    void setRoute(const std::vector<Stop>& stops);
+
+    void play();
+    void pause();
+    void stop();
+    void seek(qreal progress);        // 0.0 = start, 1.0 = end
+    void setSpeed(qreal multiplier);  // 1.0 = normal walking speed
+
+    bool isPlaying() const;
+    qreal progress() const;
+    qreal totalDuration() const;      // In milliseconds at normal speed
+
+signals:
+    void sceneChanged(QGraphicsScene* scene);  // The icon moved to another floor
+    void progressChanged(qreal progress);
+    void finished();
+
+private slots:
+    void onFrame();
+
+private:
+    // A piece of the timeline: walk from 'from' to 'to' (or stand still if they are equal)
+    struct Segment {
+        QGraphicsScene* scene;
+        QPointF from;
+        QPointF to;
+        qreal startMs;
+        qreal durationMs;
+    };
+
+    void applyPosition();
+
+    QGraphicsItem* m_icon;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+
+    std::vector<Segment> m_segments;
+    size_t m_current = 0;     // Segment the icon is on right now
+    qreal m_positionMs = 0;   // How far along the timeline we are
+    qreal m_speed = 1.0;
+};
+
+#endif // ROUTEANIMATOR_H
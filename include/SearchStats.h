@@ -0,0 +1,138 @@
+#ifndef SEARCHSTATS_H
+#define SEARCHSTATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+// Search instrumentation is on in debug builds and compiled out in release builds (NDEBUG).
+// Build with -DCAMPUS_SEARCH_STATS=1 (or =0) to force it either way.
+#ifndef CAMPUS_SEARCH_STATS
+#ifdef NDEBUG
+#define CAMPUS_SEARCH_STATS 0
+#else
+#define CAMPUS_SEARCH_STATS 1
+#endif
+#endif
+
+constexpr bool kSearchStatsEnabled = CAMPUS_SEARCH_STATS != 0;
+
+// The parts of one search we time separately
+enum class SearchPhase { Setup, Search, Path, Count };
+
+// The search functions take a "probe" and tell it what they are doing.
+// NoSearchProbe ignores everything; its calls are empty inline functions, so a search
+// compiled with it is exactly the plain search loop.
+struct NoSearchProbe {
+    static constexpr bool enabled = false;
+    void settled() {}
+    void relaxed() {}
+    void pushed() {}
+    void popped() {}
+    void stalePop() {}
+    void phase(SearchPhase) {}
+    void finish() {}
+    void add(const NoSearchProbe&) {}
+};
+
+// Counts what one search did, and how long each phase took
+struct SearchCounters {
+    static constexpr bool enabled = true;
+
+    uint64_t nodesSettled = 0;
+    uint64_t edgesRelaxed = 0;   // Neighbor checks that found a shorter way
+    uint64_t heapPushes = 0;
+    uint64_t heapPops = 0;
+    uint64_t stalePops = 0;      // Popped entries that were already out of date
+    double phaseMicros[static_cast<int>(SearchPhase::Count)] = {};
+
+    void settled() { ++nodesSettled; }
+    void relaxed() { ++edgesRelaxed; }
+    void pushed() { ++heapPushes; }
+    void popped() { ++heapPops; }
+    void stalePop() { ++stalePops; }
+
+    // Ends the current phase (if any) and starts 'next'
+    void phase(SearchPhase next) {
+        auto now = std::chrono::steady_clock::now();
+        if (running) phaseMicros[static_cast<int>(current)] += std::chrono::duration<double, std::micro>(now - started).count();
+        current = next;
+        started = now;
+        running = true;
+    }
+    void finish() {
+        if (!running) return;
+        phaseMicros[static_cast<int>(current)] +=
+            std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count();
+        running = false;
+    }
+
+    // Adds another search's counts to ours (e.g. the two legs of a via route)
+    void add(const SearchCounters& other);
+
+private:
+    SearchPhase current = SearchPhase::Setup;
+    std::chrono::steady_clock::time_point started;
+    bool running = false;
+};
+
+// The probe the app actually uses: real counters, or nothing at all
+using ActiveSearchProbe = std::conditional_t<kSearchStatsEnabled, SearchCounters, NoSearchProbe>;
+
+// HDR-style histogram: every power of two is split into 16 equal buckets, so any recorded value
+// is known to within ~6% while the whole 64-bit range fits in 1024 counters.
+// Recording is lock-free, so all worker threads can share one histogram.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(uint64_t value);
+    void reset();
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t max() const { return maxValue.load(std::memory_order_relaxed); }
+    double mean() const;
+
+    // Smallest bucket edge that at least 'fraction' (0..1) of the values are at or below
+    uint64_t percentile(double fraction) const;
+
+private:
+    static const int kSubBuckets = 16;
+    static const int kBuckets = 64 * kSubBuckets;
+    static int bucketFor(uint64_t value);
+    static uint64_t bucketTop(int bucket);
+
+    std::atomic<uint64_t> counts[kBuckets];
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> maxValue;
+};
+
+// Everything the app has measured since the last reset (shared by all searches)
+class SearchStatsRegistry {
+public:
+    // One finished route: its counters, total time, and whether a prefetched tree or a
+    // remembered route (the map cache) answered it without a search
+    void record(const SearchCounters& counters, double totalMicros, bool treeHit, bool warmHit);
+    void record(const NoSearchProbe&, double, bool, bool) {}  // Instrumentation compiled out
+    void reset();
+
+    // A readable multi-line summary (for the GUI dump, the CLI and logs)
+    std::string report() const;
+
+private:
+    LatencyHistogram totalNanos;
+    LatencyHistogram phaseNanos[static_cast<int>(SearchPhase::Count)];
+    LatencyHistogram settledPerQuery;
+    LatencyHistogram relaxedPerQuery;
+    std::atomic<uint64_t> queries{0};
+    std::atomic<uint64_t> treeHits{0};
+    std::atomic<uint64_t> warmHits{0};
+    std::atomic<uint64_t> heapPushes{0};
+    std::atomic<uint64_t> heapPops{0};
+    std::atomic<uint64_t> stalePops{0};
+};
+
+#endif // SEARCHSTATS_H
@@ -0,0 +1,52 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Finds things on a floor map by position: "what is near this click?" and "what lies inside
+// this rectangle?" (for example the part of the map on screen).
+//
+// The floor is cut into equal square cells and every item is filed under the cells its box
+// touches. All the lists sit back to back in one array (built once, never changed), so a query
+// only reads the few cells around the spot it asks about, however many rooms the floor has.
+class SpatialGrid {
+public:
+    static const uint32_t kNone = UINT32_MAX;
+
+    struct Box {
+        double minX, minY, maxX, maxY;
+    };
+
+    // Items are numbered by their place in 'boxes' (a room is just a box of size 0).
+    // A cellSize of 0 picks one from the number of items and the size of the floor.
+    void build(const std::vector<Box>& boxes, double cellSize = 0);
+    void clear();
+
+    size_t size() const { return items.size(); }
+    const Box& box(uint32_t item) const { return items[item]; }
+
+    // The item closest to (x, y) (distance to its box, 0 when inside it), but no further
+    // away than maxDistance; kNone if there is nothing that close
+    uint32_t nearest(double x, double y, double maxDistance) const;
+
+    // Every item whose box overlaps 'area', in the order they were given to build()
+    void query(const Box& area, std::vector<uint32_t>& out) const;
+
+private:
+    int cellColumn(double x) const;
+    int cellRow(double y) const;
+
+    std::vector<Box> items;
+    Box bounds = {0, 0, 0, 0};
+    double cellSize = 1;
+    int columns = 0;
+    int rows = 0;
+
+    // Items of cell c are cellItems[cellStart[c], cellStart[c + 1])
+    std::vector<uint32_t> cellStart;
+    std::vector<uint32_t> cellItems;
+};
+
+#endif // SPATIALGRID_H
@@ -0,0 +1,26 @@
+#ifndef SYNTHETICCAMPUS_H
+#define SYNTHETICCAMPUS_H
+
+#include "CampusGis.h"
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A made-up campus of any size, for benchmarks and tests.
+// It looks like the real map: several buildings, each with a few floors. Every floor is a grid of
+// hallways with rooms and labs on both sides, and two stairwells connect it to the floor above.
+// Each building has an entrance on its ground floor, and the entrances are linked by outdoor walkways.
+// Names follow the real Building-Floor-Room style, e.g. "B3-2-Room-17", "B3-G-Hall-4-2", "B3-G-Entrance".
+struct SyntheticCampus {
+    std::vector<std::pair<std::string, MapPosition>> nodes;
+    std::vector<MapEdgeRecord> edges;
+
+    // Writes the campus in the same CSV format as data/campus_map_detailed.csv
+    void writeCsv(std::ostream& out) const;
+};
+
+// Roughly 'targetNodes' rooms (within a few percent). The same seed always gives the same campus.
+SyntheticCampus generateSyntheticCampus(size_t targetNodes, unsigned seed = 1);
+
+#endif // SYNTHETICCAMPUS_H
@@ -0,0 +1,55 @@
+#ifndef TASKGRAPH_H
+#define TASKGRAPH_H
+
+#include "ThreadPool.h"
+#include <string>
+#include <vector>
+#include <functional>
+#include <memory>
+
+// A small "to-do list with arrows": each task names the tasks it has to wait for.
+// run() starts every task as soon as its dependencies are done, so independent work
+// (e.g. building the graph and the location tree) happens at the same time on the workers.
+// Tasks marked CallingThread run on the thread that called run() (the GUI thread at startup).
+class TaskGraph {
+public:
+    enum class Where { Worker, CallingThread };
+
+    // How long one task took, measured from the start of run()
+    struct Timing {
+        std::string name;
+        double startMs;
+        double durationMs;
+        bool onCallingThread;
+    };
+
+    // Dependencies must already have been added (so the graph can never have a cycle)
+    void addTask(const std::string& name, std::function<void()> work,
+                 const std::vector<std::string>& dependsOn = {}, Where where = Where::Worker);
+
+    // Runs everything and waits until the last task is done. If a task throws,
+    // the rest still run and the first exception is rethrown at the end.
+    void run(ThreadPool& pool);
+
+    const std::vector<Timing>& timings() const;
+    double totalMs() const;
+
+private:
+    struct Task {
+        std::string name;
+        std::function<void()> work;
+        Where where;
+        std::vector<int> dependents;  // Tasks waiting for this one
+        int dependencyCount = 0;
+    };
+
+    struct RunState;
+    void schedule(const std::shared_ptr<RunState>& state, int index);
+    void execute(const std::shared_ptr<RunState>& state, int index);
+
+    std::vector<Task> tasks;
+    std::vector<Timing> stageTimings;
+    double wallMs = 0;
+};
+
+#endif // TASKGRAPH_H
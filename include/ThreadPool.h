@@ -0,0 +1,49 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// A fixed group of worker threads that take jobs from a shared queue.
+// Used so slow work (route searches) never runs on the GUI thread.
+class ThreadPool {
+public:
+    // 0 threads means "one per CPU core"
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Queue a job and get a future for its result
+    template <typename Task>
+    auto submit(Task task) -> std::future<decltype(task())> {
+        using Result = decltype(task());
+        auto job = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+        std::future<Result> future = job->get_future();
+        enqueue([job]() { (*job)(); });
+        return future;
+    }
+
+    // Queue a job when nobody needs to wait for it
+    void enqueue(std::function<void()> job);
+
+    size_t size() const;
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> jobs;
+    std::mutex queueMutex;
+    std::condition_variable wakeUp;
+    bool stopping = false;
+};
+
+#endif // THREADPOOL_H
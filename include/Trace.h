@@ -0,0 +1,91 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Records how long the interesting parts of the app take and writes them as a Chrome
+// "trace_event" JSON file (open it in chrome://tracing or https://ui.perfetto.dev).
+// Every thread gets its own track. While tracing is off, a span costs one relaxed atomic load.
+//
+// Turn it on with the CAMPUS_TRACE=<file> environment variable or the --trace <file> flag.
+class TraceRecorder {
+public:
+    static TraceRecorder& instance();
+
+    // Start recording; the file is written by stop() (main() calls it on exit)
+    void start(const std::string& outputPath);
+    // Start if CAMPUS_TRACE is set; returns true when tracing is on
+    bool startFromEnvironment();
+    // Stop recording and write the file. Returns false if it could not be written.
+    bool stop();
+
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // Name the calling thread's track ("main", "worker 3", ...)
+    void setThreadName(const std::string& name);
+
+    // One finished span on the calling thread
+    void addSpan(const char* name, const char* category, const std::string& detail,
+                 std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end);
+
+private:
+    struct Event {
+        const char* name;
+        const char* category;
+        std::string detail;
+        double startUs;
+        double durationUs;
+    };
+
+    // Each thread writes to its own buffer; the lock is only ever contended while stop() reads it
+    struct ThreadBuffer {
+        int tid;
+        std::string name;
+        std::mutex mutex;
+        std::vector<Event> events;
+    };
+
+    TraceRecorder() = default;
+    ThreadBuffer& bufferForThisThread();
+
+    std::atomic<bool> enabled{false};
+    std::string path;
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+
+    std::mutex buffersMutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;  // Kept after their thread exits
+};
+
+// Times the enclosing block:  TraceSpan span("drawAllSchematics", "draw");
+// 'name' and 'category' must be string literals (they are stored as pointers).
+// 'detail' is only copied while tracing is on; build it only then too if that costs anything.
+class TraceSpan {
+public:
+    TraceSpan(const char* name, const char* category, const std::string& detail = std::string())
+        : name(name), category(category), active(TraceRecorder::instance().isEnabled()) {
+        if (active) {
+            this->detail = detail;
+            begin = std::chrono::steady_clock::now();
+        }
+    }
+    ~TraceSpan() {
+        if (active) TraceRecorder::instance().addSpan(name, category, detail, begin, std::chrono::steady_clock::now());
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name;
+    const char* category;
+    bool active;
+    std::string detail;
+    std::chrono::steady_clock::time_point begin;
+};
+
+#endif // TRACE_H
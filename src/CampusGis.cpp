@@ -1,15 +1,158 @@
 #include "../../include/core/CampusGis.h"
+#include "../../include/core/GraphImage.h"
+#include "../../include/core/MapCache.h"
+#include "../../include/core/Trace.h"
 #include <QFile>
 #include <QTextStream>
 #include <QDebug>
+#include <algorithm>
+#ifdef CAMPUS_EMBEDDED_MAP
+#include "EmbeddedCampusMap.h"  // Written at build time by campus_embed (src/map_embed.cpp)
+#endif
 
 // Added: Use standard namespace to remove std:: prefixes
 using namespace std;
 
-CampusGis::CampusGis() {}
+const char* const CampusGis::kParseStage = "parse";
+const char* const CampusGis::kGraphStage = "graph freeze";
+const char* const CampusGis::kLocationTreeStage = "location tree";
+const char* const CampusGis::kLocationIndexStage = "location index";
+const char* const CampusGis::kValidationStage = "map check";
+const char* const CampusGis::kCacheStage = "map cache";
 
-// This opens the CSV text file and reads it line by line.
+// How many prefetched shortest-path trees we keep around (source, via, and a few recent ones)
+static const size_t kTreeCacheSize = 4;
+
+// How many room names the map check prints per problem (the report itself keeps all of them)
+static const size_t kReportedRooms = 5;
+
+// How many different route legs one run remembers (spread over the shards), and how many of
+// them (the most asked-for) are saved for the next run
+static const size_t kMaxWarmLegs = 4096;
+static const size_t kSavedWarmLegs = 256;
+// How many legs that didn't fit are counted, waiting to be asked for often enough to get in
+static const size_t kMaxWarmMisses = 4 * kMaxWarmLegs;
+
+CampusGis::CampusGis(unsigned workerThreads) : workerCount(workerThreads) {}
+
+// Make sure no worker is still reading the graph when we go away
+CampusGis::~CampusGis() {
+    shutdownWorkers();
+    saveCache();
+}
+
+// Loads the map in one go (parse, then graph + location tree side by side on the workers)
 bool CampusGis::loadMapData(const string& filePath) {
+    TaskGraph pipeline;
+    addLoadStages(pipeline, filePath);
+    pipeline.run(getWorkers());
+    return lastLoadOk;
+}
+
+// Adds the loading stages to a startup pipeline:
+//   "parse" -> { "graph freeze" -> { "map check", "map cache" }, "location tree", "location index" }
+// Callers can hang their own stages off these names (see MainWindow::loadDataFromCSV).
+void CampusGis::addLoadStages(TaskGraph& pipeline, const string& filePath) {
+    addLoadStages(pipeline, [this, filePath]() { return readMapFile(filePath); });
+}
+
+void CampusGis::addLoadStages(TaskGraph& pipeline, const PackedMap& map, shared_ptr<const void> owner) {
+    addLoadStages(pipeline, [this, &map]() { return unpackMap(map); });
+    packedBase = &map;
+    packedOwner = move(owner);
+}
+
+bool CampusGis::loadPackedMap(const PackedMap& map, shared_ptr<const void> owner) {
+    TaskGraph pipeline;
+    addLoadStages(pipeline, map, move(owner));
+    pipeline.run(getWorkers());
+    return lastLoadOk;
+}
+
+// The stages themselves; 'readMap' fills nodePositions and pendingEdges
+void CampusGis::addLoadStages(TaskGraph& pipeline, function<bool()> readMap) {
+    resetForLoad();
+    pipeline.addTask(kParseStage, [this, readMap]() { lastLoadOk = readMap(); });
+    pipeline.addTask(kGraphStage, [this]() { freezeGraph(); }, {kParseStage});
+    pipeline.addTask(kValidationStage, [this]() { validateMap(); }, {kGraphStage});
+    pipeline.addTask(kCacheStage, [this]() { updateCache(); }, {kGraphStage});
+    pipeline.addTask(kLocationTreeStage, [this]() { buildLocationTree(); }, {kParseStage});
+    pipeline.addTask(kLocationIndexStage, [this]() { buildLocationIndex(); }, {kParseStage});
+}
+
+// Only the snapshot is set up; there is nothing to draw, so nothing is unpacked
+bool CampusGis::attachGraphImage(const string& imagePath, string* error) {
+    shared_ptr<const GraphImage> image = GraphImage::open(imagePath, error);
+    if (!image) return lastLoadOk = false;
+
+    resetForLoad();
+    campusGraph = Graph();
+    nodePositions.clear();
+    pendingEdges.clear();
+    locationTree = LocationTree();
+    locationIndex.build({});
+    validation = MapValidationReport();
+
+    lock_guard<mutex> lock(closureMutex);
+    packedBase = &image->map();
+    packedOwner = image;
+    publishSnapshot();
+    return lastLoadOk = true;
+}
+
+void CampusGis::resetForLoad() {
+    // Start from a clean slate (the map might be reloaded).
+    // Workers may still be reading the old graph, so let them finish first.
+    shutdownWorkers();
+    saveCache();  // The routes asked for on the old map
+    cacheState = CacheState::Off;
+    clearWarmLegs();
+    {
+        lock_guard<mutex> lock(treeCacheMutex);
+        treeCache.clear();
+    }
+    {
+        // Closures belong to the old map
+        lock_guard<mutex> lock(closureMutex);
+        closedHallways.clear();
+    }
+}
+
+bool CampusGis::readMapFile(const string& filePath) {
+    packedBase = nullptr;
+    packedOwner.reset();
+    shared_ptr<const GraphImage> image;
+    if (GraphImage::looksLikeImage(filePath)) {
+        // A graph image is already packed: nothing to parse, and the searches can use it as it is
+        string error;
+        image = GraphImage::open(filePath, &error);
+        if (!image) {
+            qWarning() << "Error: Could not open graph image" << QString::fromStdString(filePath) << ":" << QString::fromStdString(error);
+            return false;
+        }
+        if (cache) qWarning() << "Map cache: not used for" << QString::fromStdString(filePath) << "(a graph image is packed already)";
+    } else if (cache && cache->open(filePath)) {
+        // Packed on an earlier run; the cache only has it if the file hasn't changed since
+        image = cache->loadImage(cachedCleanup);
+        cacheState = image ? CacheState::Hit : CacheState::Miss;
+    }
+    if (!image) return parseMapFile(filePath);
+
+    packedBase = &image->map();
+    packedOwner = image;
+    return unpackMap(image->map());
+}
+
+// This opens the CSV text file and reads it line by line.
+// The file has two parts:
+//   SECTION 1: NODES   ->  Room-Name, X, Y
+//   SECTION 2: EDGES   ->  From, To, Weight
+// Older files without section headers only contain edges.
+// Rooms go straight into nodePositions; paths are kept in pendingEdges until the graph is built.
+bool CampusGis::parseMapFile(const string& filePath) {
+    nodePositions.clear();
+    pendingEdges.clear();
+
     QString qFilePath = QString::fromStdString(filePath);
     QFile file(qFilePath);
 
@@ -20,38 +163,212 @@ bool CampusGis::loadMapData(const string& filePath) {
     }
 
     QTextStream in(&file);
-    // Skip the header line if it exists
-    if (!in.atEnd()) {
-        QString firstLine = in.readLine();
-        if (!firstLine.startsWith("#")) { in.seek(0); }
-    }
+    int mode = 0;  // 0 = no section seen yet (old edge-only files), 1 = nodes, 2 = edges
 
     // Read the file until the end
     while (!in.atEnd()) {
-        QString line = in.readLine();
+        QString line = in.readLine().trimmed();
+        if (line.isEmpty()) continue;
+
+        // Check which section we're in
+        if (line.contains("SECTION 1: NODES", Qt::CaseInsensitive)) { mode = 1; continue; }
+        if (line.contains("SECTION 2: EDGES", Qt::CaseInsensitive)) { mode = 2; continue; }
+        if (line.startsWith("#")) continue;  // Skip comments
+
         QStringList parts = line.split(',');
+        if (parts.size() < 3) continue;
 
-        // If we found a line with 3 parts (From, To, Weight), it's a path!
-        if (parts.size() == 3) {
-            string from = parts[0].toStdString();
-            string to = parts[1].toStdString();
+        if (mode == 1) {
+            // A room and where it is drawn
+            string id = parts[0].trimmed().toStdString();
+            nodePositions[id] = {parts[1].trimmed().toDouble(), parts[2].trimmed().toDouble()};
+        } else {
+            // If we found a line with 3 parts (From, To, Weight), it's a path!
             bool ok;
-            int weight = parts[2].toInt(&ok);
+            int weight = parts[2].trimmed().toInt(&ok);
             if (ok) {
-                // Tell the brain (Graph) about this connection
-                campusGraph.addEdge(from, to, weight);
+                pendingEdges.push_back({parts[0].trimmed().toStdString(), parts[1].trimmed().toStdString(), weight});
             }
         }
     }
 
     file.close();
     qInfo() << "Successfully loaded detailed map data from" << qFilePath;
+    return true;
+}
 
-    // Now organize the names for the tree
-    buildLocationTree();
+// Reads a packed map the same way parseMapFile reads a CSV file (but there is no text to parse)
+bool CampusGis::unpackMap(const PackedMap& map) {
+    nodePositions.clear();
+    pendingEdges.clear();
+    for (uint32_t room = 0; room < map.roomCount; ++room) {
+        if (map.hasPosition(room)) nodePositions[map.roomName(room)] = {map.x[room], map.y[room]};
+    }
+    // Every hallway is stored from both ends; take it from the end with the smaller number
+    pendingEdges.reserve(map.edgeCount / 2);
+    for (uint32_t u = 0; u < map.nodeCount; ++u) {
+        for (int32_t e = map.offsets[u]; e < map.offsets[u + 1]; ++e) {
+            uint32_t v = static_cast<uint32_t>(map.targets[e]);
+            if (u < v) pendingEdges.push_back({map.roomName(u), map.roomName(v), map.weights[e]});
+        }
+    }
     return true;
 }
 
+// The tables written by campus_embed, seen as a PackedMap
+const PackedMap* CampusGis::embeddedMap() {
+#ifdef CAMPUS_EMBEDDED_MAP
+    static const PackedMap map = []() {
+        namespace E = EmbeddedCampusMap;
+        PackedMap m;
+        m.nodeCount = E::kNodeCount;
+        m.roomCount = E::kRoomCount;
+        m.edgeCount = E::kEdgeCount;
+        m.offsets = E::kOffsets;
+        m.targets = E::kTargets;
+        m.weights = E::kWeights;
+        m.nameStart = E::kNameStart;
+        m.nameChars = E::kNameChars;
+        m.x = E::kX;
+        m.y = E::kY;
+        m.hashSalt = E::kHashSalt;
+        m.hashBuckets = E::kHashBuckets;
+        m.hashSlotCount = E::kHashSlotCount;
+        m.hashSeeds = E::kHashSeeds;
+        m.hashSlots = E::kHashSlots;
+        m.componentCount = E::kComponentCount;
+        m.component = E::kComponent;
+        m.componentSizes = E::kComponentSizes;
+        return m;
+    }();
+    return &map;
+#else
+    return nullptr;
+#endif
+}
+
+// campus_embed keeps the fingerprint of the file it read (kSourceHash); any edit changes it
+bool CampusGis::isEmbeddedMap(const string& filePath) {
+#ifdef CAMPUS_EMBEDDED_MAP
+    QFile file(QString::fromStdString(filePath));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    QByteArray bytes = file.readAll();
+    return PackedMap::hashBytes(bytes.constData(), static_cast<size_t>(bytes.size())) == EmbeddedCampusMap::kSourceHash;
+#else
+    (void)filePath;
+    return false;
+#endif
+}
+
+// Tell the brain (Graph) about every connection we read, then hand the searches a frozen copy
+void CampusGis::freezeGraph() {
+    campusGraph = Graph();
+    for (const MapEdgeRecord& edge : pendingEdges) {
+        campusGraph.addEdge(edge.from, edge.to, edge.weight);
+    }
+
+    // Hallways listed twice would be looked at twice by every search; keep the shortest copy
+    Graph::EdgeCleanup cleanup = campusGraph.removeDuplicateEdges();
+    if (cacheState == CacheState::Hit) cleanup = cachedCleanup;  // Cleaned up before it was cached
+    validation = MapValidationReport();
+    validation.duplicateEdges = cleanup.duplicates;
+    validation.conflictingWeights = cleanup.conflictingWeights;
+    validation.selfLoops = cleanup.selfLoops;
+
+    lock_guard<mutex> lock(closureMutex);
+    publishSnapshot();
+}
+
+// Looks for mistakes in the map file right after loading, instead of finding them later as
+// routes that never come back or rooms drawn in the top-left corner
+void CampusGis::validateMap() {
+    const auto& adjList = campusGraph.getGraphData();
+
+    // Rooms in the NODES section that no hallway touches
+    validation.orphans.clear();
+    for (const auto& pair : nodePositions) {
+        auto it = adjList.find(pair.first);
+        if (it == adjList.end() || it->second.empty()) validation.orphans.push_back(pair.first);
+    }
+    // Rooms in the EDGES section without a position (old edge-only files have no positions at all)
+    validation.dangling.clear();
+    if (!nodePositions.empty()) {
+        for (const auto& pair : adjList) {
+            if (!nodePositions.count(pair.first)) validation.dangling.push_back(pair.first);
+        }
+    }
+
+    // The snapshot already knows which rooms are connected (closures were cleared on load)
+    GraphSnapshotStore::Reader graph = snapshots.read();
+    validation.components = graph ? graph->componentCount() : 0;
+    validation.largestComponent = 0;
+    for (int c = 0; c < validation.components; ++c) {
+        validation.largestComponent = max(validation.largestComponent, graph->componentSize(c));
+    }
+
+    // Report what we found
+    auto someRooms = [](const vector<string>& rooms) {
+        QStringList shown;
+        for (size_t i = 0; i < rooms.size() && i < kReportedRooms; ++i) shown << QString::fromStdString(rooms[i]);
+        if (rooms.size() > kReportedRooms) shown << "...";
+        return shown.join(", ");
+    };
+    if (validation.duplicateEdges > 0) {
+        qWarning().noquote() << QString("Map check: %1 hallway(s) listed more than once (%2 with different weights); kept the shortest")
+                                .arg(validation.duplicateEdges).arg(validation.conflictingWeights);
+    }
+    if (validation.selfLoops > 0) {
+        qWarning().noquote() << QString("Map check: dropped %1 hallway(s) leading back to the same room").arg(validation.selfLoops);
+    }
+    if (!validation.orphans.empty()) {
+        qWarning().noquote() << QString("Map check: %1 room(s) have no hallways: %2")
+                                .arg(validation.orphans.size()).arg(someRooms(validation.orphans));
+    }
+    if (!validation.dangling.empty()) {
+        qWarning().noquote() << QString("Map check: %1 room(s) have no position: %2")
+                                .arg(validation.dangling.size()).arg(someRooms(validation.dangling));
+    }
+    if (validation.components > 1) {
+        qInfo().noquote() << QString("Map check: the map has %1 separate parts (the biggest has %2 of %3 rooms)")
+                             .arg(validation.components).arg(validation.largestComponent).arg(graph->nodeCount());
+    }
+}
+
+const MapValidationReport& CampusGis::getValidationReport() const {
+    return validation;
+}
+
+// Build a snapshot of the current map + closures and make it the one searches use
+void CampusGis::publishSnapshot() {
+    // Nothing closed: a packed map can be searched as it is
+    if (packedBase && closedHallways.empty()) {
+        snapshots.publish(GraphSnapshot::attach(*packedBase, ++snapshotVersion, packedOwner));
+    } else if (packedBase) {
+        snapshots.publish(GraphSnapshot::build(*packedBase, closedHallways, ++snapshotVersion));
+    } else {
+        snapshots.publish(GraphSnapshot::build(campusGraph, closedHallways, ++snapshotVersion));
+    }
+
+    // Remembered routes are only right while every hallway is open
+    warmVersion = closedHallways.empty() ? snapshotVersion : 0;
+}
+
+GraphSnapshotStore::Reader CampusGis::readGraph() const {
+    return snapshots.read();
+}
+
+future<uint64_t> CampusGis::setHallwayClosed(const string& a, const string& b, bool closed) {
+    // The copy is built on a worker; searches keep running on the old snapshot meanwhile
+    return getWorkers().submit([this, a, b, closed]() {
+        lock_guard<mutex> lock(closureMutex);
+        auto key = a < b ? make_pair(a, b) : make_pair(b, a);
+        if (closed) closedHallways.insert(key);
+        else closedHallways.erase(key);
+        publishSnapshot();
+        return snapshotVersion;
+    });
+}
+
 const Graph& CampusGis::getGraph() const {
     return campusGraph;
 }
@@ -60,10 +377,381 @@ const LocationTree& CampusGis::getLocationTree() const {
     return locationTree;
 }
 
-// Takes all the messy node names and files them neatly into the tree
+const LocationIndex& CampusGis::getLocationIndex() const {
+    return locationIndex;
+}
+
+const map<string, MapPosition>& CampusGis::getNodePositions() const {
+    return nodePositions;
+}
+
+// Takes all the messy node names and files them neatly into the tree.
+// Works from the parsed paths (not the graph), so it can run while the graph is being built.
 void CampusGis::buildLocationTree() {
-    vector<string> nodes = campusGraph.getNodes();
+    vector<string> nodes;
+    nodes.reserve(pendingEdges.size() * 2);
+    for (const MapEdgeRecord& edge : pendingEdges) {
+        nodes.push_back(edge.from);
+        nodes.push_back(edge.to);
+    }
+    sort(nodes.begin(), nodes.end());
+    nodes.erase(unique(nodes.begin(), nodes.end()), nodes.end());
+
+    locationTree = LocationTree();
+    locationTree.reserve(nodes.size());
     for (const string& nodeName : nodes) {
         locationTree.addLocation(nodeName);
     }
+    locationTree.finish();
+}
+
+// Works out once which rooms can be picked and in which area's list they appear
+void CampusGis::buildLocationIndex() {
+    vector<string> nodes;
+    nodes.reserve(pendingEdges.size() * 2);
+    for (const MapEdgeRecord& edge : pendingEdges) {
+        nodes.push_back(edge.from);
+        nodes.push_back(edge.to);
+    }
+    locationIndex.build(nodes);  // Drops duplicates itself
+}
+
+// ====================================================================
+// == MAP CACHE
+// ====================================================================
+
+void CampusGis::setCacheDirectory(const string& directory) {
+    if (directory.empty()) cache.reset();
+    else cache = make_unique<MapCache>(directory);
+}
+
+// True if 'route' is still a shortest route on 'graph': every hallway exists, the weights add up,
+// and a fresh search finds nothing shorter. The routes file is keyed by the map file, but this
+// keeps a hand-edited (or damaged) one from giving wrong answers. It costs one search per
+// remembered route, once per load.
+static bool routeHolds(const GraphSnapshot& graph, const WarmRoute& route) {
+    const PackedMap& map = graph.packedMap();
+    if (route.path.empty()) return false;
+    int previous = map.find(route.path[0]);
+    if (previous < 0) return false;
+    long long total = 0;
+    for (size_t i = 1; i < route.path.size(); ++i) {
+        int room = map.find(route.path[i]);
+        if (room < 0) return false;
+        int weight = -1;
+        for (int32_t e = map.offsets[previous]; e < map.offsets[previous + 1] && weight < 0; ++e) {
+            if (map.targets[e] == room) weight = map.weights[e];
+        }
+        if (weight < 0) return false;
+        total += weight;
+        previous = room;
+    }
+    return total == route.distance && graph.dijkstra(route.path.front(), route.path.back()).second == route.distance;
+}
+
+// A map that was parsed gets its packed copy written for next time; either way, the routes
+// remembered from earlier runs are loaded
+void CampusGis::updateCache() {
+    if (cacheState == CacheState::Off) return;
+
+    if (cacheState == CacheState::Miss) {
+        PackedMapStorage storage;
+        storage.packGraph(campusGraph, {});
+        for (const auto& pair : nodePositions) storage.addPosition(pair.first, pair.second.x, pair.second.y);
+        Graph::EdgeCleanup cleanup;
+        cleanup.duplicates = validation.duplicateEdges;
+        cleanup.conflictingWeights = validation.conflictingWeights;
+        cleanup.selfLoops = validation.selfLoops;
+        cache->storeImage(storage.finish(), cleanup);
+    }
+
+    GraphSnapshotStore::Reader graph = snapshots.read();
+    if (!graph) return;
+    size_t dropped = 0;
+    for (WarmRoute& route : cache->loadRoutes()) {
+        if (!routeHolds(*graph.get(), route)) {
+            ++dropped;
+            continue;
+        }
+        // The file is sorted by count, so a shard that fills up has kept the most asked-for ones
+        WarmShard& shard = warmShardFor(route.path.front(), route.path.back());
+        lock_guard<mutex> lock(shard.mutex);
+        if (shard.legs.size() >= kMaxWarmLegs / kWarmShards) continue;
+        auto key = make_pair(route.path.front(), route.path.back());
+        shard.legs[key] = WarmLeg{route.count, route.distance, make_shared<const vector<string>>(move(route.path))};
+    }
+    if (dropped > 0) qWarning() << "Map cache: dropped" << dropped << "remembered route(s) that don't fit the map";
+}
+
+bool CampusGis::saveCache() {
+    if (!cache || cacheState == CacheState::Off) return false;
+
+    // The most asked-for legs first; counts keep adding up from run to run
+    vector<WarmRoute> routes;
+    for (WarmShard& shard : warmShards) {
+        lock_guard<mutex> lock(shard.mutex);
+        for (const auto& pair : shard.legs) routes.push_back({pair.second.count, pair.second.distance, *pair.second.path});
+    }
+    if (routes.empty()) return false;
+    size_t kept = min(routes.size(), kSavedWarmLegs);
+    partial_sort(routes.begin(), routes.begin() + kept, routes.end(),
+                 [](const WarmRoute& a, const WarmRoute& b) { return a.count > b.count; });
+    routes.resize(kept);
+    return cache->storeRoutes(routes);
+}
+
+// The shard is picked from both room names, so legs from one popular room still spread out
+CampusGis::WarmShard& CampusGis::warmShardFor(const string& from, const string& to) const {
+    size_t h = hash<string>()(from) * 31 + hash<string>()(to);
+    return warmShards[h % kWarmShards];
+}
+
+void CampusGis::clearWarmLegs() {
+    for (WarmShard& shard : warmShards) {
+        lock_guard<mutex> lock(shard.mutex);
+        shard.legs.clear();
+        shard.misses.clear();
+    }
+    warmVersion = 0;
+}
+
+// A leg that was just searched for. It gets in right away while the shard has room; after that
+// only by being asked for more often than the least asked-for leg, which it then replaces.
+void CampusGis::rememberLeg(WarmShard& shard, const string& from, const string& to,
+                            const pair<vector<string>, int>& leg) const {
+    auto key = make_pair(from, to);
+    lock_guard<mutex> lock(shard.mutex);
+    if (shard.legs.size() < kMaxWarmLegs / kWarmShards) {
+        shard.legs.emplace(key, WarmLeg{1, leg.second, make_shared<const vector<string>>(leg.first)});
+        return;
+    }
+
+    uint64_t asked = ++shard.misses[key];
+    auto weakest = min_element(shard.legs.begin(), shard.legs.end(),
+                               [](const auto& a, const auto& b) { return a.second.count < b.second.count; });
+    if (asked > weakest->second.count) {
+        shard.legs.erase(weakest);
+        shard.legs.emplace(key, WarmLeg{asked, leg.second, make_shared<const vector<string>>(leg.first)});
+        shard.misses.erase(key);
+    } else if (shard.misses.size() > kMaxWarmMisses / kWarmShards) {
+        // Halve every count and forget the ones that reach zero, so old bursts fade out
+        for (auto it = shard.misses.begin(); it != shard.misses.end();) {
+            it->second /= 2;
+            if (it->second == 0) it = shard.misses.erase(it);
+            else ++it;
+        }
+    }
+}
+
+// ====================================================================
+// == ROUTING
+// ====================================================================
+
+// Source -> (Via) -> Dest. With a via stop we search two "legs" and glue them together.
+RouteResult CampusGis::findRoute(const RouteRequest& request, const atomic<bool>* cancel) const {
+    TraceSpan span("findShortestPath", "route");
+    RouteResult result;
+    auto started = chrono::steady_clock::now();
+    ActiveSearchProbe probe;
+    bool treeHit = false;
+    bool warmHit = false;
+
+    // Both legs use the same snapshot, even if an edit is published halfway through
+    GraphSnapshotStore::Reader graph = snapshots.read();
+    if (!graph) return result;
+    bool useVia = !request.via.empty() && request.via != request.source && request.via != request.dest;
+
+    if (!useVia) {
+        auto leg = findLeg(*graph.get(), request.source, request.dest, cancel, probe, treeHit, warmHit);
+        result.path = leg.first;
+        result.distance = leg.second;
+    } else {
+        auto leg1 = findLeg(*graph.get(), request.source, request.via, cancel, probe, treeHit, warmHit);
+        auto leg2 = findLeg(*graph.get(), request.via, request.dest, cancel, probe, treeHit, warmHit);
+        if (leg1.second != -1 && leg2.second != -1) {
+            result.distance = leg1.second + leg2.second;
+            result.path = leg1.first;
+            result.path.pop_back();  // The via room is also the first room of leg 2
+            result.path.insert(result.path.end(), leg2.first.begin(), leg2.first.end());
+        }
+    }
+
+    result.cancelled = cancel && cancel->load();
+    if (result.cancelled) {
+        result.path.clear();
+        result.distance = -1;
+    }
+
+    double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - started).count();
+    searchStats.record(probe, micros, treeHit, warmHit);
+    return result;
+}
+
+future<RouteResult> CampusGis::findRouteAsync(const RouteRequest& request, CancelToken cancel,
+                                              function<void(size_t, size_t)> progress,
+                                              function<void(const RouteResult&)> done) {
+    return getWorkers().submit([this, request, cancel, progress, done]() {
+        if (progress) progress(0, 1);
+        RouteResult result = findRoute(request, cancel.get());
+        if (progress) progress(1, 1);
+        if (done) done(result);
+        return result;
+    });
+}
+
+// Every request becomes its own job, so all CPU cores help with a big batch
+future<vector<RouteResult>> CampusGis::findRoutesAsync(const vector<RouteRequest>& requests, CancelToken cancel,
+                                                       function<void(size_t, size_t)> progress) {
+    struct Batch {
+        vector<RouteResult> results;
+        atomic<size_t> finished{0};
+        promise<vector<RouteResult>> whenDone;
+    };
+    auto batch = make_shared<Batch>();
+    batch->results.resize(requests.size());
+    future<vector<RouteResult>> allDone = batch->whenDone.get_future();
+
+    if (requests.empty()) {
+        batch->whenDone.set_value({});
+        return allDone;
+    }
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        getWorkers().enqueue([this, batch, i, request = requests[i], cancel, progress, total = requests.size()]() {
+            // Once cancelled, the remaining jobs finish instantly
+            if (cancel && cancel->load()) batch->results[i].cancelled = true;
+            else batch->results[i] = findRoute(request, cancel.get());
+
+            size_t finished = ++batch->finished;
+            if (progress) progress(finished, total);
+            if (finished == total) batch->whenDone.set_value(move(batch->results));
+        });
+    }
+    return allDone;
+}
+
+// With a cache folder, legs asked for before (in this run or an earlier one) are answered
+// from memory, and new ones are remembered for next time
+pair<vector<string>, int> CampusGis::findLeg(const GraphSnapshot& graph, const string& from, const string& to,
+                                             const atomic<bool>* cancel, ActiveSearchProbe& probe, bool& treeHit,
+                                             bool& warmHit) const {
+    // Nothing is remembered for maps that won't be saved (an image, the compiled-in map), and
+    // nothing answers from memory while a hallway is closed
+    if (cacheState == CacheState::Off || graph.version() != warmVersion) {
+        return searchLeg(graph, from, to, cancel, probe, treeHit);
+    }
+
+    WarmShard& shard = warmShardFor(from, to);
+    shared_ptr<const vector<string>> path;
+    int distance = -1;
+    {
+        lock_guard<mutex> lock(shard.mutex);
+        auto it = shard.legs.find({from, to});
+        if (it != shard.legs.end()) {
+            ++it->second.count;
+            path = it->second.path;
+            distance = it->second.distance;
+        }
+    }
+    if (path) {
+        warmHit = true;  // No search was needed
+        return {*path, distance};
+    }
+
+    auto leg = searchLeg(graph, from, to, cancel, probe, treeHit);
+    if (leg.second >= 0) rememberLeg(shard, from, to, leg);
+    return leg;
+}
+
+// Paths can be walked in both directions, so a tree from either end of the leg works
+pair<vector<string>, int> CampusGis::searchLeg(const GraphSnapshot& graph, const string& from, const string& to,
+                                               const atomic<bool>* cancel, ActiveSearchProbe& probe, bool& treeHit) const {
+    if (auto tree = readyTreeFor(from, graph.version())) {
+        treeHit = true;
+        return tree->pathTo(to);
+    }
+    if (auto tree = readyTreeFor(to, graph.version())) {
+        treeHit = true;
+        auto leg = tree->pathTo(from);
+        reverse(leg.first.begin(), leg.first.end());
+        return leg;
+    }
+
+    // Each leg gets its own probe (phases are timed per search), then adds up into the route's
+    ActiveSearchProbe legProbe;
+    auto leg = graph.dijkstra(from, to, cancel, legProbe);
+    probe.add(legProbe);
+    return leg;
+}
+
+// Returns the cached tree for 'source' if it has finished computing (never waits for it,
+// so a search job can't get stuck behind a prefetch job queued on the same workers)
+shared_ptr<const ShortestPathTree> CampusGis::readyTreeFor(const string& source, uint64_t version) const {
+    lock_guard<mutex> lock(treeCacheMutex);
+    for (auto it = treeCache.begin(); it != treeCache.end(); ++it) {
+        if (it->source != source || it->version != version) continue;
+        if (it->tree.wait_for(chrono::seconds(0)) != future_status::ready) return nullptr;
+
+        // Used again: move it to the front so it is evicted last
+        treeCache.splice(treeCache.begin(), treeCache, it);
+        return treeCache.front().tree.get();
+    }
+    return nullptr;
+}
+
+void CampusGis::prefetchFrom(const string& source) {
+    uint64_t version;
+    {
+        GraphSnapshotStore::Reader graph = snapshots.read();
+        if (source.empty() || !graph || graph->nodeId(source) < 0) return;
+        version = graph->version();
+    }
+
+    lock_guard<mutex> lock(treeCacheMutex);
+    for (auto it = treeCache.begin(); it != treeCache.end(); ++it) {
+        if (it->source != source) continue;
+        if (it->version == version) return;  // Already cached or being computed
+        treeCache.erase(it);                 // Built before an edit; replace it
+        break;
+    }
+
+    TreeFuture tree = getWorkers().submit([this, source, version]() -> shared_ptr<const ShortestPathTree> {
+        TraceSpan span("prefetch shortest-path tree", "route", source);
+        GraphSnapshotStore::Reader graph = snapshots.read();
+        if (!graph || graph->version() != version) return nullptr;  // The map changed while we waited
+        return make_shared<const ShortestPathTree>(graph->shortestPathTree(source));
+    }).share();
+
+    treeCache.push_front({source, version, tree});
+    if (treeCache.size() > kTreeCacheSize) treeCache.pop_back();
+}
+
+void CampusGis::waitForPrefetches() const {
+    vector<TreeFuture> pending;
+    {
+        lock_guard<mutex> lock(treeCacheMutex);
+        for (const CachedTree& cached : treeCache) pending.push_back(cached.tree);
+    }
+    for (const TreeFuture& tree : pending) tree.wait();
+}
+
+string CampusGis::searchStatsReport() const {
+    return searchStats.report();
+}
+
+void CampusGis::resetSearchStats() {
+    searchStats.reset();
+}
+
+void CampusGis::shutdownWorkers() {
+    workerPool.reset();
+}
+
+CancelToken CampusGis::makeCancelToken() {
+    return make_shared<atomic<bool>>(false);
+}
+
+ThreadPool& CampusGis::getWorkers() {
+    if (!workerPool) workerPool = make_unique<ThreadPool>(workerCount);
+    return *workerPool;
 }
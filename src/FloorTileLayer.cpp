@@ -0,0 +1,254 @@
+#include "../../include/gui/FloorTileLayer.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QFontMetricsF>
+#include <cmath>
+#include <map>
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+// ====================================================================
+// == TILE SETTINGS
+// ====================================================================
+
+// Tiles are always this many pixels wide/high on screen
+static const int kTileSize = 256;
+
+// We keep pre-drawn tiles for a few zoom levels and pick the closest one.
+// (Zoomed out = 0.25, normal = 1.0, zoomed in = 2.0)
+static const qreal kZoomLevels[] = { 0.25, 0.5, 1.0, 2.0 };
+static const int kZoomLevelCount = sizeof(kZoomLevels) / sizeof(kZoomLevels[0]);
+
+// Keep at most ~64 MB of tiles per floor (each 256x256 tile is 256 KB)
+static const int kTileCacheKB = 64 * 1024;
+
+// Extra space around each label (QGraphicsTextItem used the same margin)
+static const qreal kLabelMargin = 4.0;
+
+// Size (in scene units) of one cell of the culling grid, and of one room block when zoomed out
+static const qreal kGridCell = 256.0;
+static const qreal kBlockCell = 160.0;
+
+// ====================================================================
+// == RECORDING THE STATIC MAP
+// ====================================================================
+
+FloorTileLayer::FloorTileLayer(const QRectF& bounds, const QColor& background)
+    : m_bounds(bounds), m_background(background), m_tiles(kTileCacheKB) {
+    // We need exposedRect in paint() so we only touch the visible tiles
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+void FloorTileLayer::addLine(const QLineF& line, const QPen& pen, Detail detail) {
+    Primitive prim;
+    prim.shape = Shape::Line;
+    prim.detail = detail;
+    prim.line = line;
+    prim.pen = pen;
+    qreal pad = pen.widthF() / 2 + 1;
+    prim.bounds = QRectF(line.p1(), line.p2()).normalized().adjusted(-pad, -pad, pad, pad);
+    m_primitives.push_back(prim);
+}
+
+void FloorTileLayer::addRect(const QRectF& rect, const QPen& pen, const QBrush& brush, Detail detail) {
+    Primitive prim;
+    prim.shape = Shape::Rect;
+    prim.detail = detail;
+    prim.rect = rect;
+    prim.pen = pen;
+    prim.brush = brush;
+    qreal pad = pen.widthF() / 2 + 1;
+    prim.bounds = rect.adjusted(-pad, -pad, pad, pad);
+    m_primitives.push_back(prim);
+}
+
+void FloorTileLayer::addEllipse(const QRectF& rect, const QPen& pen, const QBrush& brush, Detail detail) {
+    addRect(rect, pen, brush, detail);
+    m_primitives.back().shape = Shape::Ellipse;
+}
+
+// Labels are drawn centered on the room, on top of a white box so they stay readable
+void FloorTileLayer::addLabel(const QString& text, const QPointF& center, const QFont& font, Detail detail) {
+    QFontMetricsF fm(font);
+    QRectF textRect = fm.boundingRect(QRectF(), Qt::AlignCenter, text);
+    textRect.adjust(-kLabelMargin, -kLabelMargin, kLabelMargin, kLabelMargin);
+    textRect.moveCenter(center);
+
+    Primitive prim;
+    prim.shape = Shape::Label;
+    prim.detail = detail;
+    prim.rect = textRect;
+    prim.bounds = textRect;
+    prim.text = text;
+    prim.font = font;
+    m_primitives.push_back(prim);
+}
+
+void FloorTileLayer::addPixmap(const QRectF& rect, const QPixmap& pixmap, Detail detail) {
+    Primitive prim;
+    prim.shape = Shape::Pixmap;
+    prim.detail = detail;
+    prim.rect = rect;
+    prim.bounds = rect;
+    prim.pixmap = pixmap;
+    m_primitives.push_back(prim);
+}
+
+// Chop the floor into kBlockCell squares and draw one block per square
+// around all the room boxes whose centers fall inside it
+void FloorTileLayer::aggregateRoomBlocks(const QBrush& blockBrush) {
+    map<pair<int, int>, QRectF> blocks;
+    for (const Primitive& prim : m_primitives) {
+        if (prim.shape != Shape::Rect || prim.detail != Detail::Rooms) continue;
+        QPointF c = prim.rect.center();
+        pair<int, int> cell(static_cast<int>(floor(c.x() / kBlockCell)), static_cast<int>(floor(c.y() / kBlockCell)));
+        QRectF& block = blocks[cell];
+        block = block.isNull() ? prim.rect : block.united(prim.rect);
+    }
+    for (const auto& pair : blocks) {
+        addRect(pair.second, QPen(Qt::black, 1), blockBrush, Detail::Overview);
+    }
+}
+
+void FloorTileLayer::invalidateTiles() {
+    m_tiles.clear();
+    m_indexDirty = true;
+    update();
+}
+
+// ====================================================================
+// == PAINTING (copying tiles to the screen)
+// ====================================================================
+
+QRectF FloorTileLayer::boundingRect() const {
+    return m_bounds;
+}
+
+// Pick the smallest cached zoom level that is still at least as sharp as the screen
+int FloorTileLayer::zoomLevelFor(qreal levelOfDetail) const {
+    for (int i = 0; i < kZoomLevelCount; ++i) {
+        if (kZoomLevels[i] >= levelOfDetail) return i;
+    }
+    return kZoomLevelCount - 1;
+}
+
+// Decide if a primitive belongs in a tile drawn at this zoom scale
+bool FloorTileLayer::isVisibleAt(Detail detail, qreal scale) const {
+    switch (detail) {
+    case Detail::Overview: return scale < 0.5;
+    case Detail::Rooms: return scale >= 0.5;
+    case Detail::Fine: return scale >= 1.0;
+    default: return true;
+    }
+}
+
+// Put every primitive into the grid cells it touches (done once, on the first paint)
+void FloorTileLayer::buildSpatialIndex() const {
+    vector<SpatialGrid::Box> boxes;
+    boxes.reserve(m_primitives.size());
+    for (const Primitive& prim : m_primitives) {
+        const QRectF& b = prim.bounds;
+        boxes.push_back({b.left(), b.top(), b.right(), b.bottom()});
+    }
+    m_grid.build(boxes, kGridCell);
+    m_indexDirty = false;
+}
+
+void FloorTileLayer::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget*) {
+    qreal lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    int level = zoomLevelFor(lod);
+    qreal scale = kZoomLevels[level];
+    qreal tileSpan = kTileSize / scale;  // Size of one tile in scene units
+
+    QRectF exposed = option->exposedRect.intersected(m_bounds);
+    if (exposed.isEmpty()) return;
+
+    // Which tiles overlap the part of the map that needs repainting?
+    int firstCol = static_cast<int>(floor((exposed.left() - m_bounds.left()) / tileSpan));
+    int lastCol = static_cast<int>(floor((exposed.right() - m_bounds.left()) / tileSpan));
+    int firstRow = static_cast<int>(floor((exposed.top() - m_bounds.top()) / tileSpan));
+    int lastRow = static_cast<int>(floor((exposed.bottom() - m_bounds.top()) / tileSpan));
+
+    painter->save();
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int col = firstCol; col <= lastCol; ++col) {
+            QRectF tileRect(m_bounds.left() + col * tileSpan, m_bounds.top() + row * tileSpan, tileSpan, tileSpan);
+
+            // Reuse the tile if we drew it before, otherwise draw it now and remember it
+            quint64 key = (quint64(level) << 48) | (quint64(row & 0xFFFFFF) << 24) | quint64(col & 0xFFFFFF);
+            QPixmap tile;
+            if (QPixmap* cached = m_tiles.object(key)) {
+                tile = *cached;
+            } else {
+                tile = renderTile(tileRect, scale);
+                m_tiles.insert(key, new QPixmap(tile), kTileSize * kTileSize * 4 / 1024);
+            }
+
+            // Only copy the part of the tile that lies inside the map
+            QRectF target = tileRect.intersected(m_bounds);
+            QRectF source((target.left() - tileRect.left()) * scale, (target.top() - tileRect.top()) * scale,
+                          target.width() * scale, target.height() * scale);
+            painter->drawPixmap(target, tile, source);
+        }
+    }
+
+    painter->restore();
+}
+
+// Draw one tile from the recorded primitives
+QPixmap FloorTileLayer::renderTile(const QRectF& tileRect, qreal scale) const {
+    QPixmap pixmap(kTileSize, kTileSize);
+    pixmap.fill(m_background);
+
+    QPainter p(&pixmap);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.setRenderHint(QPainter::TextAntialiasing);
+    p.scale(scale, scale);
+    p.translate(-tileRect.topLeft());
+
+    if (m_indexDirty) buildSpatialIndex();
+
+    // Collect the primitives touching this tile from the grid (culling everything else).
+    // They come back in the order they were added, so later ones still draw on top.
+    QRectF area = tileRect.intersected(m_bounds);
+    vector<uint32_t> candidates;
+    if (!area.isEmpty()) m_grid.query({area.left(), area.top(), area.right(), area.bottom()}, candidates);
+
+    for (uint32_t i : candidates) {
+        const Primitive& prim = m_primitives[i];
+        if (!isVisibleAt(prim.detail, scale)) continue;
+        drawPrimitive(&p, prim);
+    }
+    return pixmap;
+}
+
+void FloorTileLayer::drawPrimitive(QPainter* painter, const Primitive& prim) const {
+    switch (prim.shape) {
+    case Shape::Line:
+        painter->setPen(prim.pen);
+        painter->drawLine(prim.line);
+        break;
+    case Shape::Rect:
+        painter->setPen(prim.pen);
+        painter->setBrush(prim.brush);
+        painter->drawRect(prim.rect);
+        break;
+    case Shape::Ellipse:
+        painter->setPen(prim.pen);
+        painter->setBrush(prim.brush);
+        painter->drawEllipse(prim.rect);
+        break;
+    case Shape::Label:
+        painter->fillRect(prim.rect, Qt::white);
+        painter->setFont(prim.font);
+        painter->setPen(Qt::black);
+        painter->drawText(prim.rect, Qt::AlignCenter, prim.text);
+        break;
+    case Shape::Pixmap:
+        painter->drawPixmap(prim.rect, prim.pixmap, QRectF(prim.pixmap.rect()));
+        break;
+    }
+}
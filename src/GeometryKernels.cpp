@@ -0,0 +1,100 @@
+#include "../../include/core/GeometryKernels.h"
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define GEOMETRY_SSE2 1
+#endif
+using namespace std;
+
+// ====================================================================
+// == DISTANCES
+// ====================================================================
+
+void GeometryKernels::distances(const double* ax, const double* ay, const double* bx, const double* by,
+                                size_t count, double* out) {
+    size_t i = 0;
+#ifdef GEOMETRY_SSE2
+    // Two hallways per step
+    for (; i + 2 <= count; i += 2) {
+        __m128d dx = _mm_sub_pd(_mm_loadu_pd(bx + i), _mm_loadu_pd(ax + i));
+        __m128d dy = _mm_sub_pd(_mm_loadu_pd(by + i), _mm_loadu_pd(ay + i));
+        __m128d squared = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+        _mm_storeu_pd(out + i, _mm_sqrt_pd(squared));
+    }
+#endif
+    // The rest (or everything, without SSE2)
+    for (; i < count; ++i) {
+        double dx = bx[i] - ax[i];
+        double dy = by[i] - ay[i];
+        out[i] = sqrt(dx * dx + dy * dy);
+    }
+}
+
+// ====================================================================
+// == BOUNDING BOX
+// ====================================================================
+
+bool GeometryKernels::bounds(const double* x, const double* y, size_t count, GeometryBounds& out) {
+    if (count == 0) return false;
+    double minX = x[0], minY = y[0], maxX = x[0], maxY = y[0];
+    size_t i = 0;
+#ifdef GEOMETRY_SSE2
+    if (count >= 2) {
+        // Keep two running minimums/maximums side by side, then combine them at the end
+        __m128d loX = _mm_loadu_pd(x), hiX = loX;
+        __m128d loY = _mm_loadu_pd(y), hiY = loY;
+        for (i = 2; i + 2 <= count; i += 2) {
+            __m128d px = _mm_loadu_pd(x + i);
+            __m128d py = _mm_loadu_pd(y + i);
+            loX = _mm_min_pd(loX, px); hiX = _mm_max_pd(hiX, px);
+            loY = _mm_min_pd(loY, py); hiY = _mm_max_pd(hiY, py);
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, loX); minX = min(lanes[0], lanes[1]);
+        _mm_storeu_pd(lanes, hiX); maxX = max(lanes[0], lanes[1]);
+        _mm_storeu_pd(lanes, loY); minY = min(lanes[0], lanes[1]);
+        _mm_storeu_pd(lanes, hiY); maxY = max(lanes[0], lanes[1]);
+    }
+#endif
+    for (; i < count; ++i) {
+        minX = min(minX, x[i]); maxX = max(maxX, x[i]);
+        minY = min(minY, y[i]); maxY = max(maxY, y[i]);
+    }
+    out = {minX, minY, maxX, maxY};
+    return true;
+}
+
+// ====================================================================
+// == WEIGHT CHECK
+// ====================================================================
+
+GeometryKernels::WeightCheck GeometryKernels::checkWeights(const double* lengths, const int* weights, size_t count,
+                                                           double tolerance) {
+    WeightCheck check;
+
+    // Drawn length per weight unit of every hallway (hallways without a weight or length are skipped:
+    // a 0 weight means "same spot", and rooms without a position are drawn at 0,0)
+    vector<double> ratio(count, 0.0);
+    vector<double> usable;
+    usable.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (weights[i] > 0 && lengths[i] > 0) {
+            ratio[i] = lengths[i] / weights[i];
+            usable.push_back(ratio[i]);
+        }
+    }
+    check.checked = usable.size();
+    if (usable.empty()) return check;
+
+    // The median is the "typical" scale of the map; a few wrong weights can't move it much
+    nth_element(usable.begin(), usable.begin() + usable.size() / 2, usable.end());
+    check.lengthPerWeight = usable[usable.size() / 2];
+
+    double low = check.lengthPerWeight / tolerance;
+    double high = check.lengthPerWeight * tolerance;
+    for (size_t i = 0; i < count; ++i) {
+        if (ratio[i] > 0 && (ratio[i] < low || ratio[i] > high)) check.mismatches.push_back(i);
+    }
+    return check;
+}
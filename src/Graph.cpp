@@ -13,79 +13,198 @@ void Graph::addEdge(const string& from, const string& to, int weight) {
     adjList[to].push_back({from, weight});
 }
 
+// Sorting each room's neighbors puts the copies of a hallway next to each other, shortest first
+Graph::EdgeCleanup Graph::removeDuplicateEdges() {
+    EdgeCleanup cleanup;
+    for (auto& pair : adjList) {
+        const string& room = pair.first;
+        auto& neighbors = pair.second;
+        sort(neighbors.begin(), neighbors.end());
+
+        size_t kept = 0;
+        for (size_t i = 0; i < neighbors.size(); ++i) {
+            const string& other = neighbors[i].first;
+            if (other == room) {
+                // addEdge(a, a) stores the loop twice in a's own list
+                if (i + 1 < neighbors.size() && neighbors[i + 1].first == room) ++i;
+                ++cleanup.selfLoops;
+                continue;
+            }
+            if (kept > 0 && neighbors[kept - 1].first == other) {
+                // Both rooms see the same copies, so only count them from the smaller name's side
+                if (room < other) {
+                    ++cleanup.duplicates;
+                    if (neighbors[i].second != neighbors[kept - 1].second) ++cleanup.conflictingWeights;
+                }
+                continue;
+            }
+            if (kept != i) neighbors[kept] = move(neighbors[i]);
+            ++kept;
+        }
+        neighbors.resize(kept);
+    }
+    return cleanup;
+}
+
+pair<vector<string>, int> Graph::dijkstra(const string& start, const string& end, const atomic<bool>* cancel) const {
+    NoSearchProbe probe;
+    return dijkstra(start, end, cancel, probe);
+}
+
 // THE BIG ALGORITHM: Dijkstra's Shortest Path
-// pair<vector<string>, int> Graph::dijkstra(const string& start, const string& end) const {
-//     // If we don't know these rooms, give up immediately.
-//     if (adjList.find(start) == adjList.end() || adjList.find(end) == adjList.end()) {
-//         return {{}, -1};
-//     }
+// 'cancel' lets another thread ask us to give up early (checked every few hundred steps).
+// 'probe' counts what we do; with NoSearchProbe those calls compile to nothing.
+template <typename Probe>
+pair<vector<string>, int> Graph::dijkstra(const string& start, const string& end, const atomic<bool>* cancel,
+                                          Probe& probe) const {
+    probe.phase(SearchPhase::Setup);
 
-//     // Scorecard: How far is each room? Start with "Infinity" for everyone.
-//     map<string, int> distances;
-//     // Breadcrumbs: To remember the path, we store "Who sent me here?"
-//     map<string, string> predecessors;
+    // If we don't know these rooms, give up immediately.
+    if (adjList.find(start) == adjList.end() || adjList.find(end) == adjList.end()) {
+        probe.finish();
+        return {{}, -1};
+    }
 
-//     // Priority Queue: A magic to-do list that always keeps the CLOSEST room at the top.
-//     priority_queue<pair<int, string>,
-//                    vector<pair<int, string>>,
-//                    greater<pair<int, string>>> pq;
+    // Scorecard: How far is each room? Start with "Infinity" for everyone.
+    map<string, int> distances;
+    // Breadcrumbs: To remember the path, we store "Who sent me here?"
+    map<string, string> predecessors;
 
-//     for (const auto& pair : adjList) {
-//         distances[pair.first] = numeric_limits<int>::max();
-//     }
+    // Priority Queue: A magic to-do list that always keeps the CLOSEST room at the top.
+    priority_queue<pair<int, string>,
+                   vector<pair<int, string>>,
+                   greater<pair<int, string>>> pq;
 
-//     // Distance to self is 0.
-//     distances[start] = 0;
-//     pq.push({0, start});
+    for (const auto& pair : adjList) {
+        distances[pair.first] = numeric_limits<int>::max();
+    }
 
-//     while (!pq.empty()) {
-//         // Get the closest room from the list
-//         int current_dist = pq.top().first;
-//         string u = pq.top().second;
-//         pq.pop();
+    // Distance to self is 0.
+    distances[start] = 0;
+    pq.push({0, start});
+    probe.pushed();
+    probe.phase(SearchPhase::Search);
 
-//         // If we found a faster way to this room already, skip this stale entry
-//         if (current_dist > distances[u]) {
-//             continue;
-//         }
+    size_t steps = 0;
+    while (!pq.empty()) {
+        // Somebody asked us to stop (e.g. the user started a new search)
+        if (cancel && (++steps & 255) == 0 && cancel->load(memory_order_relaxed)) {
+            probe.finish();
+            return {{}, -1};
+        }
 
-//         // If we reached the destination, stop!
-//         if (u == end) break;
+        // Get the closest room from the list
+        int current_dist = pq.top().first;
+        string u = pq.top().second;
+        pq.pop();
+        probe.popped();
 
-//         // Check all neighbors
-//         for (const auto& edge : adjList.at(u)) {
-//             string v = edge.first;
-//             int weight = edge.second;
+        // If we found a faster way to this room already, skip this stale entry
+        if (current_dist > distances[u]) {
+            probe.stalePop();
+            continue;
+        }
+        probe.settled();
 
-//             // If going through 'u' is faster than the old way to 'v'...
-//             if (distances.at(u) + weight < distances.at(v)) {
-//                 distances[v] = distances.at(u) + weight; // Update score
-//                 predecessors[v] = u; // Drop a breadcrumb
-//                 pq.push({distances[v], v}); // Add to to-do list
-//             }
-//         }
-//     }
+        // If we reached the destination, stop!
+        if (u == end) break;
 
-//     // If destination is still at Infinity distance, there is no path.
-//     if (distances.at(end) == numeric_limits<int>::max()) {
-//         return {{}, -1};
-//     }
+        // Check all neighbors
+        for (const auto& edge : adjList.at(u)) {
+            const string& v = edge.first;
+            int weight = edge.second;
 
-//     // Reconstruct the path by following breadcrumbs backwards from End to Start.
-//     vector<string> path;
-//     string current = end;
-//     while (current != start) {
-//         path.push_back(current);
-//         if (predecessors.find(current) == predecessors.end()) {
-//             return {{}, -1};
-//         }
-//         current = predecessors[current];
-//     }
-//     path.push_back(start);
-//     reverse(path.begin(), path.end()); // Flip it so it goes Start -> End
+            // If going through 'u' is faster than the old way to 'v'...
+            if (distances.at(u) + weight < distances.at(v)) {
+                distances[v] = distances.at(u) + weight; // Update score
+                predecessors[v] = u; // Drop a breadcrumb
+                pq.push({distances[v], v}); // Add to to-do list
+                probe.relaxed();
+                probe.pushed();
+            }
+        }
+    }
+    probe.phase(SearchPhase::Path);
 
-//     return {path, distances.at(end)};
-// }
+    // If destination is still at Infinity distance, there is no path.
+    if (distances.at(end) == numeric_limits<int>::max()) {
+        probe.finish();
+        return {{}, -1};
+    }
+
+    // Reconstruct the path by following breadcrumbs backwards from End to Start.
+    vector<string> path;
+    string current = end;
+    while (current != start) {
+        path.push_back(current);
+        if (predecessors.find(current) == predecessors.end()) {
+            probe.finish();
+            return {{}, -1};
+        }
+        current = predecessors[current];
+    }
+    path.push_back(start);
+    reverse(path.begin(), path.end()); // Flip it so it goes Start -> End
+
+    probe.finish();
+    return {path, distances.at(end)};
+}
+
+template pair<vector<string>, int> Graph::dijkstra(const string&, const string&, const atomic<bool>*, NoSearchProbe&) const;
+template pair<vector<string>, int> Graph::dijkstra(const string&, const string&, const atomic<bool>*, SearchCounters&) const;
+
+// Same idea as dijkstra(), but we never stop early: every reachable room gets its final distance.
+ShortestPathTree Graph::shortestPathTree(const string& start) const {
+    ShortestPathTree tree;
+    tree.source = start;
+    if (adjList.find(start) == adjList.end()) return tree;
+
+    priority_queue<pair<int, string>,
+                   vector<pair<int, string>>,
+                   greater<pair<int, string>>> pq;
+
+    tree.distances[start] = 0;
+    pq.push({0, start});
+
+    while (!pq.empty()) {
+        int current_dist = pq.top().first;
+        string u = pq.top().second;
+        pq.pop();
+
+        // Skip stale entries
+        if (current_dist > tree.distances[u]) continue;
+
+        for (const auto& edge : adjList.at(u)) {
+            const string& v = edge.first;
+            int candidate = current_dist + edge.second;
+
+            // Rooms we haven't seen yet count as "Infinity"
+            auto known = tree.distances.find(v);
+            if (known == tree.distances.end() || candidate < known->second) {
+                tree.distances[v] = candidate;
+                tree.parents[v] = u;
+                pq.push({candidate, v});
+            }
+        }
+    }
+    return tree;
+}
+
+// Follow the breadcrumbs from 'dest' back to the source
+pair<vector<string>, int> ShortestPathTree::pathTo(const string& dest) const {
+    auto found = distances.find(dest);
+    if (found == distances.end()) return {{}, -1};
+
+    vector<string> path;
+    string current = dest;
+    while (current != source) {
+        path.push_back(current);
+        current = parents.at(current);
+    }
+    path.push_back(source);
+    reverse(path.begin(), path.end());
+    return {path, found->second};
+}
 
 // // Simple Breadth-First Search
 // vector<string> Graph::bfs(const string& start, const string& end) const {
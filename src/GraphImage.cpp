@@ -0,0 +1,235 @@
+#include "../../include/core/GraphImage.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QByteArray>
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const char kMagic[8] = {'C', 'A', 'M', 'P', 'U', 'S', 'G', 'I'};
+const uint32_t kFormatVersion = 1;
+const uint32_t kByteOrderMark = 0x01020304;  // Reads back differently on a machine with the other byte order
+
+// The arrays of a PackedMap, in the order they are stored
+enum Section { kOffsets, kTargets, kWeights, kNameStart, kNameChars, kX, kY,
+               kHashSeeds, kHashSlots, kComponent, kComponentSizes, kSectionCount };
+
+struct ImageHeader {
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t byteOrder;
+    uint64_t sourceHash;
+    uint64_t hashSalt;
+    uint32_t nodeCount, roomCount, edgeCount;
+    uint32_t hashBuckets, hashSlotCount, componentCount;
+    struct {
+        uint64_t offset;  // From the start of the file; always a multiple of 8
+        uint64_t bytes;
+    } sections[kSectionCount];
+};
+
+// Where every array of 'map' is and how big it has to be
+struct SectionData {
+    const void* data;
+    uint64_t bytes;
+};
+
+void describe(const PackedMap& map, SectionData out[kSectionCount]) {
+    auto array = [](const void* data, uint64_t count, size_t itemSize) { return SectionData{data, count * itemSize}; };
+    out[kOffsets] = array(map.offsets, map.nodeCount + 1ull, sizeof(int32_t));
+    out[kTargets] = array(map.targets, map.edgeCount, sizeof(int32_t));
+    out[kWeights] = array(map.weights, map.edgeCount, sizeof(int32_t));
+    out[kNameStart] = array(map.nameStart, map.roomCount + 1ull, sizeof(uint32_t));
+    out[kNameChars] = array(map.nameChars, map.nameStart ? map.nameStart[map.roomCount] : 0, 1);
+    out[kX] = array(map.x, map.roomCount, sizeof(double));
+    out[kY] = array(map.y, map.roomCount, sizeof(double));
+    out[kHashSeeds] = array(map.hashSeeds, map.hashBuckets, sizeof(uint32_t));
+    out[kHashSlots] = array(map.hashSlots, map.hashSlotCount, sizeof(int32_t));
+    out[kComponent] = array(map.component, map.nodeCount, sizeof(int32_t));
+    out[kComponentSizes] = array(map.componentSizes, map.componentCount, sizeof(int32_t));
+}
+
+// The searches trust these arrays completely, so an image that got damaged (or was written by a
+// buggy tool) must be caught here, before anything reads outside of it
+bool consistent(const PackedMap& map, uint64_t nameBytes, string& error) {
+    if (map.nodeCount > map.roomCount) { error = "more rooms with hallways than rooms"; return false; }
+    if (map.offsets[0] != 0 || static_cast<uint32_t>(map.offsets[map.nodeCount]) != map.edgeCount) {
+        error = "hallway offsets don't add up";
+        return false;
+    }
+    for (uint32_t i = 0; i < map.nodeCount; ++i) {
+        if (map.offsets[i] > map.offsets[i + 1]) { error = "hallway offsets go backwards"; return false; }
+    }
+    for (uint32_t e = 0; e < map.edgeCount; ++e) {
+        if (map.targets[e] < 0 || static_cast<uint32_t>(map.targets[e]) >= map.nodeCount) {
+            error = "hallway to a room that doesn't exist";
+            return false;
+        }
+    }
+
+    // Every hallway is stored from both ends with the same weight. Unpacking keeps only one end,
+    // so a one-sided hallway would route differently before and after a hallway is closed.
+    vector<tuple<uint32_t, uint32_t, int32_t>> forward, backward;
+    for (uint32_t u = 0; u < map.nodeCount; ++u) {
+        for (int32_t e = map.offsets[u]; e < map.offsets[u + 1]; ++e) {
+            uint32_t v = static_cast<uint32_t>(map.targets[e]);
+            if (u == v) { error = "hallway from a room back to itself"; return false; }
+            if (u < v) forward.emplace_back(u, v, map.weights[e]);
+            else backward.emplace_back(v, u, map.weights[e]);
+        }
+    }
+    sort(forward.begin(), forward.end());
+    sort(backward.begin(), backward.end());
+    if (forward != backward) { error = "hallway stored from one end only"; return false; }
+
+    if (map.nameStart[0] != 0 || map.nameStart[map.roomCount] != nameBytes) { error = "names don't add up"; return false; }
+    for (uint32_t i = 0; i < map.roomCount; ++i) {
+        if (map.nameStart[i] > map.nameStart[i + 1]) { error = "names go backwards"; return false; }
+    }
+    // Without a name table, rooms are found by a binary search over the rooms with hallways
+    if (map.hashBuckets == 0) {
+        for (uint32_t i = 0; i + 1 < map.nodeCount; ++i) {
+            string_view name(map.nameChars + map.nameStart[i], map.nameStart[i + 1] - map.nameStart[i]);
+            string_view next(map.nameChars + map.nameStart[i + 1], map.nameStart[i + 2] - map.nameStart[i + 1]);
+            if (!(name < next)) { error = "names out of order without a name table"; return false; }
+        }
+    }
+    if (map.hashBuckets > 0 && map.hashSlotCount == 0) { error = "name table without slots"; return false; }
+    for (uint32_t s = 0; s < map.hashSlotCount; ++s) {
+        if (map.hashSlots[s] < -1 || map.hashSlots[s] >= static_cast<int32_t>(map.nodeCount)) {
+            error = "name table points at a room that doesn't exist";
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < map.nodeCount; ++i) {
+        if (map.component[i] < 0 || static_cast<uint32_t>(map.component[i]) >= map.componentCount) {
+            error = "room in a component that doesn't exist";
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+// ====================================================================
+// == WRITING AN IMAGE
+// ====================================================================
+
+bool GraphImage::write(const string& path, const PackedMap& map, uint64_t sourceHash, string* error) {
+    ImageHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.formatVersion = kFormatVersion;
+    header.byteOrder = kByteOrderMark;
+    header.sourceHash = sourceHash;
+    header.hashSalt = map.hashSalt;
+    header.nodeCount = map.nodeCount;
+    header.roomCount = map.roomCount;
+    header.edgeCount = map.edgeCount;
+    header.hashBuckets = map.hashBuckets;
+    header.hashSlotCount = map.hashSlotCount;
+    header.componentCount = map.componentCount;
+
+    // Header first, then every array on its own 8-byte boundary
+    SectionData sections[kSectionCount];
+    describe(map, sections);
+    QByteArray image(sizeof(header), '\0');
+    for (int s = 0; s < kSectionCount; ++s) {
+        while (image.size() % 8 != 0) image.append('\0');
+        header.sections[s].offset = static_cast<uint64_t>(image.size());
+        header.sections[s].bytes = sections[s].bytes;
+        if (sections[s].bytes > 0) image.append(static_cast<const char*>(sections[s].data), static_cast<int>(sections[s].bytes));
+    }
+    memcpy(image.data(), &header, sizeof(header));
+
+    QSaveFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::WriteOnly) || file.write(image) != image.size() || !file.commit()) {
+        if (error) *error = file.errorString().toStdString();
+        return false;
+    }
+    return true;
+}
+
+// ====================================================================
+// == OPENING AN IMAGE
+// ====================================================================
+
+GraphImage::~GraphImage() {
+    if (file && bytes) file->unmap(const_cast<uchar*>(bytes));
+}
+
+bool GraphImage::looksLikeImage(const string& path) {
+    QFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    QByteArray start = file.read(sizeof(kMagic));
+    return start.size() == static_cast<int>(sizeof(kMagic)) && memcmp(start.constData(), kMagic, sizeof(kMagic)) == 0;
+}
+
+shared_ptr<const GraphImage> GraphImage::open(const string& path, string* error) {
+    auto fail = [error](const string& why) {
+        if (error) *error = why;
+        return shared_ptr<const GraphImage>();
+    };
+
+    shared_ptr<GraphImage> image(new GraphImage());
+    image->file.reset(new QFile(QString::fromStdString(path)));
+    if (!image->file->open(QIODevice::ReadOnly)) return fail(image->file->errorString().toStdString());
+    image->size = static_cast<size_t>(image->file->size());
+    if (image->size < sizeof(ImageHeader)) return fail("file too small for a graph image");
+
+    // Mapped pages are shared with every other process that maps the same file
+    image->bytes = image->file->map(0, image->file->size());
+    if (!image->bytes) return fail("could not map the file: " + image->file->errorString().toStdString());
+
+    ImageHeader header;
+    memcpy(&header, image->bytes, sizeof(header));
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) return fail("not a graph image");
+    if (header.byteOrder != kByteOrderMark) return fail("graph image was written on a machine with another byte order");
+    if (header.formatVersion != kFormatVersion) return fail("graph image has format version " + to_string(header.formatVersion));
+
+    PackedMap& map = image->packed;
+    map.nodeCount = header.nodeCount;
+    map.roomCount = header.roomCount;
+    map.edgeCount = header.edgeCount;
+    map.hashSalt = header.hashSalt;
+    map.hashBuckets = header.hashBuckets;
+    map.hashSlotCount = header.hashSlotCount;
+    map.componentCount = header.componentCount;
+    image->hash = header.sourceHash;
+
+    // Every array has to be where the header says, as big as the counts say, and inside the file.
+    // The names are the one array whose size isn't a count (it's checked against nameStart below).
+    SectionData expected[kSectionCount];
+    describe(map, expected);
+    const void* found[kSectionCount];
+    for (int s = 0; s < kSectionCount; ++s) {
+        uint64_t offset = header.sections[s].offset, bytes = header.sections[s].bytes;
+        if (s != kNameChars && bytes != expected[s].bytes) return fail("graph image section has the wrong size");
+        if (offset % 8 != 0 || offset < sizeof(ImageHeader) || offset > image->size || bytes > image->size - offset) {
+            return fail("graph image is cut short or damaged");
+        }
+        found[s] = image->bytes + offset;
+    }
+    map.offsets = static_cast<const int32_t*>(found[kOffsets]);
+    map.targets = static_cast<const int32_t*>(found[kTargets]);
+    map.weights = static_cast<const int32_t*>(found[kWeights]);
+    map.nameStart = static_cast<const uint32_t*>(found[kNameStart]);
+    map.nameChars = static_cast<const char*>(found[kNameChars]);
+    map.x = static_cast<const double*>(found[kX]);
+    map.y = static_cast<const double*>(found[kY]);
+    map.hashSeeds = static_cast<const uint32_t*>(found[kHashSeeds]);
+    map.hashSlots = static_cast<const int32_t*>(found[kHashSlots]);
+    map.component = static_cast<const int32_t*>(found[kComponent]);
+    map.componentSizes = static_cast<const int32_t*>(found[kComponentSizes]);
+
+    string why;
+    if (!consistent(map, header.sections[kNameChars].bytes, why)) return fail("graph image is damaged: " + why);
+    return image;
+}
@@ -0,0 +1,262 @@
+#include "../../include/graph/GraphSnapshot.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <thread>
+
+using namespace std;
+
+// ====================================================================
+// == BUILDING A SNAPSHOT
+// ====================================================================
+
+unique_ptr<const GraphSnapshot> GraphSnapshot::build(const Graph& graph, const ClosedSet& closed, uint64_t version) {
+    unique_ptr<GraphSnapshot> snapshot(new GraphSnapshot());
+    snapshot->snapshotVersion = version;
+    snapshot->storage.packGraph(graph, closed);
+    snapshot->packed = snapshot->storage.finish();
+    return unique_ptr<const GraphSnapshot>(snapshot.release());
+}
+
+unique_ptr<const GraphSnapshot> GraphSnapshot::build(const PackedMap& map, const ClosedSet& closed, uint64_t version) {
+    unique_ptr<GraphSnapshot> snapshot(new GraphSnapshot());
+    snapshot->snapshotVersion = version;
+    snapshot->storage.packMap(map, closed);
+    snapshot->packed = snapshot->storage.finish();
+    return unique_ptr<const GraphSnapshot>(snapshot.release());
+}
+
+unique_ptr<const GraphSnapshot> GraphSnapshot::attach(const PackedMap& map, uint64_t version, shared_ptr<const void> owner) {
+    unique_ptr<GraphSnapshot> snapshot(new GraphSnapshot());
+    snapshot->snapshotVersion = version;
+    snapshot->packed = map;
+    snapshot->owner = move(owner);
+    return unique_ptr<const GraphSnapshot>(snapshot.release());
+}
+
+// ====================================================================
+// == SEARCHING
+// ====================================================================
+
+pair<vector<string>, int> GraphSnapshot::dijkstra(const string& start, const string& end, const atomic<bool>* cancel) const {
+    NoSearchProbe probe;
+    return dijkstra(start, end, cancel, probe);
+}
+
+ShortestPathTree GraphSnapshot::shortestPathTree(const string& start) const {
+    NoSearchProbe probe;
+    return shortestPathTree(start, probe);
+}
+
+// Dijkstra on room IDs: distances and breadcrumbs are plain arrays instead of maps
+template <typename Probe>
+pair<vector<string>, int> GraphSnapshot::dijkstra(const string& start, const string& end, const atomic<bool>* cancel,
+                                                  Probe& probe) const {
+    probe.phase(SearchPhase::Setup);
+    int source = nodeId(start);
+    int target = nodeId(end);
+    // Unknown rooms, or rooms in separate parts of the map: no route, and no need to search for one
+    if (source < 0 || target < 0 || packed.component[source] != packed.component[target]) {
+        probe.finish();
+        return {{}, -1};
+    }
+
+    const int INF = numeric_limits<int>::max();
+    const int32_t* offsets = packed.offsets;
+    const int32_t* targets = packed.targets;
+    const int32_t* weights = packed.weights;
+    vector<int> distances(packed.nodeCount, INF);
+    vector<int> predecessors(packed.nodeCount, -1);
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+
+    distances[source] = 0;
+    pq.push({0, source});
+    probe.pushed();
+    probe.phase(SearchPhase::Search);
+
+    size_t steps = 0;
+    while (!pq.empty()) {
+        if (cancel && (++steps & 255) == 0 && cancel->load(memory_order_relaxed)) {
+            probe.finish();
+            return {{}, -1};
+        }
+
+        int currentDist = pq.top().first;
+        int u = pq.top().second;
+        pq.pop();
+        probe.popped();
+
+        if (currentDist > distances[u]) {  // Stale entry
+            probe.stalePop();
+            continue;
+        }
+        probe.settled();
+        if (u == target) break;
+
+        for (int e = offsets[u]; e < offsets[u + 1]; ++e) {
+            int v = targets[e];
+            int candidate = currentDist + weights[e];
+            if (candidate < distances[v]) {
+                distances[v] = candidate;
+                predecessors[v] = u;
+                pq.push({candidate, v});
+                probe.relaxed();
+                probe.pushed();
+            }
+        }
+    }
+    probe.phase(SearchPhase::Path);
+
+    if (distances[target] == INF) {
+        probe.finish();
+        return {{}, -1};
+    }
+
+    vector<string> path;
+    for (int current = target; current != -1; current = predecessors[current]) {
+        path.push_back(nodeName(current));
+    }
+    reverse(path.begin(), path.end());
+    probe.finish();
+    return {path, distances[target]};
+}
+
+template <typename Probe>
+ShortestPathTree GraphSnapshot::shortestPathTree(const string& start, Probe& probe) const {
+    probe.phase(SearchPhase::Setup);
+    ShortestPathTree tree;
+    tree.source = start;
+    int source = nodeId(start);
+    if (source < 0) {
+        probe.finish();
+        return tree;
+    }
+
+    const int INF = numeric_limits<int>::max();
+    const int32_t* offsets = packed.offsets;
+    const int32_t* targets = packed.targets;
+    const int32_t* weights = packed.weights;
+    vector<int> distances(packed.nodeCount, INF);
+    vector<int> parents(packed.nodeCount, -1);
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+
+    distances[source] = 0;
+    pq.push({0, source});
+    probe.pushed();
+    probe.phase(SearchPhase::Search);
+    while (!pq.empty()) {
+        int currentDist = pq.top().first;
+        int u = pq.top().second;
+        pq.pop();
+        probe.popped();
+        if (currentDist > distances[u]) {
+            probe.stalePop();
+            continue;
+        }
+        probe.settled();
+
+        for (int e = offsets[u]; e < offsets[u + 1]; ++e) {
+            int v = targets[e];
+            int candidate = currentDist + weights[e];
+            if (candidate < distances[v]) {
+                distances[v] = candidate;
+                parents[v] = u;
+                pq.push({candidate, v});
+                probe.relaxed();
+                probe.pushed();
+            }
+        }
+    }
+    probe.phase(SearchPhase::Path);
+
+    // Hand the answer back in the same (name based) form as Graph::shortestPathTree
+    for (int v = 0; v < nodeCount(); ++v) {
+        if (distances[v] == INF) continue;
+        string name = nodeName(v);
+        if (parents[v] != -1) tree.parents[name] = nodeName(parents[v]);
+        tree.distances[move(name)] = distances[v];
+    }
+    probe.finish();
+    return tree;
+}
+
+template pair<vector<string>, int> GraphSnapshot::dijkstra(const string&, const string&, const atomic<bool>*, NoSearchProbe&) const;
+template pair<vector<string>, int> GraphSnapshot::dijkstra(const string&, const string&, const atomic<bool>*, SearchCounters&) const;
+template ShortestPathTree GraphSnapshot::shortestPathTree(const string&, NoSearchProbe&) const;
+template ShortestPathTree GraphSnapshot::shortestPathTree(const string&, SearchCounters&) const;
+
+// ====================================================================
+// == PUBLISHING SNAPSHOTS (read-copy-update)
+// ====================================================================
+
+GraphSnapshotStore::Reader::Reader(Reader&& other) noexcept : slot(other.slot), snapshot(other.snapshot) {
+    other.slot = nullptr;
+    other.snapshot = nullptr;
+}
+
+// Done reading: free our slot so writers may delete the snapshot
+GraphSnapshotStore::Reader::~Reader() {
+    if (slot) slot->store(0, memory_order_release);
+}
+
+GraphSnapshotStore::Reader GraphSnapshotStore::read() const {
+    // Start at a different slot on every thread so readers rarely try the same one
+    size_t first = hash<thread::id>()(this_thread::get_id()) % kReaderSlots;
+    for (int pass = 0;; ++pass) {
+        for (int n = 0; n < kReaderSlots; ++n) {
+            size_t i = (first + n) % kReaderSlots;
+            // Claim a free slot, recording the epoch we start in (an older epoch is harmless: it
+            // only makes writers keep old snapshots a little longer)
+            uint64_t free = 0;
+            uint64_t now = epoch.load();
+            if (slots[i].epoch.compare_exchange_strong(free, now)) {
+                return Reader(&slots[i].epoch, current.load());
+            }
+        }
+
+        // Every slot is busy (more readers than slots). Let the readers holding them run and
+        // finish instead of burning this core; after a while, back off for real.
+        if (pass < kSpinPasses) this_thread::yield();
+        else this_thread::sleep_for(chrono::microseconds(50));
+    }
+}
+
+uint64_t GraphSnapshotStore::currentVersion() const {
+    Reader reader = read();
+    return reader ? reader->version() : 0;
+}
+
+void GraphSnapshotStore::publish(unique_ptr<const GraphSnapshot> snapshot) {
+    lock_guard<mutex> lock(writerMutex);
+    const GraphSnapshot* old = current.exchange(snapshot.release());
+
+    // Readers that started in this epoch (or earlier) may still be looking at 'old';
+    // anyone starting after the bump is guaranteed to see the new snapshot
+    uint64_t replacedIn = epoch.fetch_add(1);
+    if (old) retired.push_back({replacedIn, old});
+    reclaim();
+}
+
+// Delete every retired snapshot that no reader can still be using
+void GraphSnapshotStore::reclaim() {
+    uint64_t oldestReader = numeric_limits<uint64_t>::max();
+    for (const ReaderSlot& slot : slots) {
+        uint64_t e = slot.epoch.load();
+        if (e != 0) oldestReader = min(oldestReader, e);
+    }
+
+    auto stillUsed = [oldestReader](const pair<uint64_t, const GraphSnapshot*>& entry) {
+        return entry.first >= oldestReader;
+    };
+    auto keep = partition(retired.begin(), retired.end(), stillUsed);
+    for (auto it = keep; it != retired.end(); ++it) delete it->second;
+    retired.erase(keep, retired.end());
+}
+
+// By now nobody may be reading any more
+GraphSnapshotStore::~GraphSnapshotStore() {
+    delete current.load();
+    for (const auto& entry : retired) delete entry.second;
+}
@@ -0,0 +1,118 @@
+#include "../../include/core/LocationIndex.h"
+#include "../../include/trees/RoomSearchIndex.h"
+#include <algorithm>
+using namespace std;
+
+static const char* const kAreaNames[LocationIndex::kAreaCount] = {"Outdoor", "EE", "CS", "Multi"};
+
+static bool startsWith(const string& text, const char* prefix) {
+    return text.compare(0, char_traits<char>::length(prefix), prefix) == 0;
+}
+
+// Display names (see RoomSearchIndex::displayNameFor) are the name with dashes turned into
+// spaces and without a trailing " O". These two compare them without building the strings.
+static size_t displayLength(const string& name) {
+    size_t n = name.size();
+    if (n > 2 && name[n - 1] == 'O' && (name[n - 2] == '-' || name[n - 2] == ' ')) return n - 2;
+    return n;
+}
+
+static bool displayLess(const string& a, const string& b) {
+    size_t lengthA = displayLength(a), lengthB = displayLength(b);
+    for (size_t i = 0; i < lengthA && i < lengthB; ++i) {
+        unsigned char ca = a[i] == '-' ? ' ' : static_cast<unsigned char>(a[i]);
+        unsigned char cb = b[i] == '-' ? ' ' : static_cast<unsigned char>(b[i]);
+        if (ca != cb) return ca < cb;
+    }
+    return lengthA < lengthB;
+}
+
+// ====================================================================
+// == RULES (which rooms show up where)
+// ====================================================================
+
+const char* LocationIndex::areaName(Area area) {
+    return kAreaNames[area];
+}
+
+int LocationIndex::areaFromName(string_view areaName) {
+    for (int area = 0; area < kAreaCount; ++area) {
+        if (areaName == kAreaNames[area]) return area;
+    }
+    return -1;
+}
+
+bool LocationIndex::isSelectable(const string& n) {
+    if (n == "North" || n == "South" || n == "East" || n == "West" || n.find("Mid-") != string::npos) return false;
+    if (n.find("Stairs") != string::npos) return false;  // Skip stairs
+    if (n.find("Hall") != string::npos && n.find("Library") == string::npos) return false;  // Skip halls (except library)
+    if (n.find("Internal") != string::npos) return false;  // Skip internal connections
+
+    // Special handling for entrances (only keep important ones)
+    if (n.find("Entrance") != string::npos) {
+        return n.find("Auditorium") != string::npos || n.find("Cafeteria") != string::npos || n.find("Gate") != string::npos;
+    }
+    return true;
+}
+
+unsigned LocationIndex::areasOf(const string& n) {
+    unsigned areas = 0;
+    if (startsWith(n, "EE-")) areas |= 1u << EE;
+    if (startsWith(n, "CS-")) areas |= 1u << CS;
+    if (startsWith(n, "Multi")) areas |= 1u << Multi;
+
+    // Outdoor shows everything outside the buildings, plus the buildings themselves
+    if (areas == 0 || n == "EE-Building" || n == "CS-Building" || n == "Multipurpose-Building") areas |= 1u << Outdoor;
+    return areas;
+}
+
+// ====================================================================
+// == BUILDING
+// ====================================================================
+
+void LocationIndex::build(const vector<string>& nodeNames) {
+    names.clear();
+    for (const string& n : nodeNames) {
+        if (isSelectable(n)) names.push_back(n);
+    }
+    sort(names.begin(), names.end());
+    names.erase(unique(names.begin(), names.end()), names.end());
+
+    // Sort everything by display name once; each area's list then keeps that order
+    vector<uint32_t> byDisplayName(names.size());
+    for (uint32_t i = 0; i < byDisplayName.size(); ++i) byDisplayName[i] = i;
+    stable_sort(byDisplayName.begin(), byDisplayName.end(), [this](uint32_t a, uint32_t b) {
+        return displayLess(names[a], names[b]);
+    });
+
+    for (vector<uint32_t>& list : areaLists) list.clear();
+    for (uint32_t location : byDisplayName) {
+        unsigned areas = areasOf(names[location]);
+        for (int area = 0; area < kAreaCount; ++area) {
+            if (areas & (1u << area)) areaLists[area].push_back(location);
+        }
+    }
+}
+
+string LocationIndex::displayName(uint32_t location) const {
+    return RoomSearchIndex::displayNameFor(names[location]);
+}
+
+// The lists are sorted by display name, then by location number (= name order) for equal ones
+uint32_t LocationIndex::positionInArea(Area area, uint32_t location) const {
+    if (location >= names.size()) return kNone;
+    const vector<uint32_t>& list = areaLists[area];
+    auto it = lower_bound(list.begin(), list.end(), location, [this](uint32_t a, uint32_t b) {
+        if (displayLess(names[a], names[b])) return true;
+        if (displayLess(names[b], names[a])) return false;
+        return a < b;
+    });
+    if (it == list.end() || *it != location) return kNone;
+    return static_cast<uint32_t>(it - list.begin());
+}
+
+uint32_t LocationIndex::find(const string& nodeName) const {
+    auto it = lower_bound(names.begin(), names.end(), nodeName);
+    if (it == names.end() || *it != nodeName) return kNone;
+    return static_cast<uint32_t>(it - names.begin());
+}
@@ -0,0 +1,122 @@
+#include "../../include/gui/LocationListModel.h"
+#include <utility>
+using namespace std;
+
+// ====================================================================
+// == LOCATION LIST (a view into the LocationIndex)
+// ====================================================================
+
+LocationListModel::LocationListModel(const LocationIndex& index, QObject* parent)
+    : QAbstractListModel(parent), m_index(index) {}
+
+void LocationListModel::showArea(int area) {
+    beginResetModel();
+    m_all = false;
+    m_rows = area >= 0 && area < LocationIndex::kAreaCount ? &m_index.inArea(LocationIndex::Area(area)) : nullptr;
+    endResetModel();
+}
+
+void LocationListModel::showAll() {
+    beginResetModel();
+    m_all = true;
+    m_rows = nullptr;
+    endResetModel();
+}
+
+// The lists live inside the index, so they are already up to date; the views just need to know
+void LocationListModel::reload() {
+    beginResetModel();
+    endResetModel();
+}
+
+uint32_t LocationListModel::locationAt(int row) const {
+    return m_all ? static_cast<uint32_t>(row) : (*m_rows)[row];
+}
+
+int LocationListModel::rowCount(const QModelIndex& parent) const {
+    if (parent.isValid()) return 0;  // A list has no children
+    if (m_all) return static_cast<int>(m_index.size());
+    return m_rows ? static_cast<int>(m_rows->size()) : 0;
+}
+
+// Only called for the rows on screen, so only those ever get a display string
+QVariant LocationListModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= rowCount()) return QVariant();
+    uint32_t location = locationAt(index.row());
+    if (role == Qt::DisplayRole) return QString::fromStdString(m_index.displayName(location));
+    if (role == kNodeNameRole) return QString::fromStdString(m_index.name(location));
+    return QVariant();
+}
+
+// ====================================================================
+// == FILTER (a few chosen rows of another model)
+// ====================================================================
+
+LocationFilterModel::LocationFilterModel(QObject* parent) : QAbstractProxyModel(parent) {}
+
+void LocationFilterModel::setSourceModel(QAbstractItemModel* sourceModel) {
+    beginResetModel();
+    if (this->sourceModel()) disconnect(this->sourceModel(), nullptr, this, nullptr);
+    QAbstractProxyModel::setSourceModel(sourceModel);
+    m_rows.clear();
+    m_proxyRowOf.clear();
+    if (sourceModel) {
+        // Our rows point at source rows, so they mean nothing once the source is reset
+        connect(sourceModel, &QAbstractItemModel::modelAboutToBeReset, this, [this]() { beginResetModel(); });
+        connect(sourceModel, &QAbstractItemModel::modelReset, this, [this]() {
+            m_rows.clear();
+            m_proxyRowOf.clear();
+            endResetModel();
+        });
+        connect(sourceModel, &QAbstractItemModel::dataChanged, this, [this](const QModelIndex& first, const QModelIndex& last) {
+            for (int row = first.row(); row <= last.row(); ++row) {
+                auto it = m_proxyRowOf.constFind(row);
+                if (it != m_proxyRowOf.constEnd()) emit dataChanged(index(*it, 0), index(*it, 0));
+            }
+        });
+    }
+    endResetModel();
+}
+
+void LocationFilterModel::setRows(vector<Row> rows) {
+    beginResetModel();
+    m_rows = move(rows);
+    m_proxyRowOf.clear();
+    m_proxyRowOf.reserve(static_cast<int>(m_rows.size()));
+    for (int i = 0; i < static_cast<int>(m_rows.size()); ++i) m_proxyRowOf.insert(m_rows[i].sourceRow, i);
+    endResetModel();
+}
+
+QModelIndex LocationFilterModel::mapToSource(const QModelIndex& proxyIndex) const {
+    if (!proxyIndex.isValid() || !sourceModel()) return QModelIndex();
+    return sourceModel()->index(m_rows[proxyIndex.row()].sourceRow, proxyIndex.column());
+}
+
+QModelIndex LocationFilterModel::mapFromSource(const QModelIndex& sourceIndex) const {
+    if (!sourceIndex.isValid()) return QModelIndex();
+    auto it = m_proxyRowOf.constFind(sourceIndex.row());
+    return it == m_proxyRowOf.constEnd() ? QModelIndex() : index(*it, sourceIndex.column());
+}
+
+QModelIndex LocationFilterModel::index(int row, int column, const QModelIndex& parent) const {
+    if (parent.isValid() || row < 0 || row >= rowCount() || column != 0) return QModelIndex();
+    return createIndex(row, column);
+}
+
+QModelIndex LocationFilterModel::parent(const QModelIndex&) const {
+    return QModelIndex();
+}
+
+int LocationFilterModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : static_cast<int>(m_rows.size());
+}
+
+int LocationFilterModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : 1;
+}
+
+QVariant LocationFilterModel::data(const QModelIndex& index, int role) const {
+    QVariant value = QAbstractProxyModel::data(index, role);
+    if (role == Qt::DisplayRole && index.isValid() && m_rows[index.row()].approximate) return "~ " + value.toString();
+    return value;
+}
@@ -1,93 +1,217 @@
 #include "../../include/trees/LocationTree.h"
-#include <sstream>
+#include <algorithm>
+#include <utility>
 #include <vector>
-#include <iterator>
 using namespace std;
 
 // ====================================================================
-// == HELPER FUNCTION: Split a string into parts
+// == HELPER FUNCTIONS
 // ====================================================================
 
-// This function takes a string like "EE-Lab-1" and splits it by the delimiter '-'
-// Result: ["EE", "Lab", "1"]
-// Example: split("EE-Floor-A-Lab-5", '-') returns {"EE", "Floor", "A", "Lab", "5"}
-vector<string> split(const string& s, char delimiter) {
-    vector<string> tokens;  // This will hold all the parts
-    string token;           // Current part being built
-    istringstream tokenStream(s);  // Create a stream from the string
-
-    // Read from the stream until we hit the delimiter
-    // (getline with a delimiter works like split in other languages)
-    while (getline(tokenStream, token, delimiter)) {
-        tokens.push_back(token);  // Add this part to our list
+// Calls 'visit' for every part of a name split by the delimiter, without copying anything.
+// Example: "EE-Floor-A-Lab-5" gives "EE", "Floor", "A", "Lab", "5".
+// (Same rules as getline: "A--B" has an empty middle part, a dash at the very end is ignored.)
+template <typename Visit>
+static void forEachPart(string_view s, char delimiter, Visit visit) {
+    size_t start = 0;
+    while (start < s.size()) {
+        size_t end = s.find(delimiter, start);
+        if (end == string_view::npos) end = s.size();
+        visit(s.substr(start, end - start));
+        start = end + 1;
     }
-    return tokens;  // Return all the parts
 }
 
+// FNV-1a: a quick, simple hash for short strings
+static uint32_t hashText(string_view text) {
+    uint32_t hash = 2166136261u;
+    for (char c : text) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t hashChild(uint32_t parent, uint32_t segment) {
+    uint64_t key = (static_cast<uint64_t>(parent) << 32) | segment;
+    key *= 0x9E3779B97F4A7C15ull;
+    return static_cast<uint32_t>(key >> 32);
+}
+
+static const uint32_t kEmptySlot = UINT32_MAX;
+
 // ====================================================================
 // == LOCATIONTREE IMPLEMENTATION
 // ====================================================================
 
-// Constructor: Create the root node of the tree (like the root folder)
+// Constructor: Create the root node of the tree (like the root folder called "Campus")
 LocationTree::LocationTree() {
-    // Create the root with the name "Campus"
-    // This is like having a main folder called "Campus" that contains everything else
-    root = make_unique<TreeNode>("Campus");
+    nodes.push_back({internSegment("Campus"), kNone});
+}
+
+void LocationTree::reserve(size_t roomCount) {
+    nodes.reserve(roomCount + 1);
+    segments.reserve(roomCount / 2 + 16);
+    segmentText.reserve(roomCount * 3);
+}
+
+// Hash tables are kept at most half full so lookups stay short.
+// Growing rebuilds them from the arrays, which already hold everything they point at.
+void LocationTree::growTable(vector<uint32_t>& table, size_t used, bool childTable) {
+    if (!table.empty() && used * 2 < table.size()) return;
+    size_t capacity = max<size_t>(64, table.size() * 2);
+    while (used * 2 >= capacity) capacity *= 2;
+    table.assign(capacity, kEmptySlot);
+
+    size_t mask = capacity - 1;
+    size_t count = childTable ? nodes.size() : segments.size();
+    for (uint32_t i = 0; i < count; ++i) {
+        if (childTable && i == root()) continue;  // The root is nobody's child
+        uint32_t hash = childTable ? hashChild(nodes[i].parent, nodes[i].segment) : hashText(segmentView(i));
+        size_t slot = hash & mask;
+        while (table[slot] != kEmptySlot) slot = (slot + 1) & mask;
+        table[slot] = i;
+    }
+}
+
+// Returns the number of 'text' in 'segments', adding it (once) if it is new
+uint32_t LocationTree::internSegment(string_view text) {
+    growTable(segmentTable, segments.size() + 1, false);
+    size_t mask = segmentTable.size() - 1;
+    size_t slot = hashText(text) & mask;
+    while (segmentTable[slot] != kEmptySlot) {
+        if (segmentView(segmentTable[slot]) == text) return segmentTable[slot];
+        slot = (slot + 1) & mask;
+    }
+
+    uint32_t id = static_cast<uint32_t>(segments.size());
+    segments.push_back({static_cast<uint32_t>(segmentText.size()), static_cast<uint32_t>(text.size())});
+    segmentText.append(text.data(), text.size());
+    segmentTable[slot] = id;
+    return id;
+}
+
+// One lookup per level: finds the folder 'part' under 'parent', creating it if needed
+LocationTree::NodeId LocationTree::childFor(NodeId parent, string_view part) {
+    uint32_t segment = internSegment(part);
+    growTable(childTable, nodes.size() + 1, true);
+    size_t mask = childTable.size() - 1;
+    size_t slot = hashChild(parent, segment) & mask;
+    while (childTable[slot] != kEmptySlot) {
+        const TreeNode& node = nodes[childTable[slot]];
+        if (node.parent == parent && node.segment == segment) return childTable[slot];
+        slot = (slot + 1) & mask;
+    }
+
+    NodeId id = static_cast<NodeId>(nodes.size());
+    nodes.push_back({segment, parent});
+    childTable[slot] = id;
+    return id;
 }
 
 // Add a location to the tree
 // This organizes room names into a folder structure
 // Example: addLocation("EE-Lab-1") creates folders: Campus/EE/Lab/1
-void LocationTree::addLocation(const string& fullNodeName) {
-    // Step 1: Split the room name by dashes
-    // "EE-Lab-1" becomes ["EE", "Lab", "1"]
-    vector<string> parts = split(fullNodeName, '-');
+void LocationTree::addLocation(string_view fullNodeName) {
+    // If the name is empty, stop here
+    if (fullNodeName.empty()) return;
 
-    // Start at the root (top-level folder)
-    TreeNode* current = root.get();
+    // Walk through each part and create folders as needed
+    NodeId current = root();
+    forEachPart(fullNodeName, '-', [&](string_view part) { current = childFor(current, part); });
 
-    // If the name is empty, stop here
-    if (parts.empty()) return;
-
-    // Special case: If the room name has no dashes (just one part like "Outdoor")
-    // Just add it directly under the root
-    if (parts.size() == 1) {
-        // Check if this part already exists as a child
-        if (current->children.find(parts[0]) == current->children.end()) {
-            // Doesn't exist, so create a new folder
-            current->children[parts[0]] = make_unique<TreeNode>(parts[0]);
-            // Store the full room name in this leaf node
-            current->children[parts[0]]->fullPath = fullNodeName;
-        }
-        return;
+    // The last folder is the room itself
+    if (!nodes[current].isLocation) {
+        nodes[current].isLocation = true;
+        ++locations;
     }
+}
+
+// Renumbers the folders in breadth-first order with every folder's children sorted by name,
+// so the children of any folder are one block of the array
+void LocationTree::finish() {
+    size_t count = nodes.size();
 
-    // Step 2: Walk through each part and create folders as needed
-    // For "EE-Lab-1", we create: Campus/EE/Lab/1
-    for (size_t i = 0; i < parts.size(); ++i) {
-        string& part = parts[i];
+    // Group the children by parent (counting sort: count, then running totals, then place)
+    vector<uint32_t> start(count + 1, 0);
+    for (NodeId i = 1; i < count; ++i) ++start[nodes[i].parent + 1];
+    for (size_t i = 0; i < count; ++i) start[i + 1] += start[i];
+    vector<NodeId> byParent(count);
+    vector<uint32_t> fill(start.begin(), start.end() - 1);
+    for (NodeId i = 1; i < count; ++i) byParent[fill[nodes[i].parent]++] = i;
 
-        // Check if this folder already exists under the current location
-        if (current->children.find(part) == current->children.end()) {
-            // Doesn't exist, so create a new folder with this name
-            current->children[part] = make_unique<TreeNode>(part);
+    // Breadth-first walk; each folder's children are sorted and then numbered one after another
+    vector<NodeId> order;  // New number -> old number
+    order.reserve(count);
+    order.push_back(root());
+    vector<pair<string_view, NodeId>> siblings;
+    for (size_t next = 0; next < order.size(); ++next) {
+        NodeId old = order[next];
+        siblings.clear();
+        for (uint32_t i = start[old]; i < start[old + 1]; ++i) {
+            siblings.push_back({segmentView(nodes[byParent[i]].segment), byParent[i]});
         }
+        sort(siblings.begin(), siblings.end());
+        for (const auto& sibling : siblings) order.push_back(sibling.second);
+    }
+
+    vector<NodeId> newId(count);
+    for (NodeId i = 0; i < count; ++i) newId[order[i]] = i;
 
-        // Move into this folder
-        current = current->children[part].get();
+    vector<TreeNode> sorted(count);
+    NodeId nextChild = 1;
+    for (NodeId i = 0; i < count; ++i) {
+        const TreeNode& old = nodes[order[i]];
+        sorted[i] = old;
+        sorted[i].parent = old.parent == kNone ? kNone : newId[old.parent];
+        sorted[i].childCount = start[order[i] + 1] - start[order[i]];
+        sorted[i].firstChild = nextChild;
+        nextChild += sorted[i].childCount;
     }
+    nodes.swap(sorted);
 
-    // Step 3: Store the full room name in the final leaf node
-    // So if we're at Campus/EE/Lab/1, we store "EE-Lab-1" there
-    current->fullPath = fullNodeName;
+    // The numbers changed, so the child lookup table is rebuilt
+    childTable.clear();
+    growTable(childTable, nodes.size(), true);
 }
 
-// This function returns the root node of the tree
-// (Currently commented out in the original code, but here's what it would do)
-// It lets other parts of the code access the tree structure
-// const TreeNode* LocationTree::getRoot() const {
-//     return root.get();
-// }
+string_view LocationTree::name(NodeId id) const {
+    return segmentView(nodes[id].segment);
+}
+
+// Rebuilds "EE-A-Lab-1" from the folders on the way up (names are not stored twice)
+string LocationTree::fullPath(NodeId id) const {
+    if (id == root()) return string();
+    vector<NodeId> chain;
+    for (NodeId at = id; at != root(); at = nodes[at].parent) chain.push_back(at);
+
+    string path;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        if (it != chain.rbegin()) path += '-';
+        path += name(*it);
+    }
+    return path;
+}
+
+// Children are sorted, so this is a binary search inside one block
+LocationTree::NodeId LocationTree::findChild(NodeId folder, string_view part) const {
+    auto first = nodes.begin() + nodes[folder].firstChild;
+    auto last = first + nodes[folder].childCount;
+    auto found = lower_bound(first, last, part, [&](const TreeNode& node, string_view text) {
+        return segmentView(node.segment) < text;
+    });
+    if (found == last || segmentView(found->segment) != part) return kNone;
+    return static_cast<NodeId>(found - nodes.begin());
+}
+
+LocationTree::NodeId LocationTree::find(string_view fullNodeName) const {
+    if (fullNodeName.empty()) return kNone;
+    NodeId current = root();
+    forEachPart(fullNodeName, '-', [&](string_view part) {
+        if (current != kNone) current = findChild(current, part);
+    });
+    return current != kNone && nodes[current].isLocation ? current : kNone;
+}
 
 // ====================================================================
 // == HOW THE TREE WORKS (Example)
@@ -103,18 +227,26 @@ void LocationTree::addLocation(const string& fullNodeName) {
 // The tree structure would look like this:
 //
 //     Campus (root)
+//     ├── CS
+//     │   └── Lab
+//     │       └── 5 (location "CS-Lab-5")
 //     ├── EE
 //     │   ├── A
-//     │   │   ├── Lab
-//     │   │   │   └── 1 (fullPath = "EE-A-Lab-1")
-//     │   │   └── Hall (fullPath = "EE-A-Hall")
+//     │   │   ├── Hall (location "EE-A-Hall")
+//     │   │   └── Lab
+//     │   │       └── 1 (location "EE-A-Lab-1")
 //     │   └── B
 //     │       └── Lab
-//     │           └── 2 (fullPath = "EE-B-Lab-2")
-//     ├── CS
-//     │   └── Lab
-//     │       └── 5 (fullPath = "CS-Lab-5")
-//     └── Outdoor (fullPath = "Outdoor")
+//     │           └── 2 (location "EE-B-Lab-2")
+//     └── Outdoor (location "Outdoor")
+//
+// After finish() the folders are stored level by level, children next to each other:
+//
+//     id:     0       1   2   3        4    5  6  7  8     9    10   11  12
+//     name:   Campus  CS  EE  Outdoor  Lab  A  B  5  Hall  Lab  Lab  1   2
+//     parent: -       0   0   0        1    2  2  4  5     5    6    9   10
+//
+// The parts "EE", "Lab", ... are stored once in segmentText, however many rooms use them.
 //
 // This tree makes it easy to organize and navigate through all the rooms!
 //
@@ -1,15 +1,20 @@
 #include "../../include/gui/MainWindow.h"
+#include "../../include/gui/FloorTileLayer.h"
+#include "../../include/gui/LocationListModel.h"
+#include "../../include/gui/MapView.h"
+#include "../../include/gui/RouteAnimator.h"
+#include "../../include/core/Trace.h"
 #include <QtWidgets>
 #include <QDebug>
 #include <QMessageBox>
-#include <QPropertyAnimation>
-#include <QSequentialAnimationGroup>
+#include <QStandardPaths>
 #include <QTimer>
 #include <cmath>
 #include <queue>
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 #include <utility>
 #include <limits>
 #include <algorithm>
@@ -17,19 +22,11 @@
 #include <sstream>
 #include <iostream>
 using namespace std;
-using NodeDistance = pair<int, string>;
 
 // ====================================================================
 // == HELPER FUNCTIONS (Useful little tools)
 // ====================================================================
 
-// Takes two points on the map and calculates the distance between them
-// (like measuring with a ruler on graph paper)
-int calculateDistanceHelper(const QPointF& p1, const QPointF& p2) {
-    qreal dist = sqrt(pow(p1.x() - p2.x(), 2) + pow(p1.y() - p2.y(), 2));
-    return static_cast<int>(round(dist / 5.0));
-}
-
 // Looks at a room name like "EE-Lab-5" and tells you which building it belongs to
 // (Returns "EE", "CS", "Multi", or "Outdoor" based on the name)
 QString getTopLevelName(const string& fullNodeName) {
@@ -54,26 +51,94 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     setupUi();
 
     // Load the map data from the CSV file (reads all rooms and paths)
-    // The file is stored as a resource in the app (:/data/campus_map_detailed.csv)
-    loadDataFromCSV(":/data/campus_map_detailed.csv");
-
-    // Draw all the floor maps and campus map
-    drawAllSchematics();
+    // The file is stored as a resource in the app (:/data/campus_map_detailed.csv).
+    // Kiosk builds have the map compiled in instead (see campus_embed), so there is nothing to read;
+    // CAMPUS_MAP=other_map.csv loads a different file in either kind of build (pointing it at the
+    // very file that was compiled in keeps the compiled-in map).
+    QString mapFile = QString::fromLocal8Bit(qgetenv("CAMPUS_MAP"));
+    if (CampusGis::isEmbeddedMap(mapFile.toStdString())) mapFile.clear();
+    if (mapFile.isEmpty() && !CampusGis::embeddedMap()) mapFile = ":/data/campus_map_detailed.csv";
+    // Work kept from earlier runs (the packed map, the most asked-for routes) lives in the user's
+    // cache folder, or in CAMPUS_CACHE=/some/folder. The compiled-in map has nothing to cache.
+    if (!mapFile.isEmpty()) {
+        QString cacheDir = QString::fromLocal8Bit(qgetenv("CAMPUS_CACHE"));
+        if (cacheDir.isEmpty()) cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        m_gis.setCacheDirectory(cacheDir.toStdString());
+    }
+    loadDataFromCSV(mapFile);
 
     // Fill the dropdown menus with building names ("EE", "CS", "Multi", etc.)
     populateTopLevelComboBoxes();
 
-    // Create a group to manage all the animation (the walking person)
-    m_animationGroup = new QSequentialAnimationGroup(this);
+    // Create the animator that walks the person icon along the route
+    m_routeAnimator = new RouteAnimator(m_personIcon, this);
+    connect(m_routeAnimator, &RouteAnimator::sceneChanged, this, &MainWindow::switchToSceneTab);
+    connect(m_routeAnimator, &RouteAnimator::progressChanged, this, [this](qreal progress) {
+        QSignalBlocker block(m_routeSlider);  // Don't treat our own update as a user seek
+        m_routeSlider->setValue(qRound(progress * m_routeSlider->maximum()));
+    });
+    connect(m_routeAnimator, &RouteAnimator::finished, this, [this]() { m_playPauseButton->setText("Replay"); });
+
+    // Playback controls: play/pause, drag the slider to seek, pick a walking speed
+    connect(m_playPauseButton, &QPushButton::clicked, this, [this]() {
+        if (m_routeAnimator->isPlaying()) { m_routeAnimator->pause(); m_playPauseButton->setText("Play"); }
+        else { m_routeAnimator->play(); m_playPauseButton->setText("Pause"); }
+    });
+    connect(m_routeSlider, &QSlider::valueChanged, this, [this](int value) {
+        m_routeAnimator->seek(qreal(value) / m_routeSlider->maximum());
+    });
+    connect(m_speedComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int) {
+        m_routeAnimator->setSpeed(m_speedComboBox->currentData().toDouble());
+    });
 
     // When user clicks "Search" button, run onFindPathClicked()
     connect(m_findPathButton, &QPushButton::clicked, this, &MainWindow::onFindPathClicked);
 
+    // Route searches run on worker threads; their results/progress hop back to the GUI thread
+    qRegisterMetaType<RouteResult>("RouteResult");
+    connect(this, &MainWindow::routeComputed, this, &MainWindow::onRouteComputed, Qt::QueuedConnection);
+    connect(this, &MainWindow::routeProgress, this, &MainWindow::onRouteProgress, Qt::QueuedConnection);
+
     // When user changes the top-level area (like "EE"), update the sub-location dropdown
     connect(m_sourceTopComboBox, &QComboBox::currentTextChanged, this, &MainWindow::updateSourceSubComboBox);
     connect(m_midTopComboBox, &QComboBox::currentTextChanged, this, &MainWindow::updateMidSubComboBox);
     connect(m_destTopComboBox, &QComboBox::currentTextChanged, this, &MainWindow::updateDestSubComboBox);
 
+    // Find-a-room box: new results on every key press; Enter takes the best one
+    connect(m_searchEdit, &QLineEdit::textChanged, this, &MainWindow::onSearchTextChanged);
+    connect(m_searchResults->selectionModel(), &QItemSelectionModel::currentRowChanged, this, [this](const QModelIndex& current) {
+        for (QPushButton* button : {m_searchFromButton, m_searchViaButton, m_searchToButton}) button->setEnabled(current.isValid());
+    });
+    connect(m_searchFromButton, &QPushButton::clicked, this, [this]() { applySearchResult(m_sourceTopComboBox, m_sourceSubComboBox); });
+    connect(m_searchViaButton, &QPushButton::clicked, this, [this]() { applySearchResult(m_midTopComboBox, m_midSubComboBox); });
+    connect(m_searchToButton, &QPushButton::clicked, this, [this]() { applySearchResult(m_destTopComboBox, m_destSubComboBox); });
+    connect(m_searchEdit, &QLineEdit::returnPressed, this, [this]() {
+        if (m_searchResultModel->rowCount() == 0) return;
+        if (!m_searchResults->currentIndex().isValid()) m_searchResults->setCurrentIndex(m_searchResultModel->index(0, 0));
+        // Fill the start first, then the destination
+        if (getSelectedNode(m_sourceTopComboBox, m_sourceSubComboBox).empty()) applySearchResult(m_sourceTopComboBox, m_sourceSubComboBox);
+        else applySearchResult(m_destTopComboBox, m_destSubComboBox);
+    });
+
+    // As soon as the source (or via) room is known, start searching from it in the background.
+    // Picking destinations afterwards then only needs a quick walk along the precomputed tree.
+    connect(m_sourceSubComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int) {
+        m_gis.prefetchFrom(getSelectedNode(m_sourceTopComboBox, m_sourceSubComboBox));
+    });
+    connect(m_midSubComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int) {
+        m_gis.prefetchFrom(getSelectedNode(m_midTopComboBox, m_midSubComboBox));
+    });
+
+    // Ctrl+Shift+S: show (and log) what the route searches have been doing
+    auto* statsShortcut = new QShortcut(QKeySequence("Ctrl+Shift+S"), this);
+    connect(statsShortcut, &QShortcut::activated, this, [this]() {
+        QString report = QString::fromStdString(m_gis.searchStatsReport());
+        qInfo().noquote() << report;
+        QMessageBox box(QMessageBox::Information, "Search Statistics", report, QMessageBox::Ok, this);
+        box.setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+        box.exec();
+    });
+
     // Initialize the sub-location dropdowns with their first values
     updateSourceSubComboBox(m_sourceTopComboBox->currentText());
     updateMidSubComboBox(m_midTopComboBox->currentText());
@@ -92,80 +157,126 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
 }
 
 // Destructor: This runs when the app closes (cleanup)
-MainWindow::~MainWindow() {}
+// Stop the running search and wait for the workers, so none of them emits into a dead window
+MainWindow::~MainWindow() {
+    if (m_routeCancel) m_routeCancel->store(true);
+    m_gis.shutdownWorkers();
+}
 
 // ====================================================================
 // == DATA LOADING (Reading the CSV file and organizing rooms)
 // ====================================================================
 
 // This function reads the CSV file line by line and loads all room data and paths
+// (an empty file name means the map compiled into the program)
 void MainWindow::loadDataFromCSV(const QString& filename) {
+    TraceSpan span("loadDataFromCSV", "load");
     qDebug() << "Attempting to load:" << filename;
 
     // Clear all the old data (reset everything)
-    m_graph.clear();
     m_campusNodePositions.clear();
     m_eeFloorANodes.clear(); m_eeFloorBNodes.clear(); m_eeFloorCNodes.clear(); m_eeFloorDNodes.clear(); m_eeFloorENodes.clear();
     m_csFloorGNodes.clear(); m_csFloor1Nodes.clear();
     m_multiFloorBNodes.clear(); m_multiFloorGNodes.clear(); m_multiFloor1Nodes.clear();
 
-    // Open the CSV file
-    QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    // Loading is a small pipeline of stages. Stages that don't depend on each other run
+    // at the same time on the worker threads; only drawing the scenes runs on this (GUI) thread.
+    //
+    //   parse -+-> graph freeze ---------+-> map check, map cache
+    //          +-> location tree         +-> floor buckets -> scene population (GUI)
+    //          +-> category index        |
+    //          +-> floor geometry -------+-> room grids
+    //                                    floor buckets -> weight check
+    //          +-> location index -> search index
+    TaskGraph startup;
+    // Adds parse, graph freeze, map check, map cache, location tree, location index
+    if (filename.isEmpty()) m_gis.addLoadStages(startup, *CampusGis::embeddedMap());
+    else m_gis.addLoadStages(startup, filename.toStdString());
+    startup.addTask("category index", [this]() { classifyNodes(); }, {CampusGis::kParseStage});
+    startup.addTask("floor geometry", [this]() {
+        // Put every room on the right floor map
+        for (const auto& pair : m_gis.getNodePositions()) {
+            assignNodeToFloor(pair.first, QPointF(pair.second.x, pair.second.y));
+        }
+        // ...and keep each floor's coordinates as plain arrays too, for the batch geometry
+        for (int f = 0; f < FLOOR_COUNT; ++f) {
+            m_floorPoints[f].clear();
+            m_floorPoints[f].reserve(getFloorPositions(f).size());
+            for (const auto& pair : getFloorPositions(f)) m_floorPoints[f].push(pair.second.x(), pair.second.y());
+        }
+    }, {CampusGis::kParseStage});
+    // Sort every hallway into its floor once, so drawing never has to scan the whole graph
+    startup.addTask("floor buckets", [this]() { buildFloorEdgeBuckets(); }, {CampusGis::kGraphStage, "floor geometry"});
+    // Compare the hallway weights with how long the hallways are drawn (only reports problems)
+    startup.addTask("weight check", [this]() { checkHallwayWeights(); }, {"floor buckets"});
+    // File the selectable rooms of every floor by position, so clicks on the map can find them
+    startup.addTask("room grids", [this]() { buildFloorRoomGrids(); }, {"floor geometry"});
+    // Index the selectable rooms for the find-a-room box
+    startup.addTask("search index", [this]() { buildSearchIndex(); }, {CampusGis::kLocationIndexStage});
+    // Now draw all the maps with the new data (QGraphicsScene may only be touched on the GUI thread)
+    startup.addTask("scene population", [this]() { drawAllSchematics(); },
+                    {"floor buckets", "category index", CampusGis::kLocationTreeStage}, TaskGraph::Where::CallingThread);
+    startup.run(m_gis.getWorkers());
+
+    // Report where the startup time went
+    for (const TaskGraph::Timing& t : startup.timings()) {
+        qInfo().noquote() << QString("  stage %1: started at %2 ms, took %3 ms%4")
+                             .arg(QString::fromStdString(t.name), -18)
+                             .arg(t.startMs, 0, 'f', 1)
+                             .arg(t.durationMs, 0, 'f', 1)
+                             .arg(t.onCallingThread ? " (GUI thread)" : "");
+    }
+    qInfo() << "Startup pipeline finished in" << startup.totalMs() << "ms";
+
+    // The index behind the room lists was rebuilt; let the dropdowns know
+    for (LocationListModel* model : {m_sourceLocations, m_midLocations, m_destLocations, m_allLocations}) model->reload();
+
+    if (!m_gis.lastLoadSucceeded()) {
         // If file doesn't exist, show an error message
         QMessageBox::critical(this, "Error", "Could not open file: " + filename);
         return;
     }
 
-    // Read the file line by line
-    QTextStream in(&file);
-    int mode = 0;  // 0 = looking for section, 1 = reading nodes, 2 = reading edges
-    int nodeCount = 0;
+    int nodeCount = static_cast<int>(m_gis.getNodePositions().size());
     int edgeCount = 0;
+    for (const auto& pair : m_gis.getGraph().getGraphData()) edgeCount += static_cast<int>(pair.second.size());
+    edgeCount /= 2;  // Every path is stored in both directions
 
-    while (!in.atEnd()) {
-        QString line = in.readLine().trimmed();
-
-        // Skip empty lines and comment lines
-        if (line.isEmpty()) continue;
-
-        // Check which section we're in
-        if (line.contains("SECTION 1: NODES", Qt::CaseInsensitive)) { mode = 1; continue; }
-        if (line.contains("SECTION 2: EDGES", Qt::CaseInsensitive)) { mode = 2; continue; }
-        if (line.startsWith("#")) continue;  // Skip comments
+    // Print how many rooms and paths we loaded
+    qDebug() << "SUCCESS: Loaded" << nodeCount << "nodes and" << edgeCount << "edges.";
+}
 
-        // Split the line by commas
-        QStringList parts = line.split(',');
+// Index every room the user can pick, for the find-a-room box
+void MainWindow::buildSearchIndex() {
+    m_searchIndex.build(m_gis.getLocationIndex().allNames());
+    m_searchSession.reset();
+}
 
-        // SECTION 1: Read rooms and their coordinates
-        if (mode == 1 && parts.size() >= 3) {
-            string id = parts[0].trimmed().toStdString();  // Room name like "EE-Lab-1"
-            int x = parts[1].trimmed().toInt();             // X position on map
-            int y = parts[2].trimmed().toInt();             // Y position on map
-            assignNodeToFloor(id, QPointF(x, y));           // Put room on the right floor
-            nodeCount++;
-        }
-        // SECTION 2: Read the connections between rooms
-        else if (mode == 2 && parts.size() >= 3) {
-            string u = parts[0].trimmed().toStdString();   // Room 1
-            string v = parts[1].trimmed().toStdString();   // Room 2
-            int w = parts[2].trimmed().toInt();             // Distance between them
-            addEdge(u, v, w);                               // Connect the rooms
-            edgeCount++;
-        }
+// Decide once what kind of room every node is (stairs, hall, lab, ...),
+// so drawing doesn't have to search the names again
+void MainWindow::classifyNodes() {
+    m_nodeKinds.clear();
+    for (const auto& pair : m_gis.getNodePositions()) {
+        const string& name = pair.first;
+        NodeKind kind = NodeKind::Room;
+        if (name.find("Stairs") != string::npos) kind = NodeKind::Stairs;
+        else if (name.find("Hall") != string::npos) kind = NodeKind::Hall;
+        else if (name.find("Lab") != string::npos || name.find("BCR") != string::npos) kind = NodeKind::Lab;
+        else if (name.find("Entrance") != string::npos) kind = NodeKind::Entrance;
+        m_nodeKinds[name] = kind;
     }
-    file.close();
-
-    // Print how many rooms and paths we loaded
-    qDebug() << "SUCCESS: Loaded" << nodeCount << "nodes and" << edgeCount << "edges.";
+}
 
-    // Now draw all the maps with the new data
-    drawAllSchematics();
+// What kind of room is this? (Rooms we never classified count as plain rooms)
+NodeKind MainWindow::getNodeKind(const string& name) const {
+    auto it = m_nodeKinds.find(name);
+    return it == m_nodeKinds.end() ? NodeKind::Room : it->second;
 }
 
 // This function decides which floor each room belongs to
 // (Like sorting mail into the right mailbox)
 void MainWindow::assignNodeToFloor(const string& id, const QPointF& pos) {
+    TraceSpan span("assignNodeToFloor", "load");
     // 1. OUTDOOR ROOMS
     // Check if the room name ends with "-O" (outdoor marker) or contains "Building"
     if (id.find("-O") != string::npos ||
@@ -206,11 +317,117 @@ void MainWindow::assignNodeToFloor(const string& id, const QPointF& pos) {
     }
 }
 
-// Add a connection between two rooms in the graph
-// (This is like drawing a hallway between two rooms)
-void MainWindow::addEdge(const string& node1, const string& node2, int weight) {
-    m_graph[node1].push_back({node2, weight});  // Room1 connects to Room2
-    m_graph[node2].push_back({node1, weight});  // Room2 connects back to Room1 (can go both ways)
+// One grid per floor over the rooms that can be picked (hallways and stairs are left out,
+// so a click near a hallway still lands on the closest real room)
+void MainWindow::buildFloorRoomGrids() {
+    for (int f = 0; f < FLOOR_COUNT; ++f) {
+        vector<SpatialGrid::Box> points;
+        m_floorRoomNames[f].clear();
+        for (const auto& pair : getFloorPositions(f)) {
+            if (!LocationIndex::isSelectable(pair.first)) continue;
+            QPointF p = pair.second;
+            points.push_back({p.x(), p.y(), p.x(), p.y()});
+            m_floorRoomNames[f].push_back(pair.first);
+        }
+        m_floorRoomGrid[f].build(points);
+    }
+}
+
+// Every hallway's weight (from the map file) should match how long it is drawn, up to the scale
+// of the floor plan. Each floor's hallways are measured in one batch; hallways more than 3x off
+// the floor's typical scale are reported, since they make routes look wrong on the map.
+void MainWindow::checkHallwayWeights() {
+    static const double kWeightTolerance = 3.0;
+    static const size_t kMaxReported = 5;
+
+    size_t checked = 0, mismatched = 0;
+    for (int f = 0; f < FLOOR_COUNT; ++f) {
+        const vector<FloorEdge>& edges = m_floorEdges[f];
+        const map<string, QPointF>& positions = getFloorPositions(f);
+
+        // Both ends of every hallway, side by side in plain arrays
+        PointArrays from, to;
+        from.reserve(edges.size());
+        to.reserve(edges.size());
+        vector<int> weights;
+        weights.reserve(edges.size());
+        for (const FloorEdge& edge : edges) {
+            QPointF a = positions.at(edge.u), b = positions.at(edge.v);
+            from.push(a.x(), a.y());
+            to.push(b.x(), b.y());
+            weights.push_back(edge.weight);
+        }
+
+        vector<double> lengths(edges.size());
+        GeometryKernels::distances(from.x.data(), from.y.data(), to.x.data(), to.y.data(), edges.size(), lengths.data());
+        GeometryKernels::WeightCheck check = GeometryKernels::checkWeights(lengths.data(), weights.data(), edges.size(), kWeightTolerance);
+
+        checked += check.checked;
+        mismatched += check.mismatches.size();
+        for (size_t i = 0; i < check.mismatches.size() && i < kMaxReported; ++i) {
+            const FloorEdge& edge = edges[check.mismatches[i]];
+            qWarning().noquote() << QString("Hallway %1 -> %2 has weight %3 but is drawn %4 long (typical: %5 per weight unit)")
+                                    .arg(QString::fromStdString(edge.u), QString::fromStdString(edge.v))
+                                    .arg(edge.weight)
+                                    .arg(lengths[check.mismatches[i]], 0, 'f', 1)
+                                    .arg(check.lengthPerWeight, 0, 'f', 2);
+        }
+    }
+    qInfo() << "Weight check:" << checked << "hallways measured," << mismatched << "don't match their drawn length";
+}
+
+// Returns the room positions of one floor (FLOOR_CAMPUS is the outdoor map)
+const map<string, QPointF>& MainWindow::getFloorPositions(int floor) const {
+    switch (floor) {
+    case FLOOR_EE_A: return m_eeFloorANodes;
+    case FLOOR_EE_B: return m_eeFloorBNodes;
+    case FLOOR_EE_C: return m_eeFloorCNodes;
+    case FLOOR_EE_D: return m_eeFloorDNodes;
+    case FLOOR_EE_E: return m_eeFloorENodes;
+    case FLOOR_CS_G: return m_csFloorGNodes;
+    case FLOOR_CS_1: return m_csFloor1Nodes;
+    case FLOOR_MULTI_B: return m_multiFloorBNodes;
+    case FLOOR_MULTI_G: return m_multiFloorGNodes;
+    case FLOOR_MULTI_1: return m_multiFloor1Nodes;
+    default: return m_campusNodePositions;
+    }
+}
+
+// Put every hallway into a "bucket" for its floor (done once, right after loading)
+// Hallways whose two rooms are on different floors (stairs, entrances) go in the portal list.
+// Every room and drawn hallway also gets a number (ID), so the route can be highlighted
+// through plain arrays instead of string lookups.
+void MainWindow::buildFloorEdgeBuckets() {
+    m_nodeFloor.clear();
+    m_portalEdges.clear();
+    for (int f = 0; f < FLOOR_COUNT; ++f) m_floorEdges[f].clear();
+
+    // Step 1: Remember which floor each room is on
+    const auto& graph = m_gis.getGraph().getGraphData();
+    for (int f = 0; f < FLOOR_COUNT; ++f) {
+        for (const auto& pair : getFloorPositions(f)) m_nodeFloor[pair.first] = f;
+    }
+
+    // Step 2: Walk the graph once. Every hallway is stored twice (u->v and v->u),
+    // so only keep the copy where u < v. The set catches duplicate lines in the CSV.
+    set<pair<string, string>> seen;
+    for (const auto& pair : graph) {
+        const string& u = pair.first;
+        auto fu = m_nodeFloor.find(u);
+        if (fu == m_nodeFloor.end()) continue;  // Room has no position, can't be drawn
+
+        for (const auto& edge : pair.second) {
+            const string& v = edge.first;
+            if (!(u < v)) continue;
+
+            auto fv = m_nodeFloor.find(v);
+            if (fv == m_nodeFloor.end()) continue;
+            if (!seen.insert({u, v}).second) continue;
+
+            if (fu->second == fv->second) m_floorEdges[fu->second].push_back({u, v, edge.second});
+            else m_portalEdges.push_back({u, v, edge.second});
+        }
+    }
 }
 
 // ====================================================================
@@ -255,6 +472,41 @@ void MainWindow::setupControlPanel() {
     m_destTopComboBox = new QComboBox();
     m_destSubComboBox = new QComboBox();
 
+    // The room lists read the location index directly; picking an area just points them at another list
+    m_sourceLocations = new LocationListModel(m_gis.getLocationIndex(), this);
+    m_midLocations = new LocationListModel(m_gis.getLocationIndex(), this);
+    m_destLocations = new LocationListModel(m_gis.getLocationIndex(), this);
+    m_sourceSubComboBox->setModel(m_sourceLocations);
+    m_midSubComboBox->setModel(m_midLocations);
+    m_destSubComboBox->setModel(m_destLocations);
+    for (QComboBox* comboBox : {m_sourceSubComboBox, m_midSubComboBox, m_destSubComboBox}) {
+        // All rows are the same height, so the popup never has to measure every room
+        static_cast<QListView*>(comboBox->view())->setUniformItemSizes(true);
+    }
+
+    // Find-a-room box: type part of a name, then send the room to From, Via or To
+    m_searchEdit = new QLineEdit();
+    m_searchEdit->setPlaceholderText("Find a room (e.g. lab 5, cafeteria)");
+    m_searchEdit->setClearButtonEnabled(true);
+    m_allLocations = new LocationListModel(m_gis.getLocationIndex(), this);
+    m_allLocations->showAll();
+    m_searchResultModel = new LocationFilterModel(this);
+    m_searchResultModel->setSourceModel(m_allLocations);
+    m_searchResults = new QListView();
+    m_searchResults->setModel(m_searchResultModel);
+    m_searchResults->setUniformItemSizes(true);
+    m_searchResults->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_searchResults->setMaximumHeight(140);
+    m_searchResults->hide();
+    m_searchFromButton = new QPushButton("From");
+    m_searchViaButton = new QPushButton("Via");
+    m_searchToButton = new QPushButton("To");
+    QHBoxLayout* searchButtons = new QHBoxLayout();
+    for (QPushButton* button : {m_searchFromButton, m_searchViaButton, m_searchToButton}) {
+        button->setEnabled(false);
+        searchButtons->addWidget(button);
+    }
+
     // Create the "Search" button with fancy styling
     m_findPathButton = new QPushButton("Search");
     m_findPathButton->setCursor(Qt::PointingHandCursor);
@@ -279,9 +531,38 @@ void MainWindow::setupControlPanel() {
     f->addRow("Location:", m_destSubComboBox);
 
     // Add everything to the control layout
+    controlLayout->addWidget(m_searchEdit);
+    controlLayout->addWidget(m_searchResults);
+    controlLayout->addLayout(searchButtons);
+    controlLayout->addSpacing(10);
     controlLayout->addLayout(f);
     controlLayout->addSpacing(10);
     controlLayout->addWidget(m_findPathButton);
+
+    // Shows that a search is running (and how far a multi-part search got)
+    m_routeProgress = new QProgressBar();
+    m_routeProgress->setTextVisible(false);
+    m_routeProgress->setMaximumHeight(6);
+    m_routeProgress->hide();
+    controlLayout->addWidget(m_routeProgress);
+    controlLayout->addSpacing(10);
+
+    // Walking animation controls (play/pause, speed, and a slider to jump along the route)
+    m_playPauseButton = new QPushButton("Play");
+    m_speedComboBox = new QComboBox();
+    m_speedComboBox->addItem("0.5x", 0.5);
+    m_speedComboBox->addItem("1x", 1.0);
+    m_speedComboBox->addItem("2x", 2.0);
+    m_speedComboBox->addItem("4x", 4.0);
+    m_speedComboBox->setCurrentIndex(1);
+    m_routeSlider = new QSlider(Qt::Horizontal);
+    m_routeSlider->setRange(0, 1000);
+
+    QHBoxLayout* playbackLayout = new QHBoxLayout();
+    playbackLayout->addWidget(m_playPauseButton);
+    playbackLayout->addWidget(m_speedComboBox);
+    controlLayout->addLayout(playbackLayout);
+    controlLayout->addWidget(m_routeSlider);
     controlLayout->addSpacing(10);
     controlLayout->addWidget(m_pathResultText);
 
@@ -297,23 +578,23 @@ void MainWindow::setupMapTabs() {
 
     // Create the OUTDOOR campus map
     m_campusScene = new QGraphicsScene(this);
-    m_campusView = new QGraphicsView(m_campusScene);
+    m_campusView = new MapView(m_campusScene);
 
     // Create EE BUILDING maps (5 floors)
-    m_eeFloorA_Scene = new QGraphicsScene(this); m_eeFloorA_View = new QGraphicsView(m_eeFloorA_Scene);
-    m_eeFloorB_Scene = new QGraphicsScene(this); m_eeFloorB_View = new QGraphicsView(m_eeFloorB_Scene);
-    m_eeFloorC_Scene = new QGraphicsScene(this); m_eeFloorC_View = new QGraphicsView(m_eeFloorC_Scene);
-    m_eeFloorD_Scene = new QGraphicsScene(this); m_eeFloorD_View = new QGraphicsView(m_eeFloorD_Scene);
-    m_eeFloorE_Scene = new QGraphicsScene(this); m_eeFloorE_View = new QGraphicsView(m_eeFloorE_Scene);
+    m_eeFloorA_Scene = new QGraphicsScene(this); m_eeFloorA_View = new MapView(m_eeFloorA_Scene);
+    m_eeFloorB_Scene = new QGraphicsScene(this); m_eeFloorB_View = new MapView(m_eeFloorB_Scene);
+    m_eeFloorC_Scene = new QGraphicsScene(this); m_eeFloorC_View = new MapView(m_eeFloorC_Scene);
+    m_eeFloorD_Scene = new QGraphicsScene(this); m_eeFloorD_View = new MapView(m_eeFloorD_Scene);
+    m_eeFloorE_Scene = new QGraphicsScene(this); m_eeFloorE_View = new MapView(m_eeFloorE_Scene);
 
     // Create CS BUILDING maps (2 floors)
-    m_csFloorG_Scene = new QGraphicsScene(this); m_csFloorG_View = new QGraphicsView(m_csFloorG_Scene);
-    m_csFloor1_Scene = new QGraphicsScene(this); m_csFloor1_View = new QGraphicsView(m_csFloor1_Scene);
+    m_csFloorG_Scene = new QGraphicsScene(this); m_csFloorG_View = new MapView(m_csFloorG_Scene);
+    m_csFloor1_Scene = new QGraphicsScene(this); m_csFloor1_View = new MapView(m_csFloor1_Scene);
 
     // Create MULTIPURPOSE BUILDING maps (3 floors)
-    m_multiFloorB_Scene = new QGraphicsScene(this); m_multiFloorB_View = new QGraphicsView(m_multiFloorB_Scene);
-    m_multiFloorG_Scene = new QGraphicsScene(this); m_multiFloorG_View = new QGraphicsView(m_multiFloorG_Scene);
-    m_multiFloor1_Scene = new QGraphicsScene(this); m_multiFloor1_View = new QGraphicsView(m_multiFloor1_Scene);
+    m_multiFloorB_Scene = new QGraphicsScene(this); m_multiFloorB_View = new MapView(m_multiFloorB_Scene);
+    m_multiFloorG_Scene = new QGraphicsScene(this); m_multiFloorG_View = new MapView(m_multiFloorG_Scene);
+    m_multiFloor1_Scene = new QGraphicsScene(this); m_multiFloor1_View = new MapView(m_multiFloor1_Scene);
 
     // Add the main outdoor tab
     m_mainTabs->addTab(m_campusView, "Outdoor Map");
@@ -346,6 +627,12 @@ void MainWindow::setupMapTabs() {
         m_csFloorG_View, m_csFloor1_View, m_multiFloorB_View, m_multiFloorG_View, m_multiFloor1_View
     };
     for(auto v : views) v->setRenderHint(QPainter::Antialiasing);
+
+    // Clicking a room on a map picks it (the list above is in FloorId order)
+    for (int f = 0; f < FLOOR_COUNT; ++f) {
+        connect(static_cast<MapView*>(views[f]), &MapView::mapClicked, this,
+                [this, f](const QPointF& pos, qreal tolerance, Qt::KeyboardModifiers modifiers) { onMapClicked(f, pos, tolerance, modifiers); });
+    }
 }
 
 // ====================================================================
@@ -354,6 +641,7 @@ void MainWindow::setupMapTabs() {
 
 // Clear all maps and redraw them with the new data
 void MainWindow::drawAllSchematics() {
+    TraceSpan span("drawAllSchematics", "draw");
     // First, clear all existing graphics
     QList<QGraphicsScene*> scenes = {
         m_campusScene, m_eeFloorA_Scene, m_eeFloorB_Scene, m_eeFloorC_Scene, m_eeFloorD_Scene, m_eeFloorE_Scene,
@@ -363,27 +651,31 @@ void MainWindow::drawAllSchematics() {
 
     // Clear the item caches
     m_nodeItems.clear();
-    m_edgeItems.clear();
+    m_roomItems.clear();
+    m_routeItems.clear();  // Deleted with the rest of the scene
 
     // Draw each floor map
     if (m_campusScene) drawCampusSchematic();
 
-    if (m_eeFloorA_Scene) drawFloorSchematic(m_eeFloorA_Scene, m_eeFloorANodes, "EE Floor A");
-    if (m_eeFloorB_Scene) drawFloorSchematic(m_eeFloorB_Scene, m_eeFloorBNodes, "EE Floor B");
-    if (m_eeFloorC_Scene) drawFloorSchematic(m_eeFloorC_Scene, m_eeFloorCNodes, "EE Floor C");
-    if (m_eeFloorD_Scene) drawFloorSchematic(m_eeFloorD_Scene, m_eeFloorDNodes, "EE Floor D");
-    if (m_eeFloorE_Scene) drawFloorSchematic(m_eeFloorE_Scene, m_eeFloorENodes, "EE Floor E");
+    if (m_eeFloorA_Scene) drawFloorSchematic(m_eeFloorA_Scene, FLOOR_EE_A, "EE Floor A");
+    if (m_eeFloorB_Scene) drawFloorSchematic(m_eeFloorB_Scene, FLOOR_EE_B, "EE Floor B");
+    if (m_eeFloorC_Scene) drawFloorSchematic(m_eeFloorC_Scene, FLOOR_EE_C, "EE Floor C");
+    if (m_eeFloorD_Scene) drawFloorSchematic(m_eeFloorD_Scene, FLOOR_EE_D, "EE Floor D");
+    if (m_eeFloorE_Scene) drawFloorSchematic(m_eeFloorE_Scene, FLOOR_EE_E, "EE Floor E");
 
-    if (m_csFloorG_Scene) drawFloorSchematic(m_csFloorG_Scene, m_csFloorGNodes, "CS Floor G");
-    if (m_csFloor1_Scene) drawFloorSchematic(m_csFloor1_Scene, m_csFloor1Nodes, "CS Floor 1");
+    if (m_csFloorG_Scene) drawFloorSchematic(m_csFloorG_Scene, FLOOR_CS_G, "CS Floor G");
+    if (m_csFloor1_Scene) drawFloorSchematic(m_csFloor1_Scene, FLOOR_CS_1, "CS Floor 1");
 
-    if (m_multiFloorB_Scene) drawFloorSchematic(m_multiFloorB_Scene, m_multiFloorBNodes, "Multi Floor B");
-    if (m_multiFloorG_Scene) drawFloorSchematic(m_multiFloorG_Scene, m_multiFloorGNodes, "Multi Floor G");
-    if (m_multiFloor1_Scene) drawFloorSchematic(m_multiFloor1_Scene, m_multiFloor1Nodes, "Multi Floor 1");
+    if (m_multiFloorB_Scene) drawFloorSchematic(m_multiFloorB_Scene, FLOOR_MULTI_B, "Multi Floor B");
+    if (m_multiFloorG_Scene) drawFloorSchematic(m_multiFloorG_Scene, FLOOR_MULTI_G, "Multi Floor G");
+    if (m_multiFloor1_Scene) drawFloorSchematic(m_multiFloor1_Scene, FLOOR_MULTI_1, "Multi Floor 1");
 }
 
 // Draw a single floor map with all its rooms and hallways
-void MainWindow::drawFloorSchematic(QGraphicsScene* scene, const map<string, QPointF>& positions, QString floorName) {
+void MainWindow::drawFloorSchematic(QGraphicsScene* scene, int floor, QString floorName) {
+    TraceSpan span("drawFloorSchematic", "draw", TraceRecorder::instance().isEnabled() ? floorName.toStdString() : string());
+    const map<string, QPointF>& positions = getFloorPositions(floor);
+    const vector<FloorEdge>& edges = m_floorEdges[floor];
     // Choose colors based on which building this floor belongs to
     QColor bgCol, roomCol, labCol, stairCol, hallCol;
 
@@ -410,18 +702,10 @@ void MainWindow::drawFloorSchematic(QGraphicsScene* scene, const map<string, QPo
     }
 
     // Figure out the size of the map (find the minimum and maximum coordinates)
-    qreal minX = 10000, minY = 10000, maxX = -10000, maxY = -10000;
-    if (positions.empty()) {
-        // If no rooms, use a default size
-        minX = 0; minY = 0; maxX = 800; maxY = 600;
-    } else {
-        // Find the boundaries of all rooms
-        for (const auto& pair : positions) {
-            QPointF p = pair.second;
-            if (p.x() < minX) minX = p.x(); if (p.y() < minY) minY = p.y();
-            if (p.x() > maxX) maxX = p.x(); if (p.y() > maxY) maxY = p.y();
-        }
-    }
+    // (If there are no rooms, use a default size)
+    GeometryBounds box = {0, 0, 800, 600};
+    GeometryKernels::bounds(m_floorPoints[floor], box);
+    qreal minX = box.minX, minY = box.minY, maxX = box.maxX, maxY = box.maxY;
 
     // Calculate the map size and center
     qreal width = maxX - minX;
@@ -437,8 +721,9 @@ void MainWindow::drawFloorSchematic(QGraphicsScene* scene, const map<string, QPo
     QRectF sceneRect(centerX - targetW/2, centerY - targetH/2, targetW, targetH);
     scene->setSceneRect(sceneRect);
 
-    // Draw the background
-    scene->addRect(sceneRect, Qt::NoPen, QBrush(bgCol))->setZValue(-100);
+    // Everything that never changes goes onto the tile layer (the background is its fill color)
+    FloorTileLayer* layer = new FloorTileLayer(sceneRect, bgCol);
+    layer->setZValue(-100);
 
     // Draw HALLWAYS (connections between rooms)
     QPen corridorPen(QColor(100, 100, 100), 4);  // Grey lines
@@ -446,38 +731,18 @@ void MainWindow::drawFloorSchematic(QGraphicsScene* scene, const map<string, QPo
     QPen stairsPathPen(stairCol, 4);             // Colored lines for stairs
     stairsPathPen.setCapStyle(Qt::RoundCap);
 
-    // Keep track of which edges we've already drawn (don't draw twice)
-    set<pair<string, string>> drawnEdges;
-
     // Draw all the hallway connections on this floor
-    for (const auto& pair : m_graph) {
-        const string& u = pair.first;
-        for (const auto& edge : pair.second) {
-            const string& v = edge.first;
+    // (the bucket was built at load time, so each hallway is here exactly once)
+    for (const FloorEdge& edge : edges) {
+        QPointF p1 = positions.at(edge.u);
+        QPointF p2 = positions.at(edge.v);
 
-            // Only draw if both rooms are on this floor
-            if (positions.count(u) && positions.count(v)) {
-                // Create a unique key for this edge (u-v or v-u are the same)
-                string key1 = u, key2 = v;
-                if (key1 > key2) swap(key1, key2);
-
-                // Skip if we've already drawn this edge
-                if (drawnEdges.find({key1, key2}) == drawnEdges.end()) {
-                    QPointF p1 = positions.at(u);
-                    QPointF p2 = positions.at(v);
-
-                    // Use different colored line for stairs
-                    QPen pen = corridorPen;
-                    if (u.find("Stairs") != string::npos || v.find("Stairs") != string::npos) pen = stairsPathPen;
-
-                    // Draw the hallway line
-                    QGraphicsLineItem* line = scene->addLine(p1.x(), p1.y(), p2.x(), p2.y(), pen);
-                    line->setZValue(5);
-                    m_edgeItems[{key1, key2}] = line;
-                    drawnEdges.insert({key1, key2});
-                }
-            }
-        }
+        // Use different colored line for stairs
+        QPen pen = corridorPen;
+        if (getNodeKind(edge.u) == NodeKind::Stairs || getNodeKind(edge.v) == NodeKind::Stairs) pen = stairsPathPen;
+
+        // Draw the hallway line into the tiles (a route is drawn over it as one path, see onRouteComputed)
+        layer->addLine(QLineF(p1, p2), pen);
     }
 
     // Font for room labels
@@ -489,19 +754,23 @@ void MainWindow::drawFloorSchematic(QGraphicsScene* scene, const map<string, QPo
         QPointF center = pair.second;
 
         // Draw different shapes for different room types
-        QGraphicsItem* shape = nullptr;
-        if (name.find("Stairs") != string::npos) {
-            shape = scene->addRect(center.x()-15, center.y()-15, 30, 30, QPen(Qt::black, 1), QBrush(stairCol));
-        } else if (name.find("Hall") != string::npos) {
-            shape = scene->addEllipse(center.x()-4, center.y()-4, 8, 8, Qt::NoPen, QBrush(hallCol));
-        } else if (name.find("Lab") != string::npos || name.find("BCR") != string::npos) {
-            shape = scene->addRect(center.x()-25, center.y()-20, 50, 40, QPen(Qt::black, 1), QBrush(labCol));
-        } else if (name.find("Entrance") != string::npos) {
-            shape = scene->addRect(center.x()-20, center.y()-15, 40, 30, QPen(Qt::black, 1), QBrush(QColor(230, 126, 34)));
+        // Stairs and hall dots are only drawn; real rooms also get a live (invisible) hit-box
+        QRectF roomRect;
+        NodeKind kind = getNodeKind(name);
+        if (kind == NodeKind::Stairs) {
+            layer->addRect(QRectF(center.x()-15, center.y()-15, 30, 30), QPen(Qt::black, 1), QBrush(stairCol), FloorTileLayer::Detail::Rooms);
+        } else if (kind == NodeKind::Hall) {
+            layer->addEllipse(QRectF(center.x()-4, center.y()-4, 8, 8), Qt::NoPen, QBrush(hallCol), FloorTileLayer::Detail::Fine);
+        } else if (kind == NodeKind::Lab) {
+            roomRect = QRectF(center.x()-25, center.y()-20, 50, 40);
+            layer->addRect(roomRect, QPen(Qt::black, 1), QBrush(labCol), FloorTileLayer::Detail::Rooms);
+        } else if (kind == NodeKind::Entrance) {
+            roomRect = QRectF(center.x()-20, center.y()-15, 40, 30);
+            layer->addRect(roomRect, QPen(Qt::black, 1), QBrush(QColor(230, 126, 34)), FloorTileLayer::Detail::Rooms);
         } else {
-            shape = scene->addRect(center.x()-20, center.y()-15, 40, 30, QPen(Qt::black, 1), QBrush(roomCol));
+            roomRect = QRectF(center.x()-20, center.y()-15, 40, 30);
+            layer->addRect(roomRect, QPen(Qt::black, 1), QBrush(roomCol), FloorTileLayer::Detail::Rooms);
         }
-        if(shape) shape->setZValue(10);
 
     // Draw the room label (text)
         // Remove the building prefix from the label to make it shorter
@@ -512,36 +781,36 @@ void MainWindow::drawFloorSchematic(QGraphicsScene* scene, const map<string, QPo
         // Replace dashes with newlines for multi-line labels
         label = label.replace("-", "\n");
 
-        // Draw the text label
-        QGraphicsTextItem* text = scene->addText(label, labelFont);
-        text->setDefaultTextColor(Qt::black);
-
-        // Center the text over the room
-        QRectF br = text->boundingRect();
-        text->setPos(center.x() - br.width()/2, center.y() - br.height()/2);
-        text->setZValue(20);
+        // Draw the text label centered over the room (with a white box behind it)
+        // Hallway/stairs/connector labels are "minor" and only show up when zoomed in
+        bool minorLabel = roomRect.isNull() || name.find("Internal") != string::npos || name.find("Mid-") != string::npos;
+        layer->addLabel(label, center, labelFont, minorLabel ? FloorTileLayer::Detail::Fine : FloorTileLayer::Detail::Rooms);
+
+        // Selectable rooms keep a live hit-box so they can be hovered/clicked/highlighted
+        if (!roomRect.isNull()) {
+            QGraphicsRectItem* hitBox = scene->addRect(roomRect, Qt::NoPen, Qt::NoBrush);
+            hitBox->setZValue(30);
+            hitBox->setToolTip(QString::fromStdString(name));
+            m_roomItems[name] = hitBox;
+            m_nodeItems[name] = hitBox;
+        }
+    }
 
-        // Draw a white background behind the text so it's readable
-        QGraphicsRectItem* txtBg = scene->addRect(br, Qt::NoPen, QBrush(QColor(255, 255, 255, 255)));
-        txtBg->setPos(text->pos());
-        txtBg->setZValue(19);
+    // When zoomed far out, show merged room blocks instead of individual rooms
+    layer->aggregateRoomBlocks(QBrush(hallCol));
 
-        // Store this room shape for later (if we need to highlight it)
-        m_nodeItems[name] = shape;
-    }
+    scene->addItem(layer);
 }
 
 // Draw the outdoor campus map with all the buildings
 void MainWindow::drawCampusSchematic() {
+    TraceSpan span("drawCampusSchematic", "draw");
     m_campusScene->clear();
 
     // Step 1: Figure out the size of the campus
-    qreal minX = 10000, minY = 10000, maxX = -10000, maxY = -10000;
-    for (const auto& pair : m_campusNodePositions) {
-        QPointF p = pair.second;
-        if (p.x() < minX) minX = p.x(); if (p.y() < minY) minY = p.y();
-        if (p.x() > maxX) maxX = p.x(); if (p.y() > maxY) maxY = p.y();
-    }
+    GeometryBounds box = {0, 0, 800, 600};
+    GeometryKernels::bounds(m_floorPoints[FLOOR_CAMPUS], box);
+    qreal minX = box.minX, minY = box.minY, maxX = box.maxX, maxY = box.maxY;
 
     // Add some padding around the campus
     qreal padding = 50.0;
@@ -550,50 +819,25 @@ void MainWindow::drawCampusSchematic() {
 
     m_campusScene->setSceneRect(sceneRect);
 
-    // Draw a light green background
-    m_campusScene->addRect(sceneRect, Qt::NoPen, QBrush(QColor(235, 240, 235)))->setZValue(-100);
+    // Draw a light green background (the static map goes onto a tile layer, like the floors)
+    FloorTileLayer* layer = new FloorTileLayer(sceneRect, QColor(235, 240, 235));
+    layer->setZValue(-100);
 
-    // Step 2: Try to load and display the campus image
+    // Step 2: Try to load and display the campus image (the tiles scale it to fit the scene)
     QPixmap campusImage(":/images/campus_map.png");
     if (!campusImage.isNull()) {
-        // Scale the image to fit the scene
-        QPixmap scaledImg = campusImage.scaled(
-            sceneRect.size().toSize(),
-            Qt::IgnoreAspectRatio,
-            Qt::SmoothTransformation
-            );
-        QGraphicsPixmapItem* imgItem = m_campusScene->addPixmap(scaledImg);
-        imgItem->setPos(sceneRect.topLeft());
-        imgItem->setZValue(-50);
+        layer->addPixmap(sceneRect, campusImage);
     }
 
     // Step 3: Draw the paths (hallways) between outdoor locations
     QPen connectionPen(QColor(46, 204, 113), 3);  // Green dotted lines
     connectionPen.setStyle(Qt::DotLine);
 
-    // Draw edges (connections between outdoor nodes)
-    set<pair<string, string>> drawnEdges;
-    for (const auto& pair : m_graph) {
-        const string& u = pair.first;
-        for (const auto& edge : pair.second) {
-            const string& v = edge.first;
-
-            // Only draw if both locations are outdoors
-            if (m_campusNodePositions.count(u) && m_campusNodePositions.count(v)) {
-                string key1 = u, key2 = v;
-                if (key1 > key2) swap(key1, key2);
-
-                // Skip if we've already drawn this edge
-                if (drawnEdges.find({key1, key2}) == drawnEdges.end()) {
-                    QPointF p1 = m_campusNodePositions.at(u);
-                    QPointF p2 = m_campusNodePositions.at(v);
-                    QGraphicsLineItem* line = m_campusScene->addLine(p1.x(), p1.y(), p2.x(), p2.y(), connectionPen);
-                    line->setZValue(5);
-                    m_edgeItems[{key1, key2}] = line;
-                    drawnEdges.insert({key1, key2});
-                }
-            }
-        }
+    // Draw edges (connections between outdoor nodes), using the outdoor bucket
+    for (const FloorEdge& edge : m_floorEdges[FLOOR_CAMPUS]) {
+        QPointF p1 = m_campusNodePositions.at(edge.u);
+        QPointF p2 = m_campusNodePositions.at(edge.v);
+        layer->addLine(QLineF(p1, p2), connectionPen);
     }
 
     // Step 4: Draw the outdoor nodes (buildings and important locations)
@@ -611,99 +855,22 @@ void MainWindow::drawCampusSchematic() {
         QColor color = isLandmark ? QColor(231, 76, 60) : QColor(241, 196, 15); // Red vs Yellow
 
         // Draw the dot
-        QGraphicsEllipseItem* pin = m_campusScene->addEllipse(center.x() - size/2, center.y() - size/2, size, size,
-                                                              QPen(Qt::white, 2), QBrush(color));
-        pin->setZValue(20);
+        QRectF pinRect(center.x() - size/2, center.y() - size/2, size, size);
+        layer->addEllipse(pinRect, QPen(Qt::white, 2), QBrush(color),
+                          isLandmark ? FloorTileLayer::Detail::Always : FloorTileLayer::Detail::Fine);
 
-        m_nodeItems[name] = pin;
-
-        // Only label important landmarks (to avoid clutter)
+        // Only landmarks are selectable, so only they get a live hit-box
         if (!isLandmark) continue;
 
-        // We could add text labels here, but it's commented out to keep the map clean
-    }
-}
-
-// ====================================================================
-// == PATHFINDING (Finding the shortest path between two rooms)
-// ====================================================================
-
-// This uses Dijkstra's algorithm to find the shortest path
-// (Same idea as GPS finding the shortest route)
-pair<vector<string>, int> MainWindow::findShortestPath(const string& start, const string& end) {
-    // Check if both rooms exist in our graph
-    if (m_graph.find(start) == m_graph.end() || m_graph.find(end) == m_graph.end())
-        return {{}, -1};
-
-    // Priority queue: Always gives us the closest room to explore next
-    priority_queue<NodeDistance, vector<NodeDistance>, greater<NodeDistance>> pq;
-
-    // Map to store the shortest distance to each room
-    map<string, int> distances;
-
-    // Map to store which room we came from (for reconstructing the path)
-    map<string, string> parent;
-
-    // Initialize all distances to infinity
-    for (const auto& pair : m_graph)
-        distances[pair.first] = numeric_limits<int>::max();
-
-    // Starting room has distance 0
-    distances[start] = 0;
-    pq.push({0, start});
-
-    // Main algorithm loop
-    while (!pq.empty()) {
-        // Get the closest unexplored room
-        int dist = pq.top().first;
-        string u = pq.top().second;
-        pq.pop();
-
-        // If we've already found a better path to this room, skip it
-        if (dist > distances[u]) continue;
-
-        // If we reached the destination, we can stop
-        if (u == end) break;
-
-        // Check all neighboring rooms (connected by hallways)
-        for (const auto& edge : m_graph[u]) {
-            string v = edge.first;     // Neighbor room
-            int weight = edge.second;  // Distance to neighbor
-
-            // If going through room 'u' is faster than what we knew before...
-            if (distances[u] != numeric_limits<int>::max() &&
-                distances[u] + weight < distances[v]) {
-                // Update the shortest distance to neighbor room
-                distances[v] = distances[u] + weight;
-                // Remember we came from room 'u'
-                parent[v] = u;
-                // Add to priority queue for exploration
-                pq.push({distances[v], v});
-            }
-        }
-    }
+        QGraphicsEllipseItem* pin = m_campusScene->addEllipse(pinRect, Qt::NoPen, Qt::NoBrush);
+        pin->setZValue(20);
+        pin->setToolTip(QString::fromStdString(name));
+        m_nodeItems[name] = pin;
 
-    // Check if we found a path (destination should not be at infinity distance)
-    vector<string> path;
-    int totalDistance = distances[end];
-    if (totalDistance == numeric_limits<int>::max())
-        return {{}, -1};  // No path exists
-
-    // Reconstruct the path by walking backwards from end to start
-    string current = end;
-    while (current != start && parent.count(current)) {
-        path.push_back(current);
-        current = parent[current];
+        // We could add text labels here, but it's commented out to keep the map clean
     }
 
-    // Add the starting room and reverse to get start->end order
-    if (current == start) {
-        path.push_back(start);
-        reverse(path.begin(), path.end());
-    } else
-        return {{}, -1};  // Error: couldn't reconstruct path
-
-    return {path, totalDistance};
+    m_campusScene->addItem(layer);
 }
 
 // ====================================================================
@@ -712,7 +879,9 @@ pair<vector<string>, int> MainWindow::findShortestPath(const string& start, cons
 
 // Fill the top-level dropdown menus with building names
 void MainWindow::populateTopLevelComboBoxes() {
-    QStringList areas = {"Select Area...", "Outdoor", "EE", "CS", "Multi"};
+    TraceSpan span("populateTopLevelComboBoxes", "ui");
+    QStringList areas = {"Select Area..."};
+    for (int area = 0; area < LocationIndex::kAreaCount; ++area) areas << LocationIndex::areaName(LocationIndex::Area(area));
 
     m_sourceTopComboBox->clear();
     m_midTopComboBox->clear();
@@ -723,79 +892,83 @@ void MainWindow::populateTopLevelComboBoxes() {
     m_destTopComboBox->addItems(areas);
 }
 
-// Fill the sub-location dropdown based on which area was selected
-// (If user picks "EE", show only rooms in EE building)
-void MainWindow::collectLeafNodes(const QString& topName, const map<string, vector<pair<string, int>>>& graph, QComboBox* comboBox) {
-    comboBox->clear();
-    if (topName == "Select Area...") return;
-
-    // Go through all rooms in the graph
-    for (const auto& pair : graph) {
-        string n = pair.first;
-
-        // FILTER: Skip system/internal rooms that shouldn't be selectable
-        if (n == "North" || n == "South" || n == "East" || n == "West" || n.find("Mid-") != string::npos) continue;
-        if (n.find("Stairs") != string::npos) continue;  // Skip stairs
-        if (n.find("Hall") != string::npos && n.find("Library") == string::npos) continue;  // Skip halls (except library)
-        if (n.find("Internal") != string::npos) continue;  // Skip internal connections
-
-        // Special handling for entrances (only keep important ones)
-        if (n.find("Entrance") != string::npos) {
-            bool keep = false;
-            if (n.find("Auditorium") != string::npos) keep = true;
-            if (n.find("Cafeteria") != string::npos) keep = true;
-            if (n.find("Gate") != string::npos) keep = true;
-            if (!keep) continue;
-        }
-
-        bool add = false;
-
-        // Check which building/area this room belongs to
-        if (topName == "Outdoor") {
-            // Show main buildings
-            if (n == "EE-Building" || n == "CS-Building" || n == "Multipurpose-Building") {
-                add = true;
-            }
-            // Also show outdoor rooms (that don't start with building prefixes)
-            else if (n.find("EE-") != 0 && n.find("CS-") != 0 && n.find("Multi") != 0) {
-                add = true;
-            }
-        }
-        // Show rooms in EE building
-        else if (topName == "EE") {
-            if (n.find("EE-") == 0 || n == "EE-Building") add = true;
-        }
-        // Show rooms in CS building
-        else if (topName == "CS") {
-            if (n.find("CS-") == 0 || n == "CS-Building") add = true;
-        }
-        // Show rooms in Multipurpose building
-        else if (topName == "Multi") {
-            if (n.find("Multi") == 0 || n == "Multipurpose-Building") add = true;
-        }
-
-        // If we decided to add this room, format it nicely and add it
-        if (add) {
-            QString displayName = QString::fromStdString(n).replace("-", " ");
-            displayName.replace(" O", "");  // Remove " O" suffix if visible
-            comboBox->addItem(displayName, QVariant(QString::fromStdString(n)));
-        }
-    }
-
-    // Sort the items alphabetically
-    comboBox->model()->sort(0);
+// Show the rooms of the area picked in the top-level dropdown
+// (If user picks "EE", show only rooms in EE building.) The list is ready-made, so this is instant.
+void MainWindow::showAreaLocations(const QString& areaName, QComboBox* comboBox) {
+    TraceSpan span("showAreaLocations", "ui", TraceRecorder::instance().isEnabled() ? areaName.toStdString() : string());
+    static_cast<LocationListModel*>(comboBox->model())->showArea(LocationIndex::areaFromName(areaName.toStdString()));
+    if (comboBox->currentIndex() < 0 && comboBox->count() > 0) comboBox->setCurrentIndex(0);
 }
 
 // These functions are called when the user changes a top-level dropdown
 // They update the sub-location dropdown to show only rooms in that area
 void MainWindow::updateSourceSubComboBox(const QString& text) {
-    collectLeafNodes(text, m_graph, m_sourceSubComboBox);
+    showAreaLocations(text, m_sourceSubComboBox);
 }
 void MainWindow::updateMidSubComboBox(const QString& text) {
-    collectLeafNodes(text, m_graph, m_midSubComboBox);
+    showAreaLocations(text, m_midSubComboBox);
 }
 void MainWindow::updateDestSubComboBox(const QString& text) {
-    collectLeafNodes(text, m_graph, m_destSubComboBox);
+    showAreaLocations(text, m_destSubComboBox);
+}
+
+// ====================================================================
+// == FIND-A-ROOM BOX
+// ====================================================================
+
+// Runs on every key press; the session carries on from the previous key press when it can
+void MainWindow::onSearchTextChanged(const QString& text) {
+    TraceSpan span("room search", "ui");
+    const vector<RoomSearchIndex::Match>& matches = m_searchSession.update(text.toStdString(), 20);
+
+    // The list shows just these rows of the all-rooms model (matches found by spelling
+    // correction get a "~" so it's clear they are a guess)
+    const LocationIndex& index = m_gis.getLocationIndex();
+    vector<LocationFilterModel::Row> rows;
+    rows.reserve(matches.size());
+    for (const RoomSearchIndex::Match& match : matches) {
+        uint32_t location = index.find(m_searchIndex.name(match.room));
+        if (location != LocationIndex::kNone) rows.push_back({static_cast<int>(location), match.typos > 0});
+    }
+    m_searchResultModel->setRows(move(rows));
+
+    bool found = m_searchResultModel->rowCount() > 0;
+    m_searchResults->setVisible(found);
+    if (found) m_searchResults->setCurrentIndex(m_searchResultModel->index(0, 0));
+    for (QPushButton* button : {m_searchFromButton, m_searchViaButton, m_searchToButton}) button->setEnabled(found);
+}
+
+// Sends the highlighted search result to one of the From/Via/To dropdown pairs
+void MainWindow::applySearchResult(QComboBox* top, QComboBox* sub) {
+    QModelIndex current = m_searchResults->currentIndex();
+    if (!current.isValid()) return;
+    selectLocation(top, sub, current.data(LocationListModel::kNodeNameRole).toString().toStdString());
+}
+
+// Picks the room's area in 'top' (which switches the list of 'sub'), then the room itself in 'sub'.
+// The area lists are sorted, so finding the room's row is a binary search, not a scan.
+void MainWindow::selectLocation(QComboBox* top, QComboBox* sub, const string& nodeName) {
+    top->setCurrentText(getTopLevelName(nodeName));
+    const LocationIndex& index = m_gis.getLocationIndex();
+    int area = LocationIndex::areaFromName(top->currentText().toStdString());
+    if (area < 0) return;
+    uint32_t row = index.positionInArea(LocationIndex::Area(area), index.find(nodeName));
+    if (row != LocationIndex::kNone) sub->setCurrentIndex(static_cast<int>(row));
+}
+
+// A click on a floor map: the nearest room (if one is close enough) becomes the start,
+// or the destination once a start is picked. Shift+click always sets the destination,
+// Ctrl+click the stop on the way.
+void MainWindow::onMapClicked(int floor, const QPointF& scenePos, qreal tolerance, Qt::KeyboardModifiers modifiers) {
+    TraceSpan span("map click", "ui");
+    uint32_t room = m_floorRoomGrid[floor].nearest(scenePos.x(), scenePos.y(), tolerance);
+    if (room == SpatialGrid::kNone) return;
+    const string& name = m_floorRoomNames[floor][room];
+
+    if (modifiers & Qt::ControlModifier) selectLocation(m_midTopComboBox, m_midSubComboBox, name);
+    else if ((modifiers & Qt::ShiftModifier) || !getSelectedNode(m_sourceTopComboBox, m_sourceSubComboBox).empty())
+        selectLocation(m_destTopComboBox, m_destSubComboBox, name);
+    else selectLocation(m_sourceTopComboBox, m_sourceSubComboBox, name);
 }
 
 // Get the actual room name from a top-level and sub-location dropdown pair
@@ -919,16 +1092,14 @@ void MainWindow::switchToSceneTab(QGraphicsScene* scene) {
 
 // Reset all map styles (unhighlight edges, hide person icon)
 void MainWindow::resetMapStyles() {
-    m_animationGroup->stop();  // Stop any current animation
-    m_animationGroup->clear();  // Clear animation queue
-
-    // Remove the person icon from the current scene
-    if(m_personIcon->scene()) m_personIcon->scene()->removeItem(m_personIcon);
-    m_personIcon->hide();
-
-    // Set all edges back to their normal color (grey)
-    for (auto const& [key, item] : m_edgeItems)
-        if(item) item->setPen(QPen(QColor(149, 165, 166), 4));
+    // Stop any current animation, forget the old route and take the person icon off the map
+    m_routeAnimator->setRoute({});
+    m_playPauseButton->setText("Play");
+
+    // Remove the old route (the hallways themselves are painted by the tile layer underneath):
+    // one path item on each map it crossed
+    for (QGraphicsPathItem* item : m_routeItems) delete item;
+    m_routeItems.clear();
 }
 
 // ====================================================================
@@ -936,8 +1107,10 @@ void MainWindow::resetMapStyles() {
 // ====================================================================
 
 void MainWindow::onFindPathClicked() {
+    TraceSpan span("onFindPathClicked", "route");
     // Reset all highlighting from previous search
     resetMapStyles();
+    m_routeProgress->hide();
 
     // Get which rooms the user selected
     string source = getSelectedNode(m_sourceTopComboBox, m_sourceSubComboBox);
@@ -954,29 +1127,37 @@ void MainWindow::onFindPathClicked() {
         return;
     }
 
-    // Find the path
-    vector<string> finalPath;
-    int totalDistance = 0;
-
-    if (mid.empty() || mid == source || mid == dest) {
-        // Direct path from source to destination
-        auto result = findShortestPath(source, dest);
-        finalPath = result.first;
-        totalDistance = result.second;
-    } else {
-        // Path with intermediate stop: source -> mid -> dest
-        auto r1 = findShortestPath(source, mid);
-        auto r2 = findShortestPath(mid, dest);
-
-        if (r1.second != -1 && r2.second != -1) {
-            totalDistance = r1.second + r2.second;
-            finalPath = r1.first;
-            if (!finalPath.empty()) finalPath.pop_back();  // Remove duplicate middle node
-            finalPath.insert(finalPath.end(), r2.first.begin(), r2.first.end());
-        } else {
-            totalDistance = -1;
-        }
-    }
+    // Cancel the search that is still running (if any) and start a new one on a worker thread.
+    // The result comes back to this (GUI) thread through the queued routeComputed signal.
+    if (m_routeCancel) m_routeCancel->store(true);
+    m_routeCancel = CampusGis::makeCancelToken();
+    quint64 requestId = ++m_routeRequestId;
+
+    m_routeProgress->setRange(0, 0);  // "Busy" animation until the first progress report
+    m_routeProgress->show();
+    m_pathResultText->setText("Searching...");
+
+    m_gis.findRouteAsync({source, mid, dest}, m_routeCancel,
+        [this, requestId](size_t done, size_t total) { emit routeProgress(requestId, int(done), int(total)); },
+        [this, requestId](const RouteResult& result) { emit routeComputed(requestId, result); });
+}
+
+// Show the progress of the running search (only for the newest request)
+void MainWindow::onRouteProgress(quint64 requestId, int done, int total) {
+    if (requestId != m_routeRequestId) return;
+    m_routeProgress->setRange(0, total);
+    m_routeProgress->setValue(done);
+}
+
+// A search finished on a worker thread; this runs back on the GUI thread
+void MainWindow::onRouteComputed(quint64 requestId, const RouteResult& result) {
+    // Results of searches that were replaced by a newer one are simply dropped
+    if (requestId != m_routeRequestId || result.cancelled) return;
+    TraceSpan span("onRouteComputed", "route");
+    m_routeProgress->hide();
+
+    const vector<string>& finalPath = result.path;
+    int totalDistance = result.distance;
 
     // Check if path was found
     if (totalDistance == -1) {
@@ -988,10 +1169,17 @@ void MainWindow::onFindPathClicked() {
     // Format and display the path
     QString pathStr = QString("<div style='color:#2980b9; font-size:14px; font-weight:bold; margin-bottom:5px;'>📍 Route (%1m):</div>").arg(totalDistance);
 
+    QPen highlightPen(QColor(231, 76, 60), 6);  // Red thick line
+    highlightPen.setCapStyle(Qt::RoundCap);
+    highlightPen.setJoinStyle(Qt::RoundJoin);
+
+    // The hallways of the route, as one path per map (a step between two floors isn't drawn)
+    map<QGraphicsScene*, QPainterPath> routeLines;
+    QGraphicsScene* lastScene = nullptr;  // Map of the hallway drawn last step (to keep the line going)
+
     for (size_t i = 0; i < finalPath.size(); ++i) {
-        // Format the room name nicely (remove prefixes and underscores)
-        QString nodeName = QString::fromStdString(finalPath[i]).replace("-", " ");
-        nodeName = nodeName.replace(" O", "");
+        // The same readable name the dropdowns and the search box show
+        QString nodeName = QString::fromStdString(RoomSearchIndex::displayNameFor(finalPath[i]));
 
         // Add the room name to the display
         pathStr += QString("<span style='color:#2c3e50'>%1</span>").arg(nodeName);
@@ -1001,80 +1189,43 @@ void MainWindow::onFindPathClicked() {
             pathStr += " <span style='color:#e67e22; font-weight:bold;'>→</span> ";
         }
 
-        // Highlight the hallway on the map (red)
+        // Add the hallway to its map's route line
         if (i < finalPath.size() - 1) {
-            string u = finalPath[i], v = finalPath[i+1];
-            string key1 = u, key2 = v;
-            if (key1 > key2) swap(key1, key2);
-            if (m_edgeItems.count({key1, key2})) {
-                QPen highlightPen(QColor(231, 76, 60), 6);  // Red thick line
-                highlightPen.setCapStyle(Qt::RoundCap);
-                m_edgeItems.at({key1, key2})->setPen(highlightPen);
+            QGraphicsScene* scene = getSceneForNode(finalPath[i]);
+            if (scene && scene == getSceneForNode(finalPath[i+1])) {
+                QPainterPath& line = routeLines[scene];
+                if (scene != lastScene) line.moveTo(getPosForNode(finalPath[i]));
+                line.lineTo(getPosForNode(finalPath[i+1]));
+                lastScene = scene;
+            } else {
+                lastScene = nullptr;
             }
         }
     }
     m_pathResultText->setHtml(pathStr);
 
+    // Highlight the route on the map (red), drawn above the tiles
+    for (const auto& pair : routeLines) {
+        QGraphicsPathItem* item = pair.first->addPath(pair.second, highlightPen);
+        item->setZValue(5);
+        m_routeItems.push_back(item);
+    }
+
     // If no path, stop here
     if (finalPath.empty()) return;
 
-    // Place the person icon at the starting location
-    QGraphicsScene* startScene = getSceneForNode(finalPath[0]);
-    if (startScene) {
-        if (m_personIcon->scene()) m_personIcon->scene()->removeItem(m_personIcon);
-        startScene->addItem(m_personIcon);
-        m_personIcon->setPos(getPosForNode(finalPath[0]) - QPointF(10, 10));
-        m_personIcon->show();
-        switchToSceneTab(startScene);
-    }
-
-    // Clear previous animations
-    m_animationGroup->clear();
-
-    // Create animations for each step of the path
-    for (size_t i = 0; i < finalPath.size() - 1; ++i) {
-        string u = finalPath[i], v = finalPath[i+1];
-        QGraphicsScene* currScene = getSceneForNode(u);
-        QGraphicsScene* nextScene = getSceneForNode(v);
-
-        if (!currScene || !nextScene) continue;
-
-        // If moving between different floors, add a pause and scene switch
-        if (currScene != nextScene) {
-            QPauseAnimation* pause = new QPauseAnimation(1000);
-            m_animationGroup->addAnimation(pause);
-
-            QVariantAnimation* switchAnim = new QVariantAnimation();
-            switchAnim->setDuration(100);
-            switchAnim->setStartValue(0);
-            switchAnim->setEndValue(1);
-            QObject::connect(switchAnim, &QVariantAnimation::finished, [this, nextScene, v]() {
-                if (m_personIcon->scene()) m_personIcon->scene()->removeItem(m_personIcon);
-                nextScene->addItem(m_personIcon);
-                m_personIcon->setPos(getPosForNode(v) - QPointF(10, 10));
-                switchToSceneTab(nextScene);
-            });
-            m_animationGroup->addAnimation(switchAnim);
-        } else {
-            // Animate walking between two rooms on the same floor
-            QPointF start = getPosForNode(u) - QPointF(10, 10);
-            QPointF end = getPosForNode(v) - QPointF(10, 10);
-
-            QVariantAnimation* moveAnim = new QVariantAnimation();
-            // Duration based on distance (slower animation for longer distances)
-            moveAnim->setDuration(calculateDistanceHelper(start, end) * 80);
-            moveAnim->setStartValue(start);
-            moveAnim->setEndValue(end);
-            moveAnim->setEasingCurve(QEasingCurve::InOutQuad);
-
-            // Update person position as animation progresses
-            QObject::connect(moveAnim, &QVariantAnimation::valueChanged, [this](const QVariant& val){
-                m_personIcon->setPos(val.toPointF());
-            });
-            m_animationGroup->addAnimation(moveAnim);
-        }
+    // Turn the path into stops (map + icon position) once, then hand them to the animator
+    TraceSpan animationSpan("animation setup", "animation");
+    vector<RouteAnimator::Stop> stops;
+    stops.reserve(finalPath.size());
+    for (const string& node : finalPath) {
+        QGraphicsScene* scene = getSceneForNode(node);
+        if (!scene) continue;  // Room has no position on any map
+        stops.push_back({scene, getPosForNode(node) - QPointF(10, 10)});
     }
 
-    // Start the animation sequence
-    m_animationGroup->start();
+    // Start walking (the animator switches tabs for us through sceneChanged)
+    m_routeAnimator->setRoute(stops);
+    m_routeAnimator->play();
+    m_playPauseButton->setText("Pause");
 }
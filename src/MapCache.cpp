@@ -0,0 +1,168 @@
+#include "../../include/core/MapCache.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QDebug>
+#include <cstdio>
+
+using namespace std;
+
+// How many maps keep their entry (the current one, plus the last few others that were used)
+static const int kKeptMaps = 4;
+
+static const char* const kImageFile = "graph.img";
+static const char* const kCleanupFile = "cleanup.csv";
+static const char* const kCleanupHeader = "# duplicates,conflicting weights,self loops";
+static const char* const kRoutesFile = "routes.csv";
+static const char* const kRoutesHeader = "# count,distance,room,room,...";
+
+// Entries are named after the fingerprint: exactly 16 hex digits. Anything else in the folder
+// isn't ours and is never removed.
+static bool isEntryName(const QString& name) {
+    if (name.size() != 16) return false;
+    for (QChar c : name) {
+        if (!c.isDigit() && (c < QChar('a') || c > QChar('f'))) return false;
+    }
+    return true;
+}
+
+MapCache::MapCache(const string& directory) : directory(directory) {}
+
+bool MapCache::open(const string& mapFile) {
+    entry.clear();
+    QFile file(QString::fromStdString(mapFile));
+    if (directory.empty() || !file.open(QIODevice::ReadOnly)) return false;
+
+    // Map the file instead of reading it when we can (files inside the program's resources
+    // may not allow it; those are read)
+    qint64 size = file.size();
+    if (uchar* mapped = size > 0 ? file.map(0, size) : nullptr) {
+        hash = PackedMap::hashBytes(reinterpret_cast<const char*>(mapped), static_cast<size_t>(size));
+        file.unmap(mapped);
+    } else {
+        QByteArray bytes = file.readAll();
+        hash = PackedMap::hashBytes(bytes.constData(), static_cast<size_t>(bytes.size()));
+    }
+
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+    entry = QDir(QString::fromStdString(directory)).filePath(QString(name)).toStdString();
+    return true;
+}
+
+string MapCache::entryPath(const char* file) const {
+    return QDir(QString::fromStdString(entry)).filePath(QString(file)).toStdString();
+}
+
+// ====================================================================
+// == THE PACKED MAP
+// ====================================================================
+
+shared_ptr<const GraphImage> MapCache::loadImage(Graph::EdgeCleanup& cleanup) const {
+    if (entry.empty() || !QFile(QString::fromStdString(entryPath(kImageFile))).exists()) return nullptr;
+
+    // Without the cleanup counts the map check would report a clean map: treat it as not cached
+    QFile cleanupFile(QString::fromStdString(entryPath(kCleanupFile)));
+    if (!cleanupFile.open(QIODevice::ReadOnly | QIODevice::Text)) return nullptr;
+    QTextStream in(&cleanupFile);
+    QStringList counts;
+    while (!in.atEnd() && counts.size() != 3) {
+        QString line = in.readLine();
+        if (!line.startsWith("#")) counts = line.split(',');
+    }
+    bool ok[3] = {false, false, false};
+    if (counts.size() == 3) {
+        cleanup.duplicates = counts[0].toULongLong(&ok[0]);
+        cleanup.conflictingWeights = counts[1].toULongLong(&ok[1]);
+        cleanup.selfLoops = counts[2].toULongLong(&ok[2]);
+    }
+    if (!ok[0] || !ok[1] || !ok[2]) return nullptr;
+
+    string error;
+    shared_ptr<const GraphImage> image = GraphImage::open(entryPath(kImageFile), &error);
+    if (!image) {
+        // Damaged, or written by an older version of the program: it gets rewritten after this load
+        qWarning() << "Map cache: ignoring" << QString::fromStdString(entryPath(kImageFile)) << ":" << QString::fromStdString(error);
+        return nullptr;
+    }
+    if (image->sourceHash() != hash) return nullptr;  // Copied in from another entry by hand
+    return image;
+}
+
+bool MapCache::storeImage(const PackedMap& map, const Graph::EdgeCleanup& cleanup) const {
+    if (entry.empty() || !QDir().mkpath(QString::fromStdString(entry))) return false;
+
+    // The counts first: an image is only used when they are there too
+    string text = string(kCleanupHeader) + "\n" + to_string(cleanup.duplicates) + "," +
+                  to_string(cleanup.conflictingWeights) + "," + to_string(cleanup.selfLoops) + "\n";
+    string error = "could not write " + string(kCleanupFile);
+    if (!writeText(entryPath(kCleanupFile), text) || !GraphImage::write(entryPath(kImageFile), map, hash, &error)) {
+        qWarning() << "Map cache:" << QString::fromStdString(entry) << ":" << QString::fromStdString(error);
+        return false;
+    }
+    removeOldEntries();
+    return true;
+}
+
+// Readers never see half a file: it is written next to it and renamed into place
+bool MapCache::writeText(const string& path, const string& text) {
+    QSaveFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
+    QByteArray bytes(text.data(), static_cast<int>(text.size()));
+    return file.write(bytes) == bytes.size() && file.commit();
+}
+
+// Removes the entries of maps that haven't been used for a while (newest kept first)
+void MapCache::removeOldEntries() const {
+    QDir root(QString::fromStdString(directory));
+    QString current = QFileInfo(QString::fromStdString(entry)).fileName();
+    int kept = 0;
+    for (const QFileInfo& info : root.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Time)) {
+        if (!isEntryName(info.fileName()) || info.fileName() == current) continue;
+        if (++kept < kKeptMaps) continue;
+        QDir(info.absoluteFilePath()).removeRecursively();
+    }
+}
+
+// ====================================================================
+// == THE WARM ROUTES
+// ====================================================================
+
+// One route per line: "count,distance,room,room,...". Room names never hold commas (the map
+// file is split on them too).
+vector<WarmRoute> MapCache::loadRoutes() const {
+    vector<WarmRoute> routes;
+    QFile file(QString::fromStdString(entryPath(kRoutesFile)));
+    if (entry.empty() || !file.open(QIODevice::ReadOnly | QIODevice::Text)) return routes;
+
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QString line = in.readLine();
+        if (line.startsWith("#")) continue;
+        QStringList fields = line.split(',');
+        if (fields.size() < 3) continue;
+
+        WarmRoute route;
+        bool countOk = false, distanceOk = false;
+        route.count = fields[0].toULongLong(&countOk);
+        route.distance = fields[1].toInt(&distanceOk);
+        if (!countOk || !distanceOk || route.distance < 0) continue;
+        for (int i = 2; i < fields.size(); ++i) route.path.push_back(fields[i].toStdString());
+        routes.push_back(move(route));
+    }
+    return routes;
+}
+
+bool MapCache::storeRoutes(const vector<WarmRoute>& routes) const {
+    if (entry.empty() || !QDir().mkpath(QString::fromStdString(entry))) return false;
+
+    string text = string(kRoutesHeader) + "\n";
+    for (const WarmRoute& route : routes) {
+        text += to_string(route.count) + "," + to_string(route.distance);
+        for (const string& room : route.path) text += "," + room;
+        text += "\n";
+    }
+    return writeText(entryPath(kRoutesFile), text);
+}
@@ -0,0 +1,48 @@
+#include "../../include/gui/MapView.h"
+#include <QApplication>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QtMath>
+
+// How far the view can zoom out and in. The tile layer has no sharper tiles than 2x,
+// so zooming in further would only make them blurry.
+static const qreal kMinZoom = 0.05;
+static const qreal kMaxZoom = 2.0;
+
+// A click picks the nearest room within this many screen pixels
+static const qreal kClickRadiusPx = 30.0;
+
+MapView::MapView(QGraphicsScene* scene, QWidget* parent) : QGraphicsView(scene, parent) {
+    // Click and drag to pan, zoom around the mouse pointer
+    setDragMode(QGraphicsView::ScrollHandDrag);
+    setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+
+    // Only repaint the parts of the view that changed (e.g. around the moving person icon)
+    setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
+    setOptimizationFlag(QGraphicsView::DontSavePainterState);
+    setOptimizationFlag(QGraphicsView::DontAdjustForAntialiasing);
+}
+
+// Scroll wheel: zoom in/out by ~15% per notch
+void MapView::wheelEvent(QWheelEvent* event) {
+    qreal factor = qPow(1.15, event->angleDelta().y() / 120.0);
+    qreal current = transform().m11();
+    qreal target = qBound(kMinZoom, current * factor, kMaxZoom);
+    if (qFuzzyCompare(target, current)) return;
+
+    scale(target / current, target / current);
+    event->accept();
+}
+
+// Remember where the button went down, to tell a click from a drag (panning)
+void MapView::mousePressEvent(QMouseEvent* event) {
+    if (event->button() == Qt::LeftButton) m_pressPos = event->pos();
+    QGraphicsView::mousePressEvent(event);
+}
+
+void MapView::mouseReleaseEvent(QMouseEvent* event) {
+    QGraphicsView::mouseReleaseEvent(event);
+    if (event->button() != Qt::LeftButton) return;
+    if ((event->pos() - m_pressPos).manhattanLength() >= QApplication::startDragDistance()) return;
+    emit mapClicked(mapToScene(event->pos()), kClickRadiusPx / transform().m11(), event->modifiers());
+}
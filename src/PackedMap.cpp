@@ -0,0 +1,299 @@
+#include "../../include/graph/PackedMap.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace std;
+
+// The name table is tried with a few different salts before giving up on it (never needed in
+// practice: it would take two names with the exact same 64-bit hash)
+static const int kHashAttempts = 8;
+// ...and each bucket tries this many seeds before the salt is changed
+static const uint32_t kMaxSeed = 1u << 16;
+
+// Scrambles all 64 bits of a number (the "splitmix64" finisher)
+static uint64_t mixBits(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+static uint32_t slotFor(uint64_t hash, uint32_t seed, uint32_t slotCount) {
+    return static_cast<uint32_t>(mixBits(hash + seed * 0x9e3779b97f4a7c15ULL) % slotCount);
+}
+
+// ====================================================================
+// == READING A PACKED MAP
+// ====================================================================
+
+// FNV-1a over the bytes, then mixed so that every bit of the result depends on every byte
+uint64_t PackedMap::hashBytes(const char* data, size_t length, uint64_t salt) {
+    uint64_t h = 14695981039346656037ULL ^ mixBits(salt);
+    for (size_t i = 0; i < length; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ULL;
+    }
+    return mixBits(h);
+}
+
+string PackedMap::roomName(uint32_t room) const {
+    return string(nameChars + nameStart[room], nameStart[room + 1] - nameStart[room]);
+}
+
+bool PackedMap::hasPosition(uint32_t room) const {
+    return !std::isnan(x[room]);
+}
+
+int PackedMap::find(const string& name) const {
+    return find(name.data(), name.size());
+}
+
+int PackedMap::find(const char* name, size_t length) const {
+    auto nameIs = [&](uint32_t room) {
+        return nameStart[room + 1] - nameStart[room] == length && memcmp(nameChars + nameStart[room], name, length) == 0;
+    };
+
+    if (hashBuckets > 0) {
+        uint64_t hash = hashBytes(name, length, hashSalt);
+        int32_t room = hashSlots[slotFor(hash, hashSeeds[hash % hashBuckets], hashSlotCount)];
+        return room >= 0 && nameIs(room) ? room : -1;
+    }
+
+    // No table: the rooms with hallways are sorted by name
+    uint32_t low = 0, high = nodeCount;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        size_t midLength = nameStart[mid + 1] - nameStart[mid];
+        int order = memcmp(nameChars + nameStart[mid], name, min(midLength, length));
+        if (order < 0 || (order == 0 && midLength < length)) low = mid + 1;
+        else high = mid;
+    }
+    return low < nodeCount && nameIs(low) ? static_cast<int>(low) : -1;
+}
+
+// ====================================================================
+// == PACKING A MAP
+// ====================================================================
+
+void PackedMapStorage::packGraph(const Graph& graph, const set<pair<string, string>>& closed) {
+    // The adjacency list is a sorted map, so the rooms come out in name order
+    const auto& adjList = graph.getGraphData();
+    packed = PackedMap();
+    packed.nodeCount = packed.roomCount = static_cast<uint32_t>(adjList.size());
+
+    nameStart.assign(1, 0);
+    nameChars.clear();
+    for (const auto& pair : adjList) {
+        nameChars.insert(nameChars.end(), pair.first.begin(), pair.first.end());
+        nameStart.push_back(static_cast<uint32_t>(nameChars.size()));
+    }
+    x.assign(packed.roomCount, numeric_limits<double>::quiet_NaN());
+    y.assign(packed.roomCount, numeric_limits<double>::quiet_NaN());
+    pointAtArrays();
+    buildNameTable();
+
+    offsets.assign(1, 0);
+    targets.clear();
+    weights.clear();
+    for (const auto& pair : adjList) {
+        for (const auto& edge : pair.second) {
+            if (!closed.empty()) {
+                auto key = pair.first < edge.first ? make_pair(pair.first, edge.first) : make_pair(edge.first, pair.first);
+                if (closed.count(key)) continue;
+            }
+            targets.push_back(packed.find(edge.first));
+            weights.push_back(edge.second);
+        }
+        offsets.push_back(static_cast<int32_t>(targets.size()));
+    }
+    packed.edgeCount = static_cast<uint32_t>(targets.size());
+    pointAtArrays();
+}
+
+void PackedMapStorage::packMap(const PackedMap& base, const set<pair<string, string>>& closed) {
+    packed = base;
+    nameStart.assign(base.nameStart, base.nameStart + base.roomCount + 1);
+    nameChars.assign(base.nameChars, base.nameChars + base.nameStart[base.roomCount]);
+    x.assign(base.x, base.x + base.roomCount);
+    y.assign(base.y, base.y + base.roomCount);
+    // Same names, so the same name table works
+    hashSeeds.assign(base.hashSeeds, base.hashSeeds + base.hashBuckets);
+    hashSlots.assign(base.hashSlots, base.hashSlots + base.hashSlotCount);
+
+    // The closed hallways as (smaller, bigger) room numbers, sorted for a quick look-up
+    vector<pair<int, int>> closedIds;
+    for (const auto& hallway : closed) {
+        int a = base.find(hallway.first), b = base.find(hallway.second);
+        if (a >= 0 && b >= 0) closedIds.push_back({min(a, b), max(a, b)});
+    }
+    sort(closedIds.begin(), closedIds.end());
+
+    offsets.assign(1, 0);
+    targets.clear();
+    weights.clear();
+    for (uint32_t u = 0; u < base.nodeCount; ++u) {
+        for (int32_t e = base.offsets[u]; e < base.offsets[u + 1]; ++e) {
+            int v = base.targets[e];
+            pair<int, int> key(min<int>(u, v), max<int>(u, v));
+            if (!closedIds.empty() && binary_search(closedIds.begin(), closedIds.end(), key)) continue;
+            targets.push_back(v);
+            weights.push_back(base.weights[e]);
+        }
+        offsets.push_back(static_cast<int32_t>(targets.size()));
+    }
+    packed.edgeCount = static_cast<uint32_t>(targets.size());
+    pointAtArrays();
+}
+
+void PackedMapStorage::addPosition(const string& room, double px, double py) {
+    int id = packed.find(room);
+    if (id >= 0) {
+        x[id] = px;
+        y[id] = py;
+        return;
+    }
+    nameChars.insert(nameChars.end(), room.begin(), room.end());
+    nameStart.push_back(static_cast<uint32_t>(nameChars.size()));
+    x.push_back(px);
+    y.push_back(py);
+    ++packed.roomCount;
+    pointAtArrays();
+}
+
+const PackedMap& PackedMapStorage::finish() {
+    findComponents();
+    pointAtArrays();
+    return packed;
+}
+
+void PackedMapStorage::pointAtArrays() {
+    packed.offsets = offsets.data();
+    packed.targets = targets.data();
+    packed.weights = weights.data();
+    packed.nameStart = nameStart.data();
+    packed.nameChars = nameChars.data();
+    packed.x = x.data();
+    packed.y = y.data();
+    packed.hashSeeds = hashSeeds.data();
+    packed.hashSlots = hashSlots.data();
+    packed.component = component.data();
+    packed.componentSizes = componentSizes.data();
+}
+
+// "Hash and displace": names are dropped into buckets (about 4 per bucket), and the biggest
+// buckets pick a seed first, trying seeds until every name of the bucket lands in a free slot.
+// A quarter of the slots are left spare, so the last (small) buckets find room quickly too.
+void PackedMapStorage::buildNameTable() {
+    uint32_t n = packed.nodeCount;
+    uint32_t bucketCount = max(1u, (n + 3) / 4);
+    uint32_t slotCount = max(1u, n + n / 4);
+
+    vector<uint64_t> hashes(n);
+    vector<uint32_t> bucketStart(bucketCount + 1), bucketRooms(n);
+    vector<uint32_t> order(bucketCount);
+    vector<uint32_t> tried;
+
+    for (int attempt = 0; attempt < kHashAttempts; ++attempt) {
+        uint64_t salt = static_cast<uint64_t>(attempt);
+
+        // Sort the rooms into their buckets (count, running totals, then place)
+        fill(bucketStart.begin(), bucketStart.end(), 0);
+        for (uint32_t room = 0; room < n; ++room) {
+            hashes[room] = PackedMap::hashBytes(nameChars.data() + nameStart[room], nameStart[room + 1] - nameStart[room], salt);
+            ++bucketStart[hashes[room] % bucketCount + 1];
+        }
+        for (uint32_t b = 0; b < bucketCount; ++b) bucketStart[b + 1] += bucketStart[b];
+        vector<uint32_t> fillAt(bucketStart.begin(), bucketStart.end() - 1);
+        for (uint32_t room = 0; room < n; ++room) bucketRooms[fillAt[hashes[room] % bucketCount]++] = room;
+
+        for (uint32_t b = 0; b < bucketCount; ++b) order[b] = b;
+        stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return bucketStart[a + 1] - bucketStart[a] > bucketStart[b + 1] - bucketStart[b];
+        });
+
+        hashSeeds.assign(bucketCount, 0);
+        hashSlots.assign(slotCount, -1);
+        bool placedAll = true;
+        for (uint32_t b : order) {
+            if (bucketStart[b] == bucketStart[b + 1]) break;  // Only empty buckets left
+            bool placed = false;
+            for (uint32_t seed = 0; seed < kMaxSeed && !placed; ++seed) {
+                // Claim the slots one by one; give them back if one is already taken
+                tried.clear();
+                placed = true;
+                for (uint32_t i = bucketStart[b]; i < bucketStart[b + 1]; ++i) {
+                    uint32_t slot = slotFor(hashes[bucketRooms[i]], seed, slotCount);
+                    if (hashSlots[slot] >= 0) {
+                        placed = false;
+                        break;
+                    }
+                    hashSlots[slot] = static_cast<int32_t>(bucketRooms[i]);
+                    tried.push_back(slot);
+                }
+                if (placed) hashSeeds[b] = seed;
+                else for (uint32_t slot : tried) hashSlots[slot] = -1;
+            }
+            if (!placed) {
+                placedAll = false;
+                break;
+            }
+        }
+
+        if (placedAll) {
+            packed.hashSalt = salt;
+            packed.hashBuckets = bucketCount;
+            packed.hashSlotCount = slotCount;
+            pointAtArrays();
+            return;
+        }
+    }
+
+    // No luck: find() uses a binary search instead
+    hashSeeds.clear();
+    hashSlots.clear();
+    packed.hashBuckets = packed.hashSlotCount = 0;
+    pointAtArrays();
+}
+
+// Union-find: every room starts as its own group, and each hallway merges the groups of its two
+// rooms. Each group then gets a number, in order of its first room.
+void PackedMapStorage::findComponents() {
+    int n = static_cast<int>(packed.nodeCount);
+    vector<int> parent(n);
+    vector<int> groupSize(n, 1);
+    for (int i = 0; i < n; ++i) parent[i] = i;
+
+    auto root = [&parent](int r) {
+        while (parent[r] != r) {
+            parent[r] = parent[parent[r]];  // Halve the path on the way up, so later lookups are shorter
+            r = parent[r];
+        }
+        return r;
+    };
+
+    for (int u = 0; u < n; ++u) {
+        for (int e = offsets[u]; e < offsets[u + 1]; ++e) {
+            int a = root(u), b = root(targets[e]);
+            if (a == b) continue;
+            if (groupSize[a] < groupSize[b]) swap(a, b);  // Hang the smaller group under the bigger one
+            parent[b] = a;
+            groupSize[a] += groupSize[b];
+        }
+    }
+
+    component.assign(n, -1);
+    componentSizes.clear();
+    vector<int> numberOf(n, -1);
+    for (int i = 0; i < n; ++i) {
+        int r = root(i);
+        if (numberOf[r] < 0) {
+            numberOf[r] = static_cast<int>(componentSizes.size());
+            componentSizes.push_back(groupSize[r]);
+        }
+        component[i] = numberOf[r];
+    }
+    packed.componentCount = static_cast<uint32_t>(componentSizes.size());
+}
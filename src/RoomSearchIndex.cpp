@@ -0,0 +1,397 @@
+#include "../../include/trees/RoomSearchIndex.h"
+#include <algorithm>
+#include <cctype>
+#include <tuple>
+#include <utility>
+using namespace std;
+
+// Big trie nodes remember this many best rooms; smaller ones are simply scanned
+static const uint32_t kTopListSize = static_cast<uint32_t>(RoomSearchIndex::kMaxResults);
+
+// Typo search only looks closely at this many of the rooms sharing the most trigrams
+static const size_t kMaxFuzzyCandidates = 256;
+
+// ====================================================================
+// == NAMES
+// ====================================================================
+
+string RoomSearchIndex::displayNameFor(const string& name) {
+    string display = name;
+    replace(display.begin(), display.end(), '-', ' ');
+    if (display.size() > 2 && display.compare(display.size() - 2, 2, " O") == 0) display.resize(display.size() - 2);
+    return display;
+}
+
+// "EE-A-Lab-1" and "ee a  lab 1" both become "ee a lab 1"
+string RoomSearchIndex::normalize(string_view text) {
+    string out;
+    out.reserve(text.size());
+    for (char c : text) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (isalnum(u)) out += static_cast<char>(tolower(u));
+        else if (!out.empty() && out.back() != ' ') out += ' ';
+    }
+    if (!out.empty() && out.back() == ' ') out.pop_back();
+    return out;
+}
+
+string_view RoomSearchIndex::keyText(uint32_t key) const {
+    const Key& k = keys[key];
+    uint32_t start = normalizedStart[k.room] + k.offset;
+    return string_view(normalizedText).substr(start, normalizedStart[k.room + 1] - start);
+}
+
+// Smaller is better: start of the name first, then earlier words, shorter names, then A-Z
+// (rooms are numbered in A-Z order of their display names)
+uint64_t RoomSearchIndex::keyScore(uint32_t key) const {
+    const Key& k = keys[key];
+    uint64_t word = min<uint32_t>(k.word, 255);
+    uint64_t length = min<uint32_t>(normalizedStart[k.room + 1] - normalizedStart[k.room], 65535);
+    return (word << 48) | (length << 32) | k.room;
+}
+
+// ====================================================================
+// == BUILDING
+// ====================================================================
+
+void RoomSearchIndex::build(const vector<string>& roomNames) {
+    // Rooms in A-Z order of what the user sees
+    vector<pair<string, string>> rooms;  // (display name, name)
+    rooms.reserve(roomNames.size());
+    for (const string& n : roomNames) rooms.push_back({displayNameFor(n), n});
+    sort(rooms.begin(), rooms.end());
+
+    names.clear();
+    displayNames.clear();
+    normalizedText.clear();
+    normalizedStart.assign(1, 0);
+    keys.clear();
+    for (auto& room : rooms) {
+        uint32_t id = static_cast<uint32_t>(names.size());
+        string normal = normalize(room.first);
+
+        // One key for every word start
+        uint32_t word = 0;
+        for (size_t i = 0; i < normal.size(); ++i) {
+            if (i == 0 || normal[i - 1] == ' ') keys.push_back({id, static_cast<uint32_t>(i), word++});
+        }
+        normalizedText += normal;
+        normalizedStart.push_back(static_cast<uint32_t>(normalizedText.size()));
+        displayNames.push_back(move(room.first));
+        names.push_back(move(room.second));
+    }
+
+    // Sort the keys by their text, so every prefix is one block of keys
+    vector<uint32_t> order(keys.size());
+    for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+    sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        string_view ta = keyText(a), tb = keyText(b);
+        return ta != tb ? ta < tb : keys[a].room < keys[b].room;
+    });
+    vector<Key> sorted;
+    sorted.reserve(keys.size());
+    for (uint32_t i : order) sorted.push_back(keys[i]);
+    keys.swap(sorted);
+
+    trie.clear();
+    trie.push_back({0, static_cast<uint32_t>(keys.size()), 0});
+    buildTrieChildren(0);
+    buildTopLists();
+    buildTrigrams();
+}
+
+// Splits a node's keys by their next letter. A child's text runs as far as all of its keys
+// agree, so chains of single-child nodes never appear (that is the "compressed" part).
+void RoomSearchIndex::buildTrieChildren(uint32_t node) {
+    uint32_t begin = trie[node].begin, end = trie[node].end, depth = trie[node].depth;
+
+    // Keys that end right here sort first and have no child
+    uint32_t i = begin;
+    while (i < end && keyText(i).size() == depth) ++i;
+
+    uint32_t firstChild = static_cast<uint32_t>(trie.size());
+    while (i < end) {
+        char letter = keyText(i)[depth];
+        uint32_t j = i + 1;
+        while (j < end && keyText(j)[depth] == letter) ++j;
+
+        // Sorted keys: what the first and last share, everything in between shares too
+        string_view first = keyText(i), last = keyText(j - 1);
+        uint32_t common = depth + 1;
+        while (common < first.size() && common < last.size() && first[common] == last[common]) ++common;
+        trie.push_back({i, j, common});
+        i = j;
+    }
+    trie[node].firstChild = firstChild;
+    trie[node].childCount = static_cast<uint32_t>(trie.size()) - firstChild;
+
+    for (uint32_t child = firstChild; child < firstChild + trie[node].childCount; ++child) buildTrieChildren(child);
+}
+
+// Nodes with more keys than a result list get their best rooms worked out now, bottom-up
+// (children always come after their parent, so walking backwards does children first)
+void RoomSearchIndex::buildTopLists() {
+    topKeys.clear();
+    vector<uint32_t> candidates;
+    vector<bool> seen(names.size(), false);
+    for (uint32_t n = static_cast<uint32_t>(trie.size()); n-- > 0;) {
+        TrieNode& node = trie[n];
+        if (node.end - node.begin <= kTopListSize) continue;
+
+        // Keys ending here, plus each child's best keys (or all of a small child's keys)
+        candidates.clear();
+        uint32_t afterTerminal = node.childCount ? trie[node.firstChild].begin : node.end;
+        for (uint32_t k = node.begin; k < afterTerminal; ++k) candidates.push_back(k);
+        for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; ++c) {
+            const TrieNode& child = trie[c];
+            if (child.topCount) candidates.insert(candidates.end(), topKeys.begin() + child.topBegin,
+                                                  topKeys.begin() + child.topBegin + child.topCount);
+            else for (uint32_t k = child.begin; k < child.end; ++k) candidates.push_back(k);
+        }
+        sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b) { return keyScore(a) < keyScore(b); });
+
+        // Best key of each room only
+        uint32_t topBegin = static_cast<uint32_t>(topKeys.size());
+        for (uint32_t k : candidates) {
+            if (seen[keys[k].room]) continue;
+            seen[keys[k].room] = true;
+            topKeys.push_back(k);
+            if (topKeys.size() - topBegin == kTopListSize) break;
+        }
+        for (uint32_t k = topBegin; k < topKeys.size(); ++k) seen[keys[topKeys[k]].room] = false;
+        node.topBegin = topBegin;
+        node.topCount = static_cast<uint32_t>(topKeys.size()) - topBegin;
+    }
+}
+
+// Calls 'visit' for each trigram of each word, with '^' marking the start of a word
+// ("lab" gives "^la", "lab"). The end of a word is not marked, because the user may still be typing it.
+template <typename Visit>
+static void forEachTrigram(string_view text, Visit visit) {
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find(' ', start);
+        if (end == string_view::npos) end = text.size();
+        string word = "^" + string(text.substr(start, end - start));
+        for (size_t i = 0; i + 3 <= word.size(); ++i) {
+            visit((static_cast<uint32_t>(static_cast<unsigned char>(word[i])) << 16) |
+                  (static_cast<uint32_t>(static_cast<unsigned char>(word[i + 1])) << 8) |
+                  static_cast<unsigned char>(word[i + 2]));
+        }
+        start = end + 1;
+    }
+}
+
+void RoomSearchIndex::buildTrigrams() {
+    // (trigram, room) pairs, sorted, each pair once; then grouped by trigram
+    vector<pair<uint32_t, uint32_t>> pairs;
+    for (uint32_t room = 0; room < names.size(); ++room) {
+        string_view text = string_view(normalizedText).substr(normalizedStart[room], normalizedStart[room + 1] - normalizedStart[room]);
+        forEachTrigram(text, [&](uint32_t trigram) { pairs.push_back({trigram, room}); });
+    }
+    sort(pairs.begin(), pairs.end());
+    pairs.erase(unique(pairs.begin(), pairs.end()), pairs.end());
+
+    trigrams.clear();
+    trigramOffsets.clear();
+    trigramRooms.clear();
+    trigramRooms.reserve(pairs.size());
+    for (const auto& p : pairs) {
+        if (trigrams.empty() || trigrams.back() != p.first) {
+            trigrams.push_back(p.first);
+            trigramOffsets.push_back(static_cast<uint32_t>(trigramRooms.size()));
+        }
+        trigramRooms.push_back(p.second);
+    }
+    trigramOffsets.push_back(static_cast<uint32_t>(trigramRooms.size()));
+}
+
+// ====================================================================
+// == SEARCHING
+// ====================================================================
+
+bool RoomSearchIndex::descend(uint32_t& node, const string& query, size_t matched) const {
+    while (matched < query.size()) {
+        const TrieNode& current = trie[node];
+        if (matched < current.depth) {
+            // Still inside this node's text
+            if (keyText(current.begin)[matched] != query[matched]) return false;
+            ++matched;
+            continue;
+        }
+
+        // At the end of this node's text: take the child for the next letter
+        uint32_t next = UINT32_MAX;
+        for (uint32_t c = current.firstChild; c < current.firstChild + current.childCount; ++c) {
+            if (keyText(trie[c].begin)[current.depth] == query[matched]) { next = c; break; }
+        }
+        if (next == UINT32_MAX) return false;
+        node = next;
+    }
+    return true;
+}
+
+void RoomSearchIndex::collectPrefixMatches(uint32_t node, size_t limit, vector<Match>& out) const {
+    const TrieNode& n = trie[node];
+    if (n.topCount) {
+        for (uint32_t i = 0; i < n.topCount && out.size() < limit; ++i) out.push_back({keys[topKeys[n.topBegin + i]].room, 0});
+        return;
+    }
+
+    // Small node: rank its few keys right now
+    vector<uint32_t> found;
+    for (uint32_t k = n.begin; k < n.end; ++k) found.push_back(k);
+    sort(found.begin(), found.end(), [&](uint32_t a, uint32_t b) { return keyScore(a) < keyScore(b); });
+    for (uint32_t k : found) {
+        if (out.size() >= limit) break;
+        bool already = false;
+        for (const Match& m : out) already = already || m.room == keys[k].room;
+        if (!already) out.push_back({keys[k].room, 0});
+    }
+}
+
+// Fewest typos needed to make 'query' the start of some word-start of the room's name
+// (edit distance against any prefix); more than maxTypos if it can't be done in maxTypos
+int RoomSearchIndex::prefixTypos(const string& query, uint32_t room, int maxTypos) const {
+    string_view text = string_view(normalizedText).substr(normalizedStart[room], normalizedStart[room + 1] - normalizedStart[room]);
+    int best = maxTypos + 1;
+    vector<int> previous(query.size() + 1), current(query.size() + 1);
+
+    for (size_t start = 0; start < text.size(); ++start) {
+        if (start > 0 && text[start - 1] != ' ') continue;
+        string_view rest = text.substr(start, query.size() + maxTypos);
+
+        // Column = letters of the query used, row = letters of the name used
+        for (size_t q = 0; q <= query.size(); ++q) previous[q] = static_cast<int>(q);
+        best = min(best, previous[query.size()]);
+        for (size_t t = 1; t <= rest.size(); ++t) {
+            current[0] = static_cast<int>(t);
+            int rowBest = current[0];
+            for (size_t q = 1; q <= query.size(); ++q) {
+                int substitute = previous[q - 1] + (rest[t - 1] == query[q - 1] ? 0 : 1);
+                current[q] = min({substitute, previous[q] + 1, current[q - 1] + 1});
+                rowBest = min(rowBest, current[q]);
+            }
+            best = min(best, current[query.size()]);
+            swap(previous, current);
+            if (rowBest > maxTypos) break;  // Can only get worse from here
+        }
+        if (best == 0) break;
+    }
+    return best;
+}
+
+vector<RoomSearchIndex::Match> RoomSearchIndex::search(string_view text, size_t limit) const {
+    Session session(*this);
+    return session.update(text, limit);
+}
+
+void RoomSearchIndex::Session::reset() {
+    lastQuery.clear();
+    node = 0;
+    noPrefixMatch = false;
+    matches.clear();
+}
+
+const vector<RoomSearchIndex::Match>& RoomSearchIndex::Session::update(string_view text, size_t limit) {
+    string query = normalize(text);
+    limit = min(limit, kMaxResults);
+    matches.clear();
+    if (query.empty() || index.size() == 0) {
+        reset();
+        return matches;
+    }
+
+    // Typed more letters: carry on from the last node. Anything else: start from the top.
+    bool extendsLast = !lastQuery.empty() && query.compare(0, lastQuery.size(), lastQuery) == 0;
+    if (!extendsLast) {
+        node = 0;
+        noPrefixMatch = false;
+    }
+    if (!noPrefixMatch) {
+        noPrefixMatch = !index.descend(node, query, extendsLast ? lastQuery.size() : 0);
+    }
+    lastQuery = query;
+
+    if (!noPrefixMatch) index.collectPrefixMatches(node, limit, matches);
+    if (matches.size() < limit) addFuzzyMatches(query, limit);
+    return matches;
+}
+
+// Rooms that share enough trigrams with the text, checked with a real edit distance
+void RoomSearchIndex::Session::addFuzzyMatches(const string& query, size_t limit) {
+    if (query.size() < 3) return;
+    int maxTypos = query.size() < 6 ? 1 : 2;
+
+    vector<uint32_t> queryTrigrams;
+    forEachTrigram(query, [&](uint32_t t) { queryTrigrams.push_back(t); });
+    sort(queryTrigrams.begin(), queryTrigrams.end());
+    queryTrigrams.erase(unique(queryTrigrams.begin(), queryTrigrams.end()), queryTrigrams.end());
+
+    // Each typo breaks at most three trigrams
+    int needed = static_cast<int>(queryTrigrams.size()) - 3 * maxTypos;
+    if (needed < 1) needed = 1;
+
+    // Posting lists of the query's trigrams, shortest first. Trigrams that almost every room
+    // has ("^ro", "oom" on a campus full of rooms) say little and cost a lot, so they are
+    // skipped as long as a more telling one is left. If all of them are that common, only the
+    // first rooms (A-Z) of the shortest list are looked at.
+    vector<pair<uint32_t, size_t>> lists;  // (length, slot)
+    for (uint32_t t : queryTrigrams) {
+        auto found = lower_bound(index.trigrams.begin(), index.trigrams.end(), t);
+        if (found == index.trigrams.end() || *found != t) continue;
+        size_t slot = found - index.trigrams.begin();
+        lists.push_back({index.trigramOffsets[slot + 1] - index.trigramOffsets[slot], slot});
+    }
+    sort(lists.begin(), lists.end());
+    size_t commonLength = max<size_t>(kMaxFuzzyCandidates, index.size() / 8);
+    size_t maxTouched = index.size();
+    if (!lists.empty() && lists.front().first > commonLength) {
+        lists.resize(1);
+        needed = 1;
+        maxTouched = 4 * kMaxFuzzyCandidates;
+    } else {
+        while (!lists.empty() && lists.back().first > commonLength) {
+            lists.pop_back();
+            needed = max(1, needed - 1);
+        }
+    }
+
+    if (counts.size() != index.size()) counts.assign(index.size(), 0);
+    touched.clear();
+    for (const auto& list : lists) {
+        size_t slot = list.second;
+        for (uint32_t i = index.trigramOffsets[slot]; i < index.trigramOffsets[slot + 1]; ++i) {
+            uint32_t room = index.trigramRooms[i];
+            if (counts[room]++ == 0) touched.push_back(room);
+            if (touched.size() >= maxTouched) break;
+        }
+    }
+
+    vector<pair<int, uint32_t>> candidates;  // (-shared trigrams, room)
+    for (uint32_t room : touched) {
+        if (counts[room] >= needed) candidates.push_back({-static_cast<int>(counts[room]), room});
+        counts[room] = 0;
+    }
+    if (candidates.size() > kMaxFuzzyCandidates) {
+        nth_element(candidates.begin(), candidates.begin() + kMaxFuzzyCandidates, candidates.end());
+        candidates.resize(kMaxFuzzyCandidates);
+    }
+
+    // (typos, length, room): fewest typos first, then the same order as exact matches
+    vector<tuple<int, uint32_t, uint32_t>> fuzzy;
+    for (const auto& c : candidates) {
+        uint32_t room = c.second;
+        bool already = false;
+        for (const Match& m : matches) already = already || m.room == room;
+        if (already) continue;
+        int typos = index.prefixTypos(query, room, maxTypos);
+        if (typos == 0 || typos > maxTypos) continue;  // 0 would have been an exact match already
+        fuzzy.emplace_back(typos, index.normalizedStart[room + 1] - index.normalizedStart[room], room);
+    }
+    sort(fuzzy.begin(), fuzzy.end());
+    for (const auto& f : fuzzy) {
+        if (matches.size() >= limit) break;
+        matches.push_back({get<2>(f), get<0>(f)});
+    }
+}
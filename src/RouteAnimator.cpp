@@ -0,0 +1,173 @@
+#include "../../include/gui/RouteAnimator.h"
+#include "../../include/core/Trace.h"
+#include "../../include/core/GeometryKernels.h"
+#include <QGraphicsItem>
+#include <QGraphicsScene>
+#include <algorithm>
+using namespace std;
+
+// ====================================================================
+// == TIMING SETTINGS
+// ====================================================================
+
+// Walking speed in scene pixels per second (same pace as the old per-step animations)
+static const qreal kWalkSpeed = 62.5;
+
+// How long the icon waits at the stairs before jumping to the next floor, and after the jump
+static const qreal kFloorPauseMs = 1000.0;
+static const qreal kFloorSwitchMs = 100.0;
+
+// ~60 frames per second
+static const int kFrameIntervalMs = 16;
+
+// ====================================================================
+// == BUILDING THE TIMELINE
+// ====================================================================
+
+RouteAnimator::RouteAnimator(QGraphicsItem* icon, QObject* parent) : QObject(parent), m_icon(icon) {
+    m_timer.setTimerType(Qt::PreciseTimer);
+    m_timer.setInterval(kFrameIntervalMs);
+    connect(&m_timer, &QTimer::timeout, this, &RouteAnimator::onFrame);
+}
+
+// Turn the list of stops into timeline segments (done once per route)
+void RouteAnimator::setRoute(const vector<Stop>& stops) {
+    TraceSpan span("RouteAnimator::setRoute", "animation");
+    stop();
+    m_segments.clear();
+
+    // Measure every step of the route in one batch (step i goes from stop i to stop i + 1)
+    size_t steps = stops.empty() ? 0 : stops.size() - 1;
+    PointArrays points;
+    points.reserve(stops.size());
+    for (const Stop& s : stops) points.push(s.pos.x(), s.pos.y());
+    vector<double> lengths(steps);
+    if (steps > 0) {
+        GeometryKernels::distances(points.x.data(), points.y.data(), points.x.data() + 1, points.y.data() + 1, steps, lengths.data());
+    }
+
+    qreal time = 0;
+    for (size_t i = 0; i < steps; ++i) {
+        const Stop& a = stops[i];
+        const Stop& b = stops[i + 1];
+        if (!a.scene || !b.scene) continue;
+
+        if (a.scene == b.scene) {
+            // Same floor: walk in a straight line at constant speed
+            qreal duration = lengths[i] / kWalkSpeed * 1000.0;
+            m_segments.push_back({a.scene, a.pos, b.pos, time, duration});
+            time += duration;
+        } else {
+            // Different floor: wait at the stairs, then appear on the next floor
+            m_segments.push_back({a.scene, a.pos, a.pos, time, kFloorPauseMs});
+            time += kFloorPauseMs;
+            m_segments.push_back({b.scene, b.pos, b.pos, time, kFloorSwitchMs});
+            time += kFloorSwitchMs;
+        }
+    }
+
+    // A route with a single stop still shows the icon at that stop
+    if (m_segments.empty() && !stops.empty() && stops[0].scene) {
+        m_segments.push_back({stops[0].scene, stops[0].pos, stops[0].pos, 0, 0});
+    }
+
+    m_current = 0;
+    m_positionMs = 0;
+    applyPosition();
+}
+
+// ====================================================================
+// == PLAYBACK CONTROLS
+// ====================================================================
+
+void RouteAnimator::play() {
+    if (m_segments.empty()) return;
+    if (m_positionMs >= totalDuration()) seek(0);  // Replay from the start
+    m_clock.start();
+    m_timer.start();
+}
+
+void RouteAnimator::pause() {
+    m_timer.stop();
+}
+
+// Stop and hide the icon
+void RouteAnimator::stop() {
+    m_timer.stop();
+    if (m_icon->scene()) m_icon->scene()->removeItem(m_icon);
+    m_icon->hide();
+}
+
+// Jump to any point of the route. Uses a binary search over the segment start times.
+void RouteAnimator::seek(qreal progress) {
+    if (m_segments.empty()) return;
+    m_positionMs = qBound(0.0, progress, 1.0) * totalDuration();
+
+    auto it = upper_bound(m_segments.begin(), m_segments.end(), m_positionMs,
+                          [](qreal t, const Segment& s) { return t < s.startMs; });
+    m_current = (it == m_segments.begin()) ? 0 : static_cast<size_t>(it - m_segments.begin()) - 1;
+
+    applyPosition();
+    m_clock.restart();
+}
+
+void RouteAnimator::setSpeed(qreal multiplier) {
+    if (multiplier > 0) m_speed = multiplier;
+}
+
+bool RouteAnimator::isPlaying() const {
+    return m_timer.isActive();
+}
+
+qreal RouteAnimator::totalDuration() const {
+    if (m_segments.empty()) return 0;
+    return m_segments.back().startMs + m_segments.back().durationMs;
+}
+
+qreal RouteAnimator::progress() const {
+    qreal total = totalDuration();
+    return total > 0 ? m_positionMs / total : 1.0;
+}
+
+// ====================================================================
+// == PER-FRAME UPDATE
+// ====================================================================
+
+void RouteAnimator::onFrame() {
+    // Move the clock forward by the real time that passed (times the speed setting)
+    m_positionMs += m_clock.restart() * m_speed;
+
+    // Step over the segments we finished (usually zero or one per frame)
+    while (m_current + 1 < m_segments.size() && m_positionMs >= m_segments[m_current + 1].startMs) {
+        ++m_current;
+    }
+
+    bool done = m_positionMs >= totalDuration();
+    if (done) m_positionMs = totalDuration();
+
+    applyPosition();
+    emit progressChanged(progress());
+
+    if (done) {
+        m_timer.stop();
+        emit finished();
+    }
+}
+
+// Put the icon where the timeline says it should be
+void RouteAnimator::applyPosition() {
+    if (m_segments.empty()) return;
+    const Segment& seg = m_segments[m_current];
+
+    // Changing floors: move the icon into the other scene
+    if (m_icon->scene() != seg.scene) {
+        if (m_icon->scene()) m_icon->scene()->removeItem(m_icon);
+        seg.scene->addItem(m_icon);
+        emit sceneChanged(seg.scene);
+    }
+
+    qreal t = seg.durationMs > 0 ? (m_positionMs - seg.startMs) / seg.durationMs : 1.0;
+    t = qBound(0.0, t, 1.0);
+    m_icon->setPos(seg.from + (seg.to - seg.from) * t);
+    m_icon->show();
+}
@@ -0,0 +1,137 @@
+#include "../../include/graph/SearchStats.h"
+#include <algorithm>
+#include <cstdio>
+
+using namespace std;
+
+static const char* const kPhaseNames[] = { "setup", "search", "path" };
+
+void SearchCounters::add(const SearchCounters& other) {
+    nodesSettled += other.nodesSettled;
+    edgesRelaxed += other.edgesRelaxed;
+    heapPushes += other.heapPushes;
+    heapPops += other.heapPops;
+    stalePops += other.stalePops;
+    for (int i = 0; i < static_cast<int>(SearchPhase::Count); ++i) phaseMicros[i] += other.phaseMicros[i];
+}
+
+// ====================================================================
+// == LATENCY HISTOGRAM
+// ====================================================================
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+// Values below 16 get a bucket each; above that, bucket = (power of two, top 4 bits after it)
+int LatencyHistogram::bucketFor(uint64_t value) {
+    if (value < kSubBuckets) return static_cast<int>(value);
+    int highBit = 63 - __builtin_clzll(value);
+    int sub = static_cast<int>((value >> (highBit - 4)) & (kSubBuckets - 1));
+    return (highBit - 3) * kSubBuckets + sub;
+}
+
+// Largest value that still falls into 'bucket'
+uint64_t LatencyHistogram::bucketTop(int bucket) {
+    if (bucket < kSubBuckets) return static_cast<uint64_t>(bucket);
+    int highBit = bucket / kSubBuckets + 3;
+    uint64_t width = uint64_t(1) << (highBit - 4);
+    uint64_t low = static_cast<uint64_t>(kSubBuckets + bucket % kSubBuckets) << (highBit - 4);
+    return low + width - 1;
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    counts[bucketFor(value)].fetch_add(1, memory_order_relaxed);
+    total.fetch_add(1, memory_order_relaxed);
+    sum.fetch_add(value, memory_order_relaxed);
+    uint64_t seen = maxValue.load(memory_order_relaxed);
+    while (value > seen && !maxValue.compare_exchange_weak(seen, value, memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::reset() {
+    for (auto& c : counts) c.store(0, memory_order_relaxed);
+    total.store(0, memory_order_relaxed);
+    sum.store(0, memory_order_relaxed);
+    maxValue.store(0, memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const {
+    uint64_t n = count();
+    return n ? static_cast<double>(sum.load(memory_order_relaxed)) / n : 0.0;
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const {
+    uint64_t n = count();
+    if (n == 0) return 0;
+    uint64_t wanted = std::max<uint64_t>(1, static_cast<uint64_t>(fraction * n + 0.5));
+    uint64_t seen = 0;
+    for (int b = 0; b < kBuckets; ++b) {
+        seen += counts[b].load(memory_order_relaxed);
+        if (seen >= wanted) return std::min(bucketTop(b), max());
+    }
+    return max();
+}
+
+// ====================================================================
+// == REGISTRY
+// ====================================================================
+
+void SearchStatsRegistry::record(const SearchCounters& counters, double micros, bool treeHit, bool warmHit) {
+    queries.fetch_add(1, memory_order_relaxed);
+    if (treeHit) treeHits.fetch_add(1, memory_order_relaxed);
+    if (warmHit) warmHits.fetch_add(1, memory_order_relaxed);
+    heapPushes.fetch_add(counters.heapPushes, memory_order_relaxed);
+    heapPops.fetch_add(counters.heapPops, memory_order_relaxed);
+    stalePops.fetch_add(counters.stalePops, memory_order_relaxed);
+
+    // Times are kept in nanoseconds so sub-microsecond searches on small maps still show up
+    totalNanos.record(static_cast<uint64_t>(micros * 1000));
+    for (int i = 0; i < static_cast<int>(SearchPhase::Count); ++i) {
+        phaseNanos[i].record(static_cast<uint64_t>(counters.phaseMicros[i] * 1000));
+    }
+    settledPerQuery.record(counters.nodesSettled);
+    relaxedPerQuery.record(counters.edgesRelaxed);
+}
+
+void SearchStatsRegistry::reset() {
+    totalNanos.reset();
+    for (auto& h : phaseNanos) h.reset();
+    settledPerQuery.reset();
+    relaxedPerQuery.reset();
+    queries = 0;
+    treeHits = 0;
+    warmHits = 0;
+    heapPushes = 0;
+    heapPops = 0;
+    stalePops = 0;
+}
+
+string SearchStatsRegistry::report() const {
+    if (!kSearchStatsEnabled) {
+        return "Search statistics are compiled out (build with -DCAMPUS_SEARCH_STATS=1 to enable them).\n";
+    }
+
+    string text;
+    char line[256];
+    uint64_t n = queries.load();
+    snprintf(line, sizeof(line), "Route searches: %llu (%llu answered from a prefetched tree, %llu from a remembered route)\n",
+             (unsigned long long)n, (unsigned long long)treeHits.load(), (unsigned long long)warmHits.load());
+    text += line;
+    snprintf(line, sizeof(line), "Heap: %llu pushes, %llu pops, %llu stale pops\n",
+             (unsigned long long)heapPushes.load(), (unsigned long long)heapPops.load(),
+             (unsigned long long)stalePops.load());
+    text += line;
+
+    // 'scale' turns the stored value into the printed unit (ns -> us for times)
+    auto row = [&](const char* name, const LatencyHistogram& h, double scale, const char* unit) {
+        snprintf(line, sizeof(line), "  %-14s mean %10.1f  p50 %10.1f  p90 %10.1f  p99 %10.1f  max %10.1f %s\n", name,
+                 h.mean() * scale, h.percentile(0.50) * scale, h.percentile(0.90) * scale, h.percentile(0.99) * scale,
+                 h.max() * scale, unit);
+        text += line;
+    };
+    row("total", totalNanos, 0.001, "us");
+    for (int i = 0; i < static_cast<int>(SearchPhase::Count); ++i) row(kPhaseNames[i], phaseNanos[i], 0.001, "us");
+    row("nodes settled", settledPerQuery, 1.0, "");
+    row("edges relaxed", relaxedPerQuery, 1.0, "");
+    return text;
+}
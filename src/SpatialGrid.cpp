@@ -0,0 +1,147 @@
+#include "../../include/core/SpatialGrid.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+// When the cell size is picked automatically: about this many items per cell
+static const double kItemsPerCell = 4.0;
+
+// How far (squared) a point is from a box; 0 if it is inside
+static double distanceSquared(const SpatialGrid::Box& box, double x, double y) {
+    double dx = max({box.minX - x, 0.0, x - box.maxX});
+    double dy = max({box.minY - y, 0.0, y - box.maxY});
+    return dx * dx + dy * dy;
+}
+
+// ====================================================================
+// == BUILDING
+// ====================================================================
+
+void SpatialGrid::clear() {
+    items.clear();
+    columns = rows = 0;
+    cellStart.assign(1, 0);
+    cellItems.clear();
+}
+
+void SpatialGrid::build(const vector<Box>& boxes, double requestedCellSize) {
+    clear();
+    if (boxes.empty()) return;
+    items = boxes;
+
+    bounds = items[0];
+    for (const Box& b : items) {
+        bounds.minX = min(bounds.minX, b.minX);
+        bounds.minY = min(bounds.minY, b.minY);
+        bounds.maxX = max(bounds.maxX, b.maxX);
+        bounds.maxY = max(bounds.maxY, b.maxY);
+    }
+    double width = bounds.maxX - bounds.minX;
+    double height = bounds.maxY - bounds.minY;
+
+    // Pick a cell size that puts a handful of items in each cell (on average)
+    cellSize = requestedCellSize;
+    if (cellSize <= 0) cellSize = sqrt(max(width * height, 1.0) * kItemsPerCell / items.size());
+    cellSize = max(cellSize, 1e-6);
+    // ...but never make far more cells than items (a few far-away rooms would blow it up)
+    double maxCells = 4.0 * items.size() + 64;
+    while ((floor(width / cellSize) + 1) * (floor(height / cellSize) + 1) > maxCells) cellSize *= 2;
+    columns = static_cast<int>(floor(width / cellSize)) + 1;
+    rows = static_cast<int>(floor(height / cellSize)) + 1;
+
+    // File every item under each cell its box touches (count, running totals, then place)
+    cellStart.assign(static_cast<size_t>(columns) * rows + 1, 0);
+    for (const Box& b : items) {
+        for (int r = cellRow(b.minY); r <= cellRow(b.maxY); ++r)
+            for (int c = cellColumn(b.minX); c <= cellColumn(b.maxX); ++c)
+                ++cellStart[r * columns + c + 1];
+    }
+    for (size_t i = 1; i < cellStart.size(); ++i) cellStart[i] += cellStart[i - 1];
+    cellItems.resize(cellStart.back());
+    vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+    for (uint32_t i = 0; i < items.size(); ++i) {
+        const Box& b = items[i];
+        for (int r = cellRow(b.minY); r <= cellRow(b.maxY); ++r)
+            for (int c = cellColumn(b.minX); c <= cellColumn(b.maxX); ++c)
+                cellItems[fill[r * columns + c]++] = i;
+    }
+}
+
+int SpatialGrid::cellColumn(double x) const {
+    double c = floor((x - bounds.minX) / cellSize);
+    return static_cast<int>(min(max(c, 0.0), static_cast<double>(columns - 1)));
+}
+
+int SpatialGrid::cellRow(double y) const {
+    double r = floor((y - bounds.minY) / cellSize);
+    return static_cast<int>(min(max(r, 0.0), static_cast<double>(rows - 1)));
+}
+
+// ====================================================================
+// == QUERIES
+// ====================================================================
+
+// Looks at the cells in rings around the point: first its own cell, then the 8 around it, ...
+// Ring k is at least (k - 1) cells away, so we can stop once that is further than the best so far.
+uint32_t SpatialGrid::nearest(double x, double y, double maxDistance) const {
+    if (items.empty() || maxDistance < 0) return kNone;
+    int centerColumn = cellColumn(x);
+    int centerRow = cellRow(y);
+    uint32_t best = kNone;
+    double bestDistance = maxDistance * maxDistance;
+
+    auto visitCell = [&](int r, int c) {
+        if (r < 0 || r >= rows || c < 0 || c >= columns) return;
+        size_t cell = static_cast<size_t>(r) * columns + c;
+        for (uint32_t i = cellStart[cell]; i < cellStart[cell + 1]; ++i) {
+            uint32_t item = cellItems[i];
+            double d = distanceSquared(items[item], x, y);
+            if (d < bestDistance || (d == bestDistance && item < best)) {
+                bestDistance = d;
+                best = item;
+            }
+        }
+    };
+
+    int lastRing = max(columns, rows);
+    for (int ring = 0; ring <= lastRing; ++ring) {
+        double ringDistance = (ring - 1) * cellSize;
+        if (ring > 0 && ringDistance * ringDistance > bestDistance) break;
+
+        // Only the border of the ring: full rows at the top and bottom, the two end cells in between
+        int r0 = centerRow - ring, r1 = centerRow + ring;
+        int c0 = centerColumn - ring, c1 = centerColumn + ring;
+        for (int c = c0; c <= c1; ++c) {
+            visitCell(r0, c);
+            if (r1 != r0) visitCell(r1, c);
+        }
+        for (int r = r0 + 1; r < r1; ++r) {
+            visitCell(r, c0);
+            if (c1 != c0) visitCell(r, c1);
+        }
+    }
+    return best;
+}
+
+void SpatialGrid::query(const Box& area, vector<uint32_t>& out) const {
+    if (items.empty() || area.maxX < bounds.minX || area.minX > bounds.maxX ||
+        area.maxY < bounds.minY || area.minY > bounds.maxY) return;
+
+    size_t first = out.size();
+    int c0 = cellColumn(area.minX), c1 = cellColumn(area.maxX);
+    int r0 = cellRow(area.minY), r1 = cellRow(area.maxY);
+    for (int r = r0; r <= r1; ++r) {
+        for (int c = c0; c <= c1; ++c) {
+            size_t cell = static_cast<size_t>(r) * columns + c;
+            for (uint32_t i = cellStart[cell]; i < cellStart[cell + 1]; ++i) {
+                uint32_t item = cellItems[i];
+                const Box& b = items[item];
+                // An item spread over several cells is only reported from the first of them
+                if (c != max(c0, cellColumn(b.minX)) || r != max(r0, cellRow(b.minY))) continue;
+                if (b.maxX < area.minX || b.minX > area.maxX || b.maxY < area.minY || b.minY > area.maxY) continue;
+                out.push_back(item);
+            }
+        }
+    }
+    sort(out.begin() + first, out.end());
+}
@@ -0,0 +1,134 @@
+#include "../../include/core/SyntheticCampus.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace std;
+
+// Grid spacing between hallway junctions, and how far rooms sit from their hallway
+static const double kHallSpacingX = 60.0;
+static const double kHallSpacingY = 90.0;
+static const double kRoomOffset = 30.0;
+
+// Floor names, bottom to top (ground floor first, like CS-G / CS-1)
+static const char* const kFloorNames[] = { "G", "1", "2", "3", "4", "5" };
+
+void SyntheticCampus::writeCsv(ostream& out) const {
+    out << "SECTION 1: NODES\n";
+    for (const auto& node : nodes) {
+        out << node.first << ", " << node.second.x << ", " << node.second.y << '\n';
+    }
+    out << "\nSECTION 2: EDGES\n";
+    for (const MapEdgeRecord& edge : edges) {
+        out << edge.from << ", " << edge.to << ", " << edge.weight << '\n';
+    }
+}
+
+SyntheticCampus generateSyntheticCampus(size_t targetNodes, unsigned seed) {
+    SyntheticCampus campus;
+    mt19937 random(seed);
+    uniform_real_distribution<double> jitter(0.8, 1.2);
+    bernoulli_distribution corridorGap(0.1);
+
+    // Walking cost is the drawn distance with a bit of noise (doors, corners, crowds)
+    auto connect = [&](const string& from, const MapPosition& a, const string& to, const MapPosition& b) {
+        double length = hypot(a.x - b.x, a.y - b.y) / 4.0;
+        campus.edges.push_back({from, to, max(1, static_cast<int>(lround(length * jitter(random))))});
+    };
+    auto addNode = [&](const string& name, double x, double y) {
+        campus.nodes.push_back({name, {x, y}});
+        return campus.nodes.back().second;
+    };
+
+    // Pick a shape: more buildings and floors as the campus grows
+    targetNodes = max<size_t>(targetNodes, 20);
+    int floors = targetNodes < 500 ? 2 : targetNodes < 20000 ? 3 : 5;
+    int buildings = max(1, static_cast<int>(lround(sqrt(targetNodes / 200.0))));
+    size_t perFloor = max<size_t>(targetNodes / (buildings * floors), 8);
+
+    // Each hallway junction carries up to two rooms, so about a third of a floor is hallways
+    size_t halls = max<size_t>(perFloor / 3, 2);
+    int cols = max(2, static_cast<int>(ceil(sqrt(halls * 2.0))));  // Corridors are longer than wide
+    int rows = max(1, static_cast<int>((halls + cols - 1) / cols));
+
+    // Buildings sit on a square-ish campus grid with a walkway in front of each one
+    int campusCols = max(1, static_cast<int>(ceil(sqrt(static_cast<double>(buildings)))));
+    double buildingWidth = cols * kHallSpacingX + 200;
+    double buildingDepth = rows * kHallSpacingY + 200;
+
+    vector<string> walkways;
+    vector<MapPosition> walkwayPositions;
+    campus.nodes.reserve(targetNodes + targetNodes / 10);
+    campus.edges.reserve(targetNodes * 2);
+
+    for (int b = 0; b < buildings; ++b) {
+        string building = "B" + to_string(b + 1);
+        double originX = (b % campusCols) * buildingWidth;
+        double originY = (b / campusCols) * buildingDepth;
+        vector<string> stairsBelow;
+
+        for (int f = 0; f < floors; ++f) {
+            string prefix = building + "-" + kFloorNames[f] + "-";
+            size_t budget = perFloor;
+            int roomNumber = 1;
+
+            // Hallway grid: columns always connected, rows always connected along the first row,
+            // the other row links are sometimes missing (walls) without splitting the floor apart
+            vector<string> hallNames(rows * cols);
+            vector<MapPosition> hallPos(rows * cols);
+            for (int r = 0; r < rows; ++r) {
+                for (int c = 0; c < cols; ++c) {
+                    int i = r * cols + c;
+                    hallNames[i] = prefix + "Hall-" + to_string(r + 1) + "-" + to_string(c + 1);
+                    hallPos[i] = addNode(hallNames[i], originX + 100 + c * kHallSpacingX, originY + 100 + r * kHallSpacingY);
+                    if (budget) --budget;
+                    if (c > 0 && (r == 0 || !corridorGap(random))) connect(hallNames[i - 1], hallPos[i - 1], hallNames[i], hallPos[i]);
+                    if (r > 0) connect(hallNames[i - cols], hallPos[i - cols], hallNames[i], hallPos[i]);
+                }
+            }
+
+            // Two stairwells (at opposite corners) going up to the next floor
+            vector<string> stairs;
+            vector<MapPosition> stairsPos;
+            int stairHalls[2] = { 0, rows * cols - 1 };
+            for (int s = 0; s < 2; ++s) {
+                const MapPosition& at = hallPos[stairHalls[s]];
+                stairs.push_back(prefix + "Stairs-" + to_string(s + 1));
+                stairsPos.push_back(addNode(stairs.back(), at.x - 20, at.y - 20));
+                connect(stairs.back(), stairsPos.back(), hallNames[stairHalls[s]], at);
+                if (!stairsBelow.empty()) campus.edges.push_back({stairsBelow[s], stairs.back(), 20});
+                if (budget) --budget;
+            }
+            stairsBelow = stairs;
+
+            // Rooms on both sides of each hallway junction until the floor is full; every 7th is a lab
+            for (int i = 0; i < rows * cols && budget; ++i) {
+                for (int side = -1; side <= 1 && budget; side += 2, --budget) {
+                    string kind = roomNumber % 7 == 0 ? "Lab-" : "Room-";
+                    string name = prefix + kind + to_string(roomNumber++);
+                    MapPosition pos = addNode(name, hallPos[i].x, hallPos[i].y + side * kRoomOffset);
+                    connect(name, pos, hallNames[i], hallPos[i]);
+                }
+            }
+
+            // Ground floor: the entrance, and the walkway outside it
+            if (f == 0) {
+                const MapPosition& door = hallPos[cols / 2];
+                string entrance = prefix + "Entrance";
+                MapPosition entrancePos = addNode(entrance, door.x, door.y - 50);
+                connect(entrance, entrancePos, hallNames[cols / 2], door);
+
+                walkways.push_back("Outdoor-Walkway-" + to_string(b + 1));
+                walkwayPositions.push_back(addNode(walkways.back(), door.x, originY + 20));
+                connect(walkways.back(), walkwayPositions.back(), entrance, entrancePos);
+            }
+        }
+    }
+
+    // Walkways follow the campus grid: each one connects to its neighbor on the left and above
+    for (int b = 0; b < buildings; ++b) {
+        if (b % campusCols > 0) connect(walkways[b - 1], walkwayPositions[b - 1], walkways[b], walkwayPositions[b]);
+        if (b >= campusCols) connect(walkways[b - campusCols], walkwayPositions[b - campusCols], walkways[b], walkwayPositions[b]);
+    }
+    return campus;
+}
@@ -0,0 +1,119 @@
+#include "../../include/core/TaskGraph.h"
+#include "../../include/core/Trace.h"
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+using namespace std;
+
+void TaskGraph::addTask(const string& name, function<void()> work, const vector<string>& dependsOn, Where where) {
+    Task task;
+    task.name = name;
+    task.work = move(work);
+    task.where = where;
+
+    int index = static_cast<int>(tasks.size());
+    for (const string& dependency : dependsOn) {
+        bool found = false;
+        for (Task& other : tasks) {
+            if (other.name != dependency) continue;
+            other.dependents.push_back(index);
+            task.dependencyCount++;
+            found = true;
+            break;
+        }
+        if (!found) throw invalid_argument("TaskGraph: unknown dependency '" + dependency + "' for '" + name + "'");
+    }
+    tasks.push_back(move(task));
+}
+
+// Everything the workers and the calling thread share while run() is going.
+// Held by shared_ptr so a worker that is just finishing never touches freed memory.
+struct TaskGraph::RunState {
+    ThreadPool* pool;
+    chrono::steady_clock::time_point started;
+    mutex lock;
+    condition_variable changed;
+    vector<int> waitingFor;
+    queue<int> callerQueue;      // Ready tasks that must run on the calling thread
+    size_t finished = 0;
+    exception_ptr firstError;
+
+    double msSinceStart() const {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+    }
+};
+
+// Hand a task whose dependencies are done to whoever has to run it ('state->lock' must be held)
+void TaskGraph::schedule(const shared_ptr<RunState>& state, int index) {
+    if (tasks[index].where == Where::CallingThread) {
+        state->callerQueue.push(index);
+    } else {
+        state->pool->enqueue([this, state, index]() { execute(state, index); });
+    }
+}
+
+// Run one task, then release the tasks that were waiting for it
+void TaskGraph::execute(const shared_ptr<RunState>& state, int index) {
+    Task& task = tasks[index];
+    double begin = state->msSinceStart();
+    try {
+        TraceSpan span("stage", "startup", task.name);
+        task.work();
+    } catch (...) {
+        lock_guard<mutex> guard(state->lock);
+        if (!state->firstError) state->firstError = current_exception();
+    }
+    double end = state->msSinceStart();
+
+    lock_guard<mutex> guard(state->lock);
+    stageTimings[index] = {task.name, begin, end - begin, task.where == Where::CallingThread};
+    for (int next : task.dependents) {
+        if (--state->waitingFor[next] == 0) schedule(state, next);
+    }
+    state->finished++;
+    state->changed.notify_all();
+}
+
+void TaskGraph::run(ThreadPool& pool) {
+    auto state = make_shared<RunState>();
+    state->pool = &pool;
+    state->started = chrono::steady_clock::now();
+    state->waitingFor.resize(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i) state->waitingFor[i] = tasks[i].dependencyCount;
+    stageTimings.assign(tasks.size(), Timing());
+
+    // Kick off everything that has no dependencies
+    {
+        lock_guard<mutex> guard(state->lock);
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            if (state->waitingFor[i] == 0) schedule(state, static_cast<int>(i));
+        }
+    }
+
+    // This thread runs its own tasks as they become ready, and otherwise just waits
+    unique_lock<mutex> guard(state->lock);
+    while (state->finished < tasks.size()) {
+        state->changed.wait(guard, [&]() { return state->finished == tasks.size() || !state->callerQueue.empty(); });
+        if (state->callerQueue.empty()) continue;
+
+        int index = state->callerQueue.front();
+        state->callerQueue.pop();
+        guard.unlock();
+        execute(state, index);
+        guard.lock();
+    }
+
+    wallMs = state->msSinceStart();
+    if (state->firstError) rethrow_exception(state->firstError);
+}
+
+const vector<TaskGraph::Timing>& TaskGraph::timings() const {
+    return stageTimings;
+}
+
+double TaskGraph::totalMs() const {
+    return wallMs;
+}
@@ -0,0 +1,50 @@
+#include "../../include/core/ThreadPool.h"
+#include "../../include/core/Trace.h"
+using namespace std;
+
+// Start the workers. Each one sleeps until a job shows up in the queue.
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0) threadCount = max(1u, thread::hardware_concurrency());
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers.emplace_back([this, i]() {
+            if (TraceRecorder::instance().isEnabled()) TraceRecorder::instance().setThreadName("worker " + to_string(i + 1));
+            workerLoop();
+        });
+    }
+}
+
+// Let the workers finish the queued jobs, then wait for all of them to exit
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (thread& worker : workers) worker.join();
+}
+
+void ThreadPool::enqueue(function<void()> job) {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        jobs.push(move(job));
+    }
+    wakeUp.notify_one();
+}
+
+size_t ThreadPool::size() const {
+    return workers.size();
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        function<void()> job;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            wakeUp.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (stopping && jobs.empty()) return;
+            job = move(jobs.front());
+            jobs.pop();
+        }
+        job();
+    }
+}
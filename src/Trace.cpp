@@ -0,0 +1,90 @@
+#include "../../include/core/Trace.h"
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+TraceRecorder& TraceRecorder::instance() {
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+void TraceRecorder::start(const string& outputPath) {
+    path = outputPath;
+    origin = chrono::steady_clock::now();
+    enabled.store(true);
+}
+
+bool TraceRecorder::startFromEnvironment() {
+    const char* file = getenv("CAMPUS_TRACE");
+    if (file && *file) start(file);
+    return isEnabled();
+}
+
+// Each thread finds its buffer once and then keeps a pointer to it
+TraceRecorder::ThreadBuffer& TraceRecorder::bufferForThisThread() {
+    thread_local shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        buffer = make_shared<ThreadBuffer>();
+        lock_guard<mutex> lock(buffersMutex);
+        buffer->tid = static_cast<int>(buffers.size()) + 1;
+        buffer->name = "thread " + to_string(buffer->tid);
+        buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+void TraceRecorder::setThreadName(const string& name) {
+    ThreadBuffer& buffer = bufferForThisThread();
+    lock_guard<mutex> lock(buffer.mutex);
+    buffer.name = name;
+}
+
+void TraceRecorder::addSpan(const char* name, const char* category, const string& detail,
+                            chrono::steady_clock::time_point begin, chrono::steady_clock::time_point end) {
+    if (!isEnabled()) return;
+    ThreadBuffer& buffer = bufferForThisThread();
+    double startUs = chrono::duration<double, micro>(begin - origin).count();
+    double durationUs = chrono::duration<double, micro>(end - begin).count();
+    lock_guard<mutex> lock(buffer.mutex);
+    buffer.events.push_back({name, category, detail, startUs, durationUs});
+}
+
+// Room and floor names are plain text, but be safe with quotes and backslashes
+static string jsonEscape(const string& text) {
+    string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out += c;
+    }
+    return out;
+}
+
+bool TraceRecorder::stop() {
+    if (!enabled.exchange(false)) return true;
+
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) return false;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    lock_guard<mutex> lockAll(buffersMutex);
+    for (const auto& buffer : buffers) {
+        lock_guard<mutex> lock(buffer->mutex);
+
+        // Metadata event that gives the track its name
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", buffer->tid, jsonEscape(buffer->name).c_str());
+        first = false;
+
+        for (const Event& e : buffer->events) {
+            // "drawFloorSchematic: EE-A" reads better on the timeline than a separate argument
+            string name = e.detail.empty() ? e.name : string(e.name) + ": " + e.detail;
+            fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                    jsonEscape(name).c_str(), e.category, e.startUs, e.durationUs, buffer->tid);
+        }
+        buffer->events.clear();
+    }
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
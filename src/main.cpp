@@ -1,7 +1,22 @@
 #include "../include/gui/MainWindow.h"
+#include "../include/core/Trace.h"
 #include <QApplication>
+#include <cstdio>
+#include <cstring>
 
 int main(int argc, char *argv[]) {
+    // Tracing: "--trace run.json" or CAMPUS_TRACE=run.json writes a Chrome trace on exit
+    bool traceFromFlag = false;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--trace") == 0) {
+            TraceRecorder::instance().start(argv[i + 1]);
+            traceFromFlag = true;
+            break;
+        }
+    }
+    if (!traceFromFlag) TraceRecorder::instance().startFromEnvironment();
+    if (TraceRecorder::instance().isEnabled()) TraceRecorder::instance().setThreadName("main (GUI)");
+
     // Create the main application object.
     QApplication a(argc, argv);
 
@@ -10,5 +25,8 @@ int main(int argc, char *argv[]) {
     w.show();
 
     // Start the application's event loop.
-    return a.exec();
+    int result = a.exec();
+
+    if (!TraceRecorder::instance().stop()) std::fprintf(stderr, "Could not write the trace file\n");
+    return result;
 }
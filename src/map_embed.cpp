@@ -0,0 +1,155 @@
+// campus_embed: turns the map CSV into C++ tables that are compiled into the program.
+// Runs at build time; the program then starts without reading or parsing the map file at all.
+//
+//   campus_embed --map data/campus_map_detailed.csv --out EmbeddedCampusMap.h
+//   campus_embed --map data/campus_map_detailed.csv --image /dev/shm/campus.img
+//
+// --image writes the same tables as a graph image instead (see GraphImage.h), for routing
+// processes that map one shared copy of the map at run time.
+// The map is loaded with the normal loader (so it gets the same map check), packed into a
+// PackedMap and written out as constexpr arrays: CSR hallways, names, coordinates, the perfect-hash
+// name table and the components. CampusGis::embeddedMap() picks them up when the program is
+// built with CAMPUS_EMBEDDED_MAP defined and the output folder on the include path.
+#include "../include/core/CampusGis.h"
+#include "../include/core/GraphImage.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+using namespace std;
+
+namespace {
+
+struct Options {
+    string mapFile;
+    string outFile;
+    string imageFile;
+};
+
+void printUsage() {
+    cerr << "usage: campus_embed --map FILE [--out HEADER] [--image FILE]\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--map" && hasValue) options.mapFile = argv[++i];
+        else if (arg == "--out" && hasValue) options.outFile = argv[++i];
+        else if (arg == "--image" && hasValue) options.imageFile = argv[++i];
+        else return false;
+    }
+    return !options.mapFile.empty() && (!options.outFile.empty() || !options.imageFile.empty());
+}
+
+// One constexpr array, 12 values to a line. C++ has no empty arrays, so an empty one gets a
+// single 0 (the counts say it isn't used).
+template <typename T, typename Format>
+void writeArray(FILE* out, const char* type, const char* name, const T* values, size_t count, Format format) {
+    fprintf(out, "constexpr %s %s[] = {", type, name);
+    if (count == 0) fprintf(out, "0");
+    for (size_t i = 0; i < count; ++i) {
+        fprintf(out, i % 12 == 0 ? "\n    " : " ");
+        format(out, values[i]);
+        if (i + 1 < count) fputc(',', out);
+    }
+    fprintf(out, "\n};\n\n");
+}
+
+// The names as one string literal, cut into lines. Anything unusual is written as a three-digit
+// octal escape (never "\1" followed by a digit, which would read as one longer escape).
+void writeNameChars(FILE* out, const char* chars, size_t count) {
+    fprintf(out, "constexpr char kNameChars[] =");
+    if (count == 0) fprintf(out, " \"\"");
+    for (size_t i = 0; i < count; ++i) {
+        if (i % 80 == 0) fprintf(out, "%s\n    \"", i ? "\"" : "");
+        unsigned char c = static_cast<unsigned char>(chars[i]);
+        if (c < 0x20 || c >= 0x7f || c == '"' || c == '\\' || c == '?') fprintf(out, "\\%03o", c);
+        else fputc(c, out);
+    }
+    fprintf(out, "%s;\n\n", count ? "\"" : "");
+}
+
+void writeInt(FILE* out, int32_t value) { fprintf(out, "%d", value); }
+void writeUnsigned(FILE* out, uint32_t value) { fprintf(out, "%uu", value); }
+void writeCoordinate(FILE* out, double value) {
+    if (std::isnan(value)) fprintf(out, "kNoPosition");
+    else fprintf(out, "%.17g", value);
+}
+
+bool writeHeader(const string& path, const string& mapFile, uint64_t sourceHash, const PackedMap& map) {
+    FILE* out = fopen(path.c_str(), "w");
+    if (!out) return false;
+
+    fprintf(out, "// Generated by campus_embed from %s - do not edit.\n", mapFile.c_str());
+    fprintf(out, "// %u rooms with hallways, %u rooms with only a position, %u hallways.\n",
+            map.nodeCount, map.roomCount - map.nodeCount, map.edgeCount / 2);
+    fprintf(out, "#ifndef EMBEDDEDCAMPUSMAP_H\n#define EMBEDDEDCAMPUSMAP_H\n\n");
+    fprintf(out, "#include <cstdint>\n#include <limits>\n\n");
+    fprintf(out, "namespace EmbeddedCampusMap {\n\n");
+    fprintf(out, "constexpr uint64_t kSourceHash = 0x%016llxULL;  // PackedMap::hashBytes of the map file\n",
+            static_cast<unsigned long long>(sourceHash));
+    fprintf(out, "constexpr uint32_t kNodeCount = %u;\n", map.nodeCount);
+    fprintf(out, "constexpr uint32_t kRoomCount = %u;\n", map.roomCount);
+    fprintf(out, "constexpr uint32_t kEdgeCount = %u;\n", map.edgeCount);
+    fprintf(out, "constexpr uint64_t kHashSalt = %lluULL;\n", static_cast<unsigned long long>(map.hashSalt));
+    fprintf(out, "constexpr uint32_t kHashBuckets = %u;\n", map.hashBuckets);
+    fprintf(out, "constexpr uint32_t kHashSlotCount = %u;\n", map.hashSlotCount);
+    fprintf(out, "constexpr uint32_t kComponentCount = %u;\n", map.componentCount);
+    fprintf(out, "constexpr double kNoPosition = std::numeric_limits<double>::quiet_NaN();\n\n");
+
+    writeArray(out, "int32_t", "kOffsets", map.offsets, map.nodeCount + 1, writeInt);
+    writeArray(out, "int32_t", "kTargets", map.targets, map.edgeCount, writeInt);
+    writeArray(out, "int32_t", "kWeights", map.weights, map.edgeCount, writeInt);
+    writeArray(out, "uint32_t", "kNameStart", map.nameStart, map.roomCount + 1, writeUnsigned);
+    writeNameChars(out, map.nameChars, map.nameStart[map.roomCount]);
+    writeArray(out, "double", "kX", map.x, map.roomCount, writeCoordinate);
+    writeArray(out, "double", "kY", map.y, map.roomCount, writeCoordinate);
+    writeArray(out, "uint32_t", "kHashSeeds", map.hashSeeds, map.hashBuckets, writeUnsigned);
+    writeArray(out, "int32_t", "kHashSlots", map.hashSlots, map.hashSlotCount, writeInt);
+    writeArray(out, "int32_t", "kComponent", map.component, map.nodeCount, writeInt);
+    writeArray(out, "int32_t", "kComponentSizes", map.componentSizes, map.componentCount, writeInt);
+
+    fprintf(out, "} // namespace EmbeddedCampusMap\n\n#endif // EMBEDDEDCAMPUSMAP_H\n");
+    return fclose(out) == 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    // The fingerprint is taken from the file's bytes, so any edit to the map changes it
+    ifstream file(options.mapFile, ios::binary);
+    string bytes((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    CampusGis gis(1);
+    if (!file || !gis.loadMapData(options.mapFile)) {
+        cerr << "campus_embed: could not load map " << options.mapFile << '\n';
+        return 1;
+    }
+
+    PackedMapStorage storage;
+    storage.packGraph(gis.getGraph(), {});
+    for (const auto& pair : gis.getNodePositions()) storage.addPosition(pair.first, pair.second.x, pair.second.y);
+    const PackedMap& map = storage.finish();
+
+    uint64_t sourceHash = PackedMap::hashBytes(bytes.data(), bytes.size());
+    if (!options.outFile.empty() && !writeHeader(options.outFile, options.mapFile, sourceHash, map)) {
+        cerr << "campus_embed: could not write " << options.outFile << '\n';
+        return 1;
+    }
+    string error;
+    if (!options.imageFile.empty() && !GraphImage::write(options.imageFile, map, sourceHash, &error)) {
+        cerr << "campus_embed: could not write " << options.imageFile << ": " << error << '\n';
+        return 1;
+    }
+    cerr << "campus_embed: " << map.nodeCount << " rooms, " << map.edgeCount / 2 << " hallways -> "
+         << (options.outFile.empty() ? options.imageFile : options.outFile) << '\n';
+    return 0;
+}
@@ -0,0 +1,263 @@
+// campus_route: the routing core without any windows.
+// Loads a map, reads "source,dest" or "source,via,dest" lines, and streams one result per line.
+// Only needs QtCore (for the CSV loader), so it runs on headless build/batch machines.
+//
+//   campus_route --map campus_map_detailed.csv [--queries FILE] [--format csv|json]
+//                [--threads N] [--no-path] [--quiet] [--search-stats] [--cache DIR]
+//   campus_route --image /dev/shm/campus.img ...
+//
+// --image attaches to a graph image (see GraphImage.h) instead of loading a map: many routing
+// processes can share one copy of the map that way, and start without loading anything.
+// --cache keeps the packed map and the most asked-for routes in DIR between runs (see MapCache.h).
+//
+// Queries come from stdin when --queries is not given (or is "-"). Results go to stdout in
+// the same order as the queries; throughput and latency stats go to stderr at the end.
+#include "../include/core/CampusGis.h"
+#include "../include/graph/SearchStats.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace {
+
+struct Options {
+    string mapFile;
+    string imageFile;
+    string cacheDir;
+    string queryFile = "-";
+    bool json = false;
+    bool printPath = true;
+    bool quiet = false;
+    bool searchStats = false;
+    unsigned threads = 0;
+};
+
+// One answered query, plus how long the worker spent on it
+struct Answer {
+    RouteRequest request;
+    RouteResult result;
+    bool unknownRoom = false;
+    double micros = 0;
+};
+
+void printUsage() {
+    cerr << "usage: campus_route --map FILE|--image FILE [--queries FILE|-] [--format csv|json]\n"
+            "                    [--threads N] [--no-path] [--quiet] [--search-stats] [--cache DIR]\n"
+            "Each query line is \"source,dest\" or \"source,via,dest\" (# starts a comment).\n"
+            "--map may be left out when the map is compiled in (see campus_embed).\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--map" && hasValue) options.mapFile = argv[++i];
+        else if (arg == "--image" && hasValue) options.imageFile = argv[++i];
+        else if (arg == "--cache" && hasValue) options.cacheDir = argv[++i];
+        else if (arg == "--queries" && hasValue) options.queryFile = argv[++i];
+        else if (arg == "--format" && hasValue) {
+            string format = argv[++i];
+            if (format != "csv" && format != "json") return false;
+            options.json = format == "json";
+        }
+        else if (arg == "--threads" && hasValue) options.threads = static_cast<unsigned>(atoi(argv[++i]));
+        else if (arg == "--no-path") options.printPath = false;
+        else if (arg == "--quiet") options.quiet = true;
+        else if (arg == "--search-stats") options.searchStats = true;
+        else return false;
+    }
+    // An image or the compiled-in map is packed already, so there would be nothing to cache
+    if (!options.cacheDir.empty() && (options.mapFile.empty() || !options.imageFile.empty())) {
+        cerr << "campus_route: --cache only works with --map\n";
+        return false;
+    }
+    return !options.mapFile.empty() || !options.imageFile.empty() || CampusGis::embeddedMap();
+}
+
+string trim(const string& text) {
+    size_t first = text.find_first_not_of(" \t\r");
+    if (first == string::npos) return "";
+    size_t last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+// "A,B" or "A,Via,B". Returns false for blank lines, comments, the header and malformed lines.
+bool parseQuery(const string& line, RouteRequest& request) {
+    string text = trim(line);
+    if (text.empty() || text[0] == '#') return false;
+
+    vector<string> parts;
+    stringstream fields(text);
+    string field;
+    while (getline(fields, field, ',')) parts.push_back(trim(field));
+
+    if (parts.size() == 2) request = {parts[0], "", parts[1]};
+    else if (parts.size() == 3) request = {parts[0], parts[1], parts[2]};
+    else return false;
+    return request.source != "source";  // Skip a "source,via,dest" header line
+}
+
+// Room names are plain text from the CSV, but quotes/backslashes would still break JSON
+string jsonString(const string& text) {
+    string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') { out += '\\'; out += c; }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        }
+        else out += c;
+    }
+    return out + "\"";
+}
+
+const char* statusOf(const Answer& answer) {
+    if (answer.result.cancelled) return "cancelled";
+    if (answer.unknownRoom) return "unknown_room";
+    return answer.result.distance < 0 ? "no_path" : "ok";
+}
+
+void writeCsvHeader(ostream& out, const Options& options) {
+    out << "source,via,dest,status,distance,hops" << (options.printPath ? ",path" : "") << '\n';
+}
+
+void writeAnswer(ostream& out, const Answer& answer, const Options& options) {
+    const RouteRequest& q = answer.request;
+    const RouteResult& r = answer.result;
+    int hops = r.path.empty() ? 0 : static_cast<int>(r.path.size()) - 1;
+
+    if (options.json) {
+        out << "{\"source\":" << jsonString(q.source) << ",\"via\":" << jsonString(q.via)
+            << ",\"dest\":" << jsonString(q.dest) << ",\"status\":\"" << statusOf(answer)
+            << "\",\"distance\":" << r.distance << ",\"hops\":" << hops;
+        if (options.printPath) {
+            out << ",\"path\":[";
+            for (size_t i = 0; i < r.path.size(); ++i) out << (i ? "," : "") << jsonString(r.path[i]);
+            out << ']';
+        }
+        out << "}\n";
+    } else {
+        // Room names never contain commas (the map file is split on them), so ';' joins the path
+        out << q.source << ',' << q.via << ',' << q.dest << ',' << statusOf(answer) << ',' << r.distance << ',' << hops;
+        if (options.printPath) {
+            out << ',';
+            for (size_t i = 0; i < r.path.size(); ++i) out << (i ? ";" : "") << r.path[i];
+        }
+        out << '\n';
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    CampusGis gis(options.threads);
+    gis.setCacheDirectory(options.cacheDir);
+
+    auto loadStart = chrono::steady_clock::now();
+    string error;
+    if (!options.imageFile.empty()) {
+        if (!gis.attachGraphImage(options.imageFile, &error)) {
+            cerr << "campus_route: could not attach " << options.imageFile << ": " << error << '\n';
+            return 1;
+        }
+    } else {
+        // --map naming the compiled-in map's own file uses the compiled-in tables too
+        bool embedded = options.mapFile.empty() || CampusGis::isEmbeddedMap(options.mapFile);
+        bool loaded = embedded ? gis.loadPackedMap(*CampusGis::embeddedMap()) : gis.loadMapData(options.mapFile);
+        if (!loaded) {
+            cerr << "campus_route: could not load map " << options.mapFile << '\n';
+            return 1;
+        }
+    }
+    double loadMs = chrono::duration<double, milli>(chrono::steady_clock::now() - loadStart).count();
+
+    ifstream queryFile;
+    if (options.queryFile != "-") {
+        queryFile.open(options.queryFile);
+        if (!queryFile) {
+            cerr << "campus_route: could not open queries " << options.queryFile << '\n';
+            return 1;
+        }
+    }
+    istream& in = options.queryFile == "-" ? cin : queryFile;
+
+    ios::sync_with_stdio(false);
+    ostream& out = cout;
+    if (!options.json) writeCsvHeader(out, options);
+
+    // Keep the workers busy while answers are written in query order: at most 'window' queries
+    // are in flight, and the oldest one is written as soon as it is done.
+    ThreadPool& workers = gis.getWorkers();
+    const size_t window = workers.size() * 256;
+    deque<future<Answer>> inFlight;
+    LatencyHistogram latencies;  // Fixed size (nanoseconds), however many queries are streamed through
+    size_t found = 0, noPath = 0, unknown = 0;
+
+    auto writeOldest = [&]() {
+        Answer answer = inFlight.front().get();
+        inFlight.pop_front();
+        latencies.record(static_cast<uint64_t>(answer.micros * 1000));
+        if (answer.unknownRoom) ++unknown;
+        else if (answer.result.distance < 0) ++noPath;
+        else ++found;
+        if (!options.quiet) writeAnswer(out, answer, options);
+    };
+
+    auto runStart = chrono::steady_clock::now();
+    string line;
+    while (getline(in, line)) {
+        RouteRequest request;
+        if (!parseQuery(line, request)) continue;
+
+        inFlight.push_back(workers.submit([&gis, request]() {
+            Answer answer;
+            answer.request = request;
+            auto start = chrono::steady_clock::now();
+            answer.result = gis.findRoute(request);
+            answer.micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+            if (answer.result.distance < 0) {
+                GraphSnapshotStore::Reader graph = gis.readGraph();
+                answer.unknownRoom = !graph || graph->nodeId(request.source) < 0 || graph->nodeId(request.dest) < 0 ||
+                                     (!request.via.empty() && graph->nodeId(request.via) < 0);
+            }
+            return answer;
+        }));
+        if (inFlight.size() >= window) writeOldest();
+    }
+    while (!inFlight.empty()) writeOldest();
+    out.flush();
+    double wallMs = chrono::duration<double, milli>(chrono::steady_clock::now() - runStart).count();
+
+    // Stats go to stderr so stdout stays a clean CSV / JSON lines stream
+    size_t count = static_cast<size_t>(latencies.count());
+    auto micros = [](uint64_t nanos) { return nanos / 1000.0; };
+
+    string mapName = !options.imageFile.empty() ? options.imageFile
+                   : !options.mapFile.empty() ? options.mapFile : string("compiled-in map");
+    fprintf(stderr, "map:        %s (loaded in %.1f ms%s)\n", mapName.c_str(), loadMs,
+            gis.loadedFromCache() ? ", from the cache" : "");
+    fprintf(stderr, "threads:    %zu\n", workers.size());
+    fprintf(stderr, "queries:    %zu (ok %zu, no path %zu, unknown room %zu)\n", count, found, noPath, unknown);
+    fprintf(stderr, "wall time:  %.1f ms\n", wallMs);
+    fprintf(stderr, "throughput: %.0f queries/s\n", wallMs > 0 ? count * 1000.0 / wallMs : 0.0);
+    fprintf(stderr, "latency us: mean %.1f  p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+            latencies.mean() / 1000.0, micros(latencies.percentile(0.50)), micros(latencies.percentile(0.90)),
+            micros(latencies.percentile(0.99)), micros(latencies.max()));
+    if (options.searchStats) fprintf(stderr, "%s", gis.searchStatsReport().c_str());
+    return 0;
+}
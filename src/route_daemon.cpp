@@ -0,0 +1,496 @@
+// campus_routed: a small local routing service for other programs (signage, timetables, ...).
+// Loads the map once and answers route requests over a Unix socket (or 127.0.0.1 TCP).
+//
+//   campus_routed --map campus_map_detailed.csv [--socket /tmp/campus_routed.sock | --tcp PORT]
+//                 [--threads N] [--cache DIR]
+//   campus_routed --image /dev/shm/campus.img ...    (shares one mapped copy of the map, see GraphImage.h)
+//
+// WIRE FORMAT (all integers little-endian, strings are u16 length + bytes, no terminator)
+//
+//   Every message is one frame:  u32 length-of-the-rest | body
+//
+//   Request body:   u8 type | u32 id | ...
+//     type 1 (route):  str source | str via (may be empty) | str dest
+//     type 2 (stats):  nothing
+//
+//   Response body:  u8 type | u32 id | ...
+//     type 1 (route):  u8 status | i32 distance | u32 server micros | u16 room count | str room...
+//                      status: 0 ok, 1 no path, 2 unknown room, 3 bad request
+//     type 2 (stats):  str JSON with counters and latency percentiles
+//
+// Clients may send many requests without waiting (pipelining). Requests are answered by a fixed
+// pool of worker threads as soon as each one is done, so replies can come back out of order;
+// 'id' is copied from the request so the client can match them up. At most 256 requests per
+// connection wait for an answer; past that the daemon stops reading until the replies are taken.
+#include "../include/core/CampusGis.h"
+#include "../include/graph/SearchStats.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+using namespace std;
+
+namespace {
+
+enum MessageType : uint8_t { kRouteMessage = 1, kStatsMessage = 2 };
+enum RouteStatus : uint8_t { kOk = 0, kNoPath = 1, kUnknownRoom = 2, kBadRequest = 3 };
+
+// Frames bigger than this are treated as garbage and the connection is dropped
+const uint32_t kMaxFrame = 64 * 1024;
+
+// Requests one connection may have waiting for an answer, and reply bytes it may have waiting to
+// be sent. A client that keeps sending without reading its replies stops being read from (TCP
+// then slows it down) instead of filling the worker queue and the reply buffer.
+const size_t kMaxInFlight = 256;
+const size_t kMaxUnsentBytes = 1024 * 1024;
+
+// How often a connection's reader wakes up to send replies the socket had no room for, and how
+// long a client that stopped reading gets to take the last replies once it has hung up
+const int kPollMillis = 50;
+const int kDrainMillis = 2000;
+
+volatile sig_atomic_t stopRequested = 0;
+void onStopSignal(int) { stopRequested = 1; }
+
+// ====================================================================
+// == LATENCY ACCOUNTING
+// ====================================================================
+
+// Counters shared by all workers. Latency (request read -> reply written) goes into the same
+// lock-free histogram as campus_route and --search-stats (nanoseconds, within ~6%), so their
+// percentiles can be compared directly.
+struct ServiceStats {
+    atomic<uint64_t> requests{0};
+    atomic<uint64_t> found{0};
+    atomic<uint64_t> noPath{0};
+    atomic<uint64_t> unknown{0};
+    atomic<uint64_t> badRequests{0};
+    LatencyHistogram latencyNanos;
+
+    void record(RouteStatus status, uint64_t nanos) {
+        ++requests;
+        if (status == kOk) ++found;
+        else if (status == kNoPath) ++noPath;
+        else if (status == kUnknownRoom) ++unknown;
+        else ++badRequests;
+        latencyNanos.record(nanos);
+    }
+
+    string toJson(double uptimeSeconds) const {
+        uint64_t count = requests.load();
+        auto micros = [](uint64_t nanos) { return nanos / 1000.0; };
+        char text[512];
+        snprintf(text, sizeof(text),
+                 "{\"requests\":%llu,\"ok\":%llu,\"no_path\":%llu,\"unknown_room\":%llu,\"bad_request\":%llu,"
+                 "\"uptime_s\":%.1f,\"qps\":%.1f,\"latency_us\":{\"mean\":%.1f,\"p50\":%.1f,\"p90\":%.1f,"
+                 "\"p99\":%.1f,\"max\":%.1f}}",
+                 (unsigned long long)count, (unsigned long long)found.load(), (unsigned long long)noPath.load(),
+                 (unsigned long long)unknown.load(), (unsigned long long)badRequests.load(), uptimeSeconds,
+                 uptimeSeconds > 0 ? count / uptimeSeconds : 0.0, latencyNanos.mean() / 1000.0,
+                 micros(latencyNanos.percentile(0.50)), micros(latencyNanos.percentile(0.90)),
+                 micros(latencyNanos.percentile(0.99)), micros(latencyNanos.max()));
+        return text;
+    }
+};
+
+// ====================================================================
+// == FRAME ENCODING
+// ====================================================================
+
+void putU16(string& out, uint16_t v) { out += char(v & 0xFF); out += char(v >> 8); }
+void putU32(string& out, uint32_t v) { for (int i = 0; i < 4; ++i) out += char((v >> (8 * i)) & 0xFF); }
+void putString(string& out, const string& s) {
+    size_t length = min<size_t>(s.size(), 0xFFFF);
+    putU16(out, static_cast<uint16_t>(length));
+    out.append(s, 0, length);
+}
+
+// Reads fields from one request body; any read past the end marks the whole request as bad
+struct FrameReader {
+    const unsigned char* data;
+    size_t size;
+    size_t pos = 0;
+    bool ok = true;
+
+    uint32_t u32() {
+        if (pos + 4 > size) { ok = false; return 0; }
+        uint32_t v = data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16) | (uint32_t(data[pos + 3]) << 24);
+        pos += 4;
+        return v;
+    }
+    uint8_t u8() {
+        if (pos + 1 > size) { ok = false; return 0; }
+        return data[pos++];
+    }
+    string str() {
+        if (pos + 2 > size) { ok = false; return {}; }
+        size_t length = data[pos] | (data[pos + 1] << 8);
+        pos += 2;
+        if (pos + length > size) { ok = false; return {}; }
+        string s(reinterpret_cast<const char*>(data + pos), length);
+        pos += length;
+        return s;
+    }
+};
+
+// Wraps a body into a frame (length prefix in front)
+string frame(const string& body) {
+    string out;
+    out.reserve(body.size() + 4);
+    putU32(out, static_cast<uint32_t>(body.size()));
+    return out + body;
+}
+
+// ====================================================================
+// == CONNECTIONS
+// ====================================================================
+
+// One client. The reader thread owns reading; workers add replies to the outbox.
+// Nobody ever waits for the client to read: what the socket has no room for stays in the outbox
+// and the reader sends it once the socket is writable again.
+struct Connection {
+    int fd;
+    atomic<bool> finished{false};  // Reader thread is done (the acceptor may join it)
+    thread reader;
+
+    mutex outMutex;
+    condition_variable answered;
+    string outbox;         // Whole reply frames (so replies never interleave), not sent yet
+    size_t inFlight = 0;   // Requests handed to the workers, not answered yet
+    bool broken = false;   // Sending failed: the client is gone, replies are dropped
+
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection() { close(fd); }
+
+    // Reader: false while the client has too much waiting; otherwise counts one more request
+    bool startRequest() {
+        lock_guard<mutex> lock(outMutex);
+        if (inFlight >= kMaxInFlight || outbox.size() >= kMaxUnsentBytes) return false;
+        ++inFlight;
+        return true;
+    }
+
+    // Reader, when full with nothing to send: until a worker answers (or a reply is left over)
+    void waitForAnswers() {
+        unique_lock<mutex> lock(outMutex);
+        answered.wait_for(lock, chrono::milliseconds(kPollMillis),
+                          [this]() { return inFlight < kMaxInFlight || !outbox.empty(); });
+    }
+    bool hasUnsent() {
+        lock_guard<mutex> lock(outMutex);
+        return !outbox.empty();
+    }
+
+    // Workers: the answer to one request
+    void sendReply(const string& bytes) {
+        {
+            lock_guard<mutex> lock(outMutex);
+            --inFlight;
+            if (!broken) {
+                outbox += bytes;
+                flushLocked();
+            }
+        }
+        answered.notify_one();
+    }
+
+    void flush() {
+        lock_guard<mutex> lock(outMutex);
+        flushLocked();
+    }
+
+    // Sends as much of the outbox as the socket takes right now (never waits)
+    void flushLocked() {
+        size_t sent = 0;
+        while (sent < outbox.size()) {
+            ssize_t n = ::send(fd, outbox.data() + sent, outbox.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) break;
+            if (n <= 0) {
+                broken = true;
+                outbox.clear();
+                return;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        outbox.erase(0, sent);
+    }
+};
+
+class RoutingService {
+public:
+    RoutingService(CampusGis& gis) : gis(gis), started(chrono::steady_clock::now()) {}
+
+    // Reads frames until the client disconnects and hands each one to the workers.
+    // Pipelined clients send many small frames back to back, so read in big chunks and cut
+    // as many frames out of each chunk as it holds. While the client has kMaxInFlight requests
+    // open (or too many replies unsent), it isn't read from; its frames wait in the socket.
+    void serve(shared_ptr<Connection> connection) {
+        vector<unsigned char> buffer;
+        size_t start = 0;  // First byte of buffer not yet used
+        unsigned char chunk[64 * 1024];
+        auto received = chrono::steady_clock::now();
+        bool open = true;
+        while (open) {
+            bool full = false;
+            while (buffer.size() - start >= 4) {
+                const unsigned char* header = buffer.data() + start;
+                uint32_t length = header[0] | (header[1] << 8) | (header[2] << 16) | (uint32_t(header[3]) << 24);
+                if (length > kMaxFrame) { open = false; break; }
+                if (buffer.size() - start - 4 < length) break;  // Rest of this frame hasn't arrived yet
+                if (!connection->startRequest()) { full = true; break; }
+
+                vector<unsigned char> body(header + 4, header + 4 + length);
+                start += 4 + length;
+                gis.getWorkers().enqueue([this, connection, body = move(body), received]() {
+                    answer(*connection, body, received);
+                });
+            }
+            if (!open) break;
+
+            // Drop the used bytes now and then, instead of after every frame
+            if (start > buffer.size() / 2) {
+                buffer.erase(buffer.begin(), buffer.begin() + static_cast<ptrdiff_t>(start));
+                start = 0;
+            }
+
+            // Wait for more requests (unless full) or for room to send the replies that are waiting
+            bool unsent = connection->hasUnsent();
+            if (full && !unsent) {
+                connection->waitForAnswers();
+                continue;
+            }
+            pollfd ready = {connection->fd, static_cast<short>((full ? 0 : POLLIN) | (unsent ? POLLOUT : 0)), 0};
+            if (poll(&ready, 1, kPollMillis) <= 0) continue;
+            if (ready.revents & POLLOUT) connection->flush();
+            if (full || !(ready.revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
+            ssize_t n = recv(connection->fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) break;
+            buffer.insert(buffer.end(), chunk, chunk + n);
+            received = chrono::steady_clock::now();
+        }
+        drain(*connection);
+        connection->finished = true;
+    }
+
+    const ServiceStats& getStats() const { return stats; }
+    double uptimeSeconds() const {
+        return chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    }
+
+private:
+    // The client has stopped sending; it still gets the answers to what it sent (unless it
+    // stops taking them for a while)
+    void drain(Connection& connection) {
+        auto lastProgress = chrono::steady_clock::now();
+        for (;;) {
+            size_t unsent;
+            {
+                lock_guard<mutex> lock(connection.outMutex);
+                size_t before = connection.outbox.size();
+                connection.flushLocked();
+                if (connection.broken || (connection.inFlight == 0 && connection.outbox.empty())) return;
+                unsent = connection.outbox.size();
+                if (unsent < before || unsent == 0) lastProgress = chrono::steady_clock::now();
+            }
+            if (chrono::steady_clock::now() - lastProgress > chrono::milliseconds(kDrainMillis)) return;
+            pollfd ready = {connection.fd, static_cast<short>(unsent ? POLLOUT : 0), 0};
+            poll(&ready, 1, kPollMillis);
+        }
+    }
+
+    void answer(Connection& connection, const vector<unsigned char>& body, chrono::steady_clock::time_point received) {
+        FrameReader in{body.data(), body.size()};
+        uint8_t type = in.u8();
+        uint32_t id = in.u32();
+
+        string reply;
+        reply += char(type);
+        putU32(reply, id);
+
+        if (in.ok && type == kStatsMessage) {
+            putString(reply, stats.toJson(uptimeSeconds()));
+            connection.sendReply(frame(reply));
+            return;
+        }
+
+        RouteRequest request;
+        request.source = in.str();
+        request.via = in.str();
+        request.dest = in.str();
+
+        RouteResult result;
+        RouteStatus status = kBadRequest;
+        if (in.ok && type == kRouteMessage) {
+            result = gis.findRoute(request);
+            status = result.distance >= 0 ? kOk : kNoPath;
+            if (status == kNoPath) {
+                GraphSnapshotStore::Reader graph = gis.readGraph();
+                if (!graph || graph->nodeId(request.source) < 0 || graph->nodeId(request.dest) < 0 ||
+                    (!request.via.empty() && graph->nodeId(request.via) < 0)) {
+                    status = kUnknownRoom;
+                }
+            }
+        }
+
+        // Latency covers waiting in the queue as well as the search itself
+        uint64_t nanos = static_cast<uint64_t>(
+            chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - received).count());
+        uint64_t micros = nanos / 1000;
+        reply += char(status);
+        putU32(reply, static_cast<uint32_t>(result.distance));
+        putU32(reply, static_cast<uint32_t>(min<uint64_t>(micros, 0xFFFFFFFF)));
+        size_t rooms = min<size_t>(result.path.size(), 0xFFFF);
+        putU16(reply, static_cast<uint16_t>(rooms));
+        for (size_t i = 0; i < rooms; ++i) putString(reply, result.path[i]);
+
+        connection.sendReply(frame(reply));
+        stats.record(status, nanos);
+    }
+
+    CampusGis& gis;
+    ServiceStats stats;
+    chrono::steady_clock::time_point started;
+};
+
+// ====================================================================
+// == LISTENING
+// ====================================================================
+
+int listenUnix(const string& path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) { close(fd); return -1; }
+    strcpy(address.sun_path, path.c_str());
+    unlink(path.c_str());  // Left over from an earlier run
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(fd, 64) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Only 127.0.0.1: this is a local service, not something to expose on the network
+int listenTcp(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(fd, 64) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void printUsage() {
+    fprintf(stderr, "usage: campus_routed --map FILE|--image FILE [--socket PATH | --tcp PORT] [--threads N] [--cache DIR]\n");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    string mapFile;
+    string imageFile;
+    string cacheDir;
+    string socketPath = "/tmp/campus_routed.sock";
+    int tcpPort = 0;
+    unsigned threads = 0;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--map" && hasValue) mapFile = argv[++i];
+        else if (arg == "--image" && hasValue) imageFile = argv[++i];
+        else if (arg == "--cache" && hasValue) cacheDir = argv[++i];
+        else if (arg == "--socket" && hasValue) socketPath = argv[++i];
+        else if (arg == "--tcp" && hasValue) tcpPort = atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue) threads = static_cast<unsigned>(atoi(argv[++i]));
+        else { printUsage(); return 2; }
+    }
+    if (mapFile.empty() && imageFile.empty()) { printUsage(); return 2; }
+    if (!cacheDir.empty() && !imageFile.empty()) {
+        fprintf(stderr, "campus_routed: --cache only works with --map (an image is packed already)\n");
+        return 2;
+    }
+
+    // Every request shares this one map; searches only ever read its published snapshot
+    CampusGis gis(threads);
+    gis.setCacheDirectory(cacheDir);  // Remembered routes are saved on shutdown
+    string error;
+    if (!imageFile.empty() && !gis.attachGraphImage(imageFile, &error)) {
+        fprintf(stderr, "campus_routed: could not attach %s: %s\n", imageFile.c_str(), error.c_str());
+        return 1;
+    }
+    if (imageFile.empty() && !gis.loadMapData(mapFile)) {
+        fprintf(stderr, "campus_routed: could not load map %s\n", mapFile.c_str());
+        return 1;
+    }
+
+    int listener = tcpPort > 0 ? listenTcp(tcpPort) : listenUnix(socketPath);
+    if (listener < 0) {
+        perror("campus_routed: listen");
+        return 1;
+    }
+    if (tcpPort > 0) fprintf(stderr, "campus_routed: listening on 127.0.0.1:%d\n", tcpPort);
+    else fprintf(stderr, "campus_routed: listening on %s\n", socketPath.c_str());
+    fprintf(stderr, "campus_routed: %zu worker threads\n", gis.getWorkers().size());
+
+    signal(SIGINT, onStopSignal);
+    signal(SIGTERM, onStopSignal);
+
+    RoutingService service(gis);
+    list<shared_ptr<Connection>> connections;
+
+    while (!stopRequested) {
+        // Wake up now and then to notice Ctrl+C and to clean up closed connections
+        pollfd waitFor = {listener, POLLIN, 0};
+        if (poll(&waitFor, 1, 200) > 0) {
+            int client = accept(listener, nullptr, nullptr);
+            if (client >= 0) {
+                auto connection = make_shared<Connection>(client);
+                connection->reader = thread([&service, connection]() { service.serve(connection); });
+                connections.push_back(connection);
+            }
+        }
+        for (auto it = connections.begin(); it != connections.end();) {
+            if ((*it)->finished) {
+                (*it)->reader.join();
+                it = connections.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    // Stop reading from clients, let the queued requests finish, then say goodbye
+    close(listener);
+    if (tcpPort == 0) unlink(socketPath.c_str());
+    for (auto& connection : connections) shutdown(connection->fd, SHUT_RD);
+    for (auto& connection : connections) connection->reader.join();
+    gis.shutdownWorkers();
+
+    fprintf(stderr, "campus_routed: %s\n", service.getStats().toJson(service.uptimeSeconds()).c_str());
+    return 0;
+}